@@ -0,0 +1,170 @@
+#include <Arduino.h>
+#include <Model1.h>
+#include <Video.h>
+#include <ROM.h>
+#include <Keyboard.h>
+#include <Cassette.h>
+
+// Each benchmark repeats its operation, doubling the count, until it ran at least this long
+const uint32_t BENCHMARK_MIN_US = 100000;
+const uint32_t BENCHMARK_MAX_ITERATIONS = 0x100000;
+
+// Memory used by the block benchmarks (lower 16K, always installed)
+const uint16_t BLOCK_ADDRESS = 0x4000;
+const uint16_t BLOCK_LENGTH = 256;
+const uint16_t COPY_ADDRESS = 0x4100;
+const uint16_t FILL_ADDRESS = 0x4400;
+const uint16_t FILL_LENGTH = 1024;
+
+Video video;
+ROM rom;
+Keyboard keyboard;
+Cassette cassette;
+
+uint8_t buffer[BLOCK_LENGTH];
+uint8_t pattern[4] = {0x12, 0x34, 0x56, 0x78};
+uint8_t cassetteState;
+
+typedef void (*BenchmarkFunction)();
+
+// ---------- Operations under test
+
+void benchReadMemoryByte() { buffer[0] = Model1.readMemory(BLOCK_ADDRESS); }
+void benchWriteMemoryByte() { Model1.writeMemory(BLOCK_ADDRESS, 0x55); }
+void benchReadMemoryBlock() { free(Model1.readMemory(BLOCK_ADDRESS, BLOCK_LENGTH)); }
+void benchReadMemoryInto() { Model1.readMemoryInto(BLOCK_ADDRESS, buffer, BLOCK_LENGTH); }
+void benchWriteMemoryBlock() { Model1.writeMemory(BLOCK_ADDRESS, buffer, BLOCK_LENGTH); }
+void benchWriteMemoryFrom() { Model1.writeMemoryFrom(BLOCK_ADDRESS, buffer, BLOCK_LENGTH); }
+void benchCopyMemory() { Model1.copyMemory(BLOCK_ADDRESS, COPY_ADDRESS, BLOCK_LENGTH); }
+void benchFillMemoryByte() { Model1.fillMemory(0xAA, FILL_ADDRESS, FILL_LENGTH); }
+void benchFillMemoryPattern() { Model1.fillMemory(pattern, sizeof(pattern), FILL_ADDRESS, FILL_LENGTH); }
+void benchReadIO() { buffer[0] = Model1.readIO(0xFF); }
+void benchWriteIO() { Model1.writeIO(0xFF, cassetteState); } // Rewrites the current cassette latch
+void benchVideoCls() { video.cls(); }
+void benchVideoScroll() { video.scroll(); }
+void benchVideoPrint() { video.print(0, 0, "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 ABCDEFGH"); }
+void benchROMChecksum() { rom.getChecksum(0); }
+void benchKeyboardUpdate() { keyboard.update(); }
+
+// ---------- Harness
+
+// Run one benchmark and print a CSV line: name,bytes,iterations,total_us,ns_per_op,bytes_per_second
+void runBenchmark(const __FlashStringHelper *name, uint16_t bytes, BenchmarkFunction function)
+{
+    uint32_t iterations = 1;
+    uint32_t elapsed;
+    while (true)
+    {
+        uint32_t start = micros();
+        for (uint32_t i = 0; i < iterations; i++)
+            function();
+        elapsed = micros() - start;
+
+        if (elapsed >= BENCHMARK_MIN_US || iterations >= BENCHMARK_MAX_ITERATIONS)
+            break;
+        iterations *= 2;
+    }
+    if (elapsed == 0)
+        elapsed = 1;
+
+    uint32_t nsPerOperation = (uint32_t)((uint64_t)elapsed * 1000 / iterations);
+    uint32_t bytesPerSecond = (uint32_t)((uint64_t)bytes * iterations * 1000000 / elapsed);
+
+    Serial.print(name);
+    Serial.print(',');
+    Serial.print(bytes);
+    Serial.print(',');
+    Serial.print(iterations);
+    Serial.print(',');
+    Serial.print(elapsed);
+    Serial.print(',');
+    Serial.print(nsPerOperation);
+    Serial.print(',');
+    Serial.println(bytesPerSecond);
+}
+
+// Run the block transfers with and without page mode
+// copyMemory() and pattern fills never use page mode, so they only run without it
+void runBlockBenchmarks(bool pageMode)
+{
+    if (pageMode)
+        Model1.activatePageMode();
+    else
+        Model1.deactivatePageMode();
+
+    if (pageMode)
+    {
+        runBenchmark(F("readMemory_block_paged"), BLOCK_LENGTH, benchReadMemoryBlock);
+        runBenchmark(F("readMemoryInto_paged"), BLOCK_LENGTH, benchReadMemoryInto);
+        runBenchmark(F("writeMemory_block_paged"), BLOCK_LENGTH, benchWriteMemoryBlock);
+        runBenchmark(F("writeMemoryFrom_paged"), BLOCK_LENGTH, benchWriteMemoryFrom);
+        runBenchmark(F("fillMemory_byte_paged"), FILL_LENGTH, benchFillMemoryByte);
+    }
+    else
+    {
+        runBenchmark(F("readMemory_block"), BLOCK_LENGTH, benchReadMemoryBlock);
+        runBenchmark(F("readMemoryInto"), BLOCK_LENGTH, benchReadMemoryInto);
+        runBenchmark(F("writeMemory_block"), BLOCK_LENGTH, benchWriteMemoryBlock);
+        runBenchmark(F("writeMemoryFrom"), BLOCK_LENGTH, benchWriteMemoryFrom);
+        runBenchmark(F("copyMemory"), BLOCK_LENGTH, benchCopyMemory);
+        runBenchmark(F("fillMemory_byte"), FILL_LENGTH, benchFillMemoryByte);
+        runBenchmark(F("fillMemory_pattern"), FILL_LENGTH, benchFillMemoryPattern);
+    }
+
+    Model1.deactivatePageMode();
+}
+
+// Run all benchmarks; the output is CSV with '#' comment lines
+void runAllBenchmarks()
+{
+    char *version = Model1.getVersion();
+    Serial.print(F("# TRS-80 Model 1 bus benchmark, library "));
+    Serial.print(version ? version : "?");
+    Serial.print(F(", F_CPU "));
+    Serial.println(F_CPU);
+    free(version);
+
+    Serial.println(F("name,bytes,iterations,total_us,ns_per_op,bytes_per_second"));
+
+    runBenchmark(F("readMemory_byte"), 1, benchReadMemoryByte);
+    runBenchmark(F("writeMemory_byte"), 1, benchWriteMemoryByte);
+    runBlockBenchmarks(false);
+    runBlockBenchmarks(true);
+    runBenchmark(F("readIO"), 1, benchReadIO);
+    runBenchmark(F("writeIO"), 1, benchWriteIO);
+    runBenchmark(F("Video_cls"), 1024, benchVideoCls);
+    runBenchmark(F("Video_scroll"), 1024, benchVideoScroll);
+    runBenchmark(F("Video_print"), 64, benchVideoPrint);
+    runBenchmark(F("ROM_getChecksum"), 4096, benchROMChecksum);
+    runBenchmark(F("Keyboard_update"), 8, benchKeyboardUpdate);
+
+    Serial.println(F("# done"));
+}
+
+void setup()
+{
+    // Initialize serial communication
+    Serial.begin(115200);
+    delay(1000);
+
+    // Refresh keeps running during the benchmarks, like in any real sketch
+    Model1.begin(2);
+
+    // Take control of the bus; the benchmarked RAM and the screen are overwritten
+    Model1.activateTestSignal();
+    cassetteState = cassette.getState();
+
+    runAllBenchmarks();
+
+    Model1.deactivateTestSignal();
+}
+
+// Timer interrupt for DRAM refresh
+ISR(TIMER2_COMPA_vect)
+{
+    Model1.nextUpdate();
+}
+
+void loop()
+{
+}
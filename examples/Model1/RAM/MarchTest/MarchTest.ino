@@ -0,0 +1,71 @@
+#include <Arduino.h>
+#include <Model1.h>
+#include <RAMTest.h>
+#include <SerialLogger.h>
+
+// Logger for test progress
+SerialLogger logger;
+
+// RAM test engine
+RAMTest ramTest;
+
+// Range to test: lower 16K (use 0xC000 to include an expansion interface)
+const uint16_t TEST_START = 0x4000;
+const uint16_t TEST_LENGTH = 0x4000;
+
+uint8_t lastProgress = 255;
+
+void setup()
+{
+    // Initialize serial communication
+    Serial.begin(115200);
+    delay(1000);
+
+    // Initialize Model 1 with DRAM refresh on Timer 2
+    Model1.begin(2);
+    Model1.setLogger(logger);
+    ramTest.setLogger(logger);
+
+    Serial.println(F("=== March RAM Test Example ==="));
+    Serial.println(F("WARNING: The tested RAM is overwritten"));
+    Serial.println();
+
+    // Take control of the bus for the whole test
+    Model1.activateTestSignal();
+    ramTest.begin(TEST_START, TEST_LENGTH, RAM_TEST_ALL);
+}
+
+// Timer interrupt for DRAM refresh
+ISR(TIMER2_COMPA_vect)
+{
+    Model1.nextUpdate();
+}
+
+void loop()
+{
+    // Each step only processes a small slice, so loop() stays responsive
+    if (ramTest.step())
+    {
+        uint8_t progress = ramTest.getProgress();
+        if (progress / 10 != lastProgress / 10)
+        {
+            lastProgress = progress;
+            Serial.print(ramTest.getCurrentTestName());
+            Serial.print(F(": "));
+            Serial.print(progress);
+            Serial.println('%');
+        }
+        return;
+    }
+
+    // Done: report, including the failing chip positions
+    Serial.println();
+    ramTest.printResults(Serial);
+
+    // Start over after a pause
+    Model1.deactivateTestSignal();
+    delay(10000);
+    Model1.activateTestSignal();
+    lastProgress = 255;
+    ramTest.begin(TEST_START, TEST_LENGTH, RAM_TEST_ALL);
+}
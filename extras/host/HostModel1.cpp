@@ -0,0 +1,1239 @@
+/*
+ * HostModel1.cpp - Virtual TRS-80 Model 1 behind the simulated Arduino ports
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "HostModel1.h"
+#include "port_config.h"
+
+// Port index (0 = A) of a port letter defined in port_config.h
+#define HOST_STRINGIFY(x) #x
+#define HOST_PORT_INDEX(_port) (HOST_STRINGIFY(_port)[0] - 'A')
+#define HOST_EXPAND_PORT_INDEX(_port) HOST_PORT_INDEX(_port)
+#define HOST_PIN(_signal) {HOST_EXPAND_PORT_INDEX(PIN_##_signal##_PORT), PIN_##_signal##_ON}
+
+// Bus ports
+#define HOST_ADDR_LOW_PORT HOST_EXPAND_PORT_INDEX(BUS_ADDR_LOW_PORT)
+#define HOST_ADDR_HIGH_PORT HOST_EXPAND_PORT_INDEX(BUS_ADDR_HIGH_PORT)
+#define HOST_DATA_PORT HOST_EXPAND_PORT_INDEX(BUS_DATA_PORT)
+
+// Cassette port bits
+#define HOST_CASSETTE_PORT 0xFF
+#define HOST_CASSETTE_MODESEL_INV 0x08 // Written, set for 32 character mode
+#define HOST_CASSETTE_MODESEL 0x40     // Read, set in 64 character mode
+#define HOST_CASSETTE_INPUT 0x80       // Read
+
+// Timers running on the simulated clock
+#define HOST_TIMER_1 0
+#define HOST_TIMER_2 1
+#define HOST_TIMER_5 2
+
+// Longest time slice between interrupt checks while interrupts are enabled
+#define HOST_INTERRUPT_SLICE 32
+
+// No bus request or BUSACK* within a Z80 trial
+#define HOST_Z80_NONE 0xFFFF
+
+// Interrupt acknowledge cycle in half T-states: INT_ACK* (M1* and IORQ*) goes low
+// in the first wait state, the vector is read at the start of T3
+#define HOST_Z80_ACK_LOW_HALF_STATES 5
+#define HOST_Z80_ACK_SAMPLE_HALF_STATES 8
+
+// Location of a signal on the Arduino ports
+struct HostPin
+{
+    uint8_t port; // Port index (0 = A)
+    uint8_t mask; // Bit within the port
+};
+
+static const HostPin signalPins[HOST_SIGNAL_COUNT] = {
+    HOST_PIN(RAS), HOST_PIN(CAS), HOST_PIN(MUX), HOST_PIN(RD), HOST_PIN(WR),
+    HOST_PIN(IN), HOST_PIN(OUT), HOST_PIN(INT), HOST_PIN(TEST), HOST_PIN(WAIT)};
+
+static const HostPin systemResetPin = HOST_PIN(SYS_RES);
+static const HostPin interruptAcknowledgePin = HOST_PIN(INT_ACK);
+
+static const char *const signalNames[HOST_SIGNAL_COUNT] = {
+    "RAS", "CAS", "MUX", "RD", "WR", "IN", "OUT", "INT", "TEST", "WAIT"};
+
+// Part of a Z80 bus cycle, in half T-states from its start, in which TEST* cuts
+// it off on a board without the TEST* mod: the Arduino side of the buffers takes
+// over after the Z80 put out its strobes and before the data was transferred
+struct HostZ80Window
+{
+    uint8_t from;   // First harmful half T-state
+    uint8_t to;     // First harmless half T-state after the window
+    uint8_t length; // Length of the cycle
+};
+
+static const HostZ80Window z80Windows[] = {
+    {1, 4, 8},  // Fetch: MREQ*/RD* from T1, data read at the start of T3
+    {1, 5, 6},  // Memory read: MREQ*/RD* from T1, data read in the middle of T3
+    {3, 5, 6},  // Memory write: WR* from T2, data written until the middle of T3
+    {3, 7, 8},  // Input: IORQ*/RD* from T2 to the middle of T3
+    {3, 7, 8}}; // Output: IORQ*/WR* from T2 to the middle of T3
+
+// Forwards the bus cycles of the Z80 core to the virtual machine
+class HostZ80Adapter : public HostZ80Bus
+{
+public:
+    uint8_t z80Read(HostZ80Cycle cycle, uint16_t address, uint16_t tState) override
+    {
+        return HostModel1._z80Read(cycle, address, tState);
+    }
+
+    void z80Write(HostZ80Cycle cycle, uint16_t address, uint8_t data, uint16_t tState) override
+    {
+        HostModel1._z80Write(cycle, address, data, tState);
+    }
+};
+
+static HostZ80Adapter z80Adapter;
+
+// Define global instance
+HostModel1Class HostModel1;
+
+// ----------------------------------------
+// ---------- Power
+// ----------------------------------------
+
+// Initialize on first use; all members are constant-initialized so that
+// library constructors running before main() can already touch the ports
+void HostModel1Class::_powerOn()
+{
+    _powered = true;
+    memset(_rom, 0xFF, sizeof(_rom));
+    memset(_ioInput, 0xFF, sizeof(_ioInput));
+    for (uint8_t i = 0; i < HOST_SIGNAL_COUNT; i++)
+        _levels[i] = _readSignal((HostSignal)i);
+}
+
+// Power-cycle the machine
+void HostModel1Class::reset()
+{
+    delete[] _events;
+    *this = HostModel1Class();
+    SREG = (1 << SREG_I);
+    _powerOn();
+}
+
+// ----------------------------------------
+// ---------- Configuration
+// ----------------------------------------
+
+// Installed DRAM above 0x4000
+void HostModel1Class::setRAMSize(uint32_t size)
+{
+    if (!_powered)
+        _powerOn();
+    _dramSize = (size > sizeof(_dram)) ? sizeof(_dram) : size;
+}
+
+// Store bit 6 in video RAM
+void HostModel1Class::setLowerCaseMod(bool hasLowerCaseMod)
+{
+    _lowerCaseMod = hasLowerCaseMod;
+}
+
+// Copy a ROM image to 0x0000
+bool HostModel1Class::loadROM(const uint8_t *data, uint16_t length)
+{
+    if (!_powered)
+        _powerOn();
+    if (!data || length > HOST_ROM_SIZE)
+        return false;
+    memcpy(_rom, data, length);
+    return true;
+}
+
+// Load a ROM image from a file
+bool HostModel1Class::loadROMFile(const char *path)
+{
+    if (!_powered)
+        _powerOn();
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    size_t length = fread(_rom, 1, HOST_ROM_SIZE, file);
+    fclose(file);
+    return length > 0;
+}
+
+// ----------------------------------------
+// ---------- Memory and IO
+// ----------------------------------------
+
+// Memory as seen by a bus read
+uint8_t HostModel1Class::_readMemory(uint16_t address)
+{
+    if (address < HOST_ROM_SIZE)
+        return _rom[address];
+
+    if (address < HOST_KEYBOARD_START)
+        return 0xFF; // Unused and expansion interface
+
+    if (address < HOST_VIDEO_START)
+    {
+        // Each address bit selects a row; selected rows are combined
+        uint8_t result = 0;
+        for (uint8_t row = 0; row < 8; row++)
+        {
+            if (address & (1 << row))
+                result |= _keyboard[row];
+        }
+        return result;
+    }
+
+    if (address < HOST_DRAM_START)
+    {
+        uint8_t data = _video[address - HOST_VIDEO_START];
+        if (!_lowerCaseMod)
+        {
+            // Bit 6 is not stored; it reads as NOR of bits 5 and 7
+            data &= ~0x40;
+            if (!(data & 0xA0))
+                data |= 0x40;
+        }
+        return data;
+    }
+
+    uint16_t offset = address - HOST_DRAM_START;
+    return (offset < _dramSize) ? _dram[offset] : 0xFF;
+}
+
+// Memory as changed by a bus write
+void HostModel1Class::_writeMemory(uint16_t address, uint8_t data)
+{
+    if (address < HOST_VIDEO_START)
+        return; // ROM, unused and keyboard
+
+    if (address < HOST_DRAM_START)
+    {
+        _video[address - HOST_VIDEO_START] = _lowerCaseMod ? data : (data & ~0x40);
+        return;
+    }
+
+    uint16_t offset = address - HOST_DRAM_START;
+    if (offset < _dramSize)
+        _dram[offset] = data;
+}
+
+// IO read
+uint8_t HostModel1Class::_readIO(uint8_t port)
+{
+    if (port != HOST_CASSETTE_PORT)
+        return _ioInput[port];
+
+    uint8_t data = 0x3F;
+    if (is64CharacterMode())
+        data |= HOST_CASSETTE_MODESEL;
+    if (_cassetteInput)
+        data |= HOST_CASSETTE_INPUT;
+    return data;
+}
+
+// IO write
+void HostModel1Class::_writeIO(uint8_t port, uint8_t data)
+{
+    _ioLatch[port] = data;
+}
+
+// Storage behind a writable address, nullptr for ROM, keyboard and missing DRAM
+uint8_t *HostModel1Class::_getMemoryCell(uint16_t address)
+{
+    if (address < HOST_VIDEO_START)
+        return nullptr;
+
+    if (address < HOST_DRAM_START)
+        return &_video[address - HOST_VIDEO_START];
+
+    uint16_t offset = address - HOST_DRAM_START;
+    return (offset < _dramSize) ? &_dram[offset] : nullptr;
+}
+
+// Read memory without a bus cycle
+uint8_t HostModel1Class::peek(uint16_t address)
+{
+    if (!_powered)
+        _powerOn();
+    return _readMemory(address);
+}
+
+// Write memory without a bus cycle; unlike the bus, this also changes the ROM
+void HostModel1Class::poke(uint16_t address, uint8_t data)
+{
+    if (!_powered)
+        _powerOn();
+    if (address < HOST_ROM_SIZE)
+        _rom[address] = data;
+    else
+        _writeMemory(address, data);
+}
+
+// Last value written to an IO port
+uint8_t HostModel1Class::getIOLatch(uint8_t port)
+{
+    return _ioLatch[port];
+}
+
+// Value returned by reads of an IO port
+void HostModel1Class::setIOInput(uint8_t port, uint8_t data)
+{
+    if (!_powered)
+        _powerOn();
+    _ioInput[port] = data;
+}
+
+// ----------------------------------------
+// ---------- Keyboard, Cassette and Signals
+// ----------------------------------------
+
+// Press a key of the matrix
+void HostModel1Class::pressKey(uint8_t row, uint8_t column)
+{
+    if (row < 8 && column < 8)
+        _keyboard[row] |= (1 << column);
+}
+
+// Release a key of the matrix
+void HostModel1Class::releaseKey(uint8_t row, uint8_t column)
+{
+    if (row < 8 && column < 8)
+        _keyboard[row] &= ~(1 << column);
+}
+
+// Release all keys
+void HostModel1Class::releaseAllKeys()
+{
+    memset(_keyboard, 0, sizeof(_keyboard));
+}
+
+// Cassette input bit
+void HostModel1Class::setCassetteInput(bool value)
+{
+    _cassetteInput = value;
+}
+
+// Video mode selected through port 0xFF
+bool HostModel1Class::is64CharacterMode()
+{
+    return !(_ioLatch[HOST_CASSETTE_PORT] & HOST_CASSETTE_MODESEL_INV);
+}
+
+// Assert/release SYS_RES*
+void HostModel1Class::setSystemReset(bool active)
+{
+    _systemReset = active;
+}
+
+// Assert/release INT_ACK*
+void HostModel1Class::setInterruptAcknowledge(bool active)
+{
+    _interruptAcknowledge = active;
+}
+
+// Current level of a signal driven by the Arduino
+uint8_t HostModel1Class::getSignal(HostSignal signal)
+{
+    return (signal < HOST_SIGNAL_COUNT) ? _levels[signal] : HIGH;
+}
+
+// ----------------------------------------
+// ---------- Bus Decoding
+// ----------------------------------------
+
+// Level of a signal; released pins are pulled high by the board
+uint8_t HostModel1Class::_readSignal(HostSignal signal)
+{
+    const HostPin &pin = signalPins[signal];
+    if (!(_ddr[pin.port] & pin.mask))
+        return HIGH;
+    return (_port[pin.port] & pin.mask) ? HIGH : LOW;
+}
+
+// Value on the address bus; released lines read high
+uint16_t HostModel1Class::_getAddress()
+{
+    uint8_t low = (_port[HOST_ADDR_LOW_PORT] & _ddr[HOST_ADDR_LOW_PORT]) | ~_ddr[HOST_ADDR_LOW_PORT];
+    uint8_t high = (_port[HOST_ADDR_HIGH_PORT] & _ddr[HOST_ADDR_HIGH_PORT]) | ~_ddr[HOST_ADDR_HIGH_PORT];
+    return ((uint16_t)high << 8) | low;
+}
+
+// Value the Arduino drives on the data bus
+uint8_t HostModel1Class::_getDataOut()
+{
+    return (_port[HOST_DATA_PORT] & _ddr[HOST_DATA_PORT]) | ~_ddr[HOST_DATA_PORT];
+}
+
+// Value of a PINx register: driven bits read back, the data bus and system signals come from the machine
+uint8_t HostModel1Class::_getPinInput(uint8_t port)
+{
+    uint8_t input = 0xFF;
+
+    if (port == HOST_DATA_PORT && _levels[HOST_SIGNAL_CAS] == LOW && _arduinoOwnsBus())
+    {
+        if (_levels[HOST_SIGNAL_IN] == LOW)
+            input = _readIO(_getAddress() & 0xFF);
+        else if (_levels[HOST_SIGNAL_RD] == LOW)
+            input = _readMemory(_getAddress());
+    }
+
+    if (port == systemResetPin.port && _systemReset)
+        input &= ~systemResetPin.mask;
+    if (port == interruptAcknowledgePin.port && _interruptAcknowledge)
+        input &= ~interruptAcknowledgePin.mask;
+
+    return (_port[port] & _ddr[port]) | (input & ~_ddr[port]);
+}
+
+// Detect and handle signal edges after a port change
+void HostModel1Class::_updateSignals()
+{
+    for (uint8_t i = 0; i < HOST_SIGNAL_COUNT; i++)
+    {
+        uint8_t level = _readSignal((HostSignal)i);
+        if (level == _levels[i])
+            continue;
+        _levels[i] = level;
+
+        if (_recording && _eventCount < _eventCapacity)
+        {
+            HostSignalEvent &event = _events[_eventCount++];
+            event.cycle = _cycles;
+            event.signal = i;
+            event.level = level;
+            event.address = _getAddress();
+            event.data = _getDataOut();
+        }
+
+        _handleEdge((HostSignal)i, level);
+    }
+}
+
+// React to a single edge
+void HostModel1Class::_handleEdge(HostSignal signal, uint8_t level)
+{
+    uint16_t address = _getAddress();
+
+    switch (signal)
+    {
+    case HOST_SIGNAL_RAS:
+        if (level == LOW)
+        {
+            // Latch the row; any RAS cycle refreshes it
+            _rasRow = address & (HOST_DRAM_ROWS - 1);
+            _casStrobes = 0;
+            _touchRow(_rasRow);
+        }
+        else if (_casStrobes == 0)
+        {
+            _statistics.refreshes++;
+        }
+        break;
+
+    case HOST_SIGNAL_CAS:
+        if (level == HIGH)
+            break;
+
+        if (_levels[HOST_SIGNAL_TEST] == HIGH)
+            _statistics.accessesWithoutTest++;
+
+        if (!_arduinoOwnsBus())
+        {
+            _z80Statistics.lostAccesses++;
+            break;
+        }
+
+        if (_levels[HOST_SIGNAL_OUT] == LOW)
+        {
+            _statistics.ioWrites++;
+            _writeIO(address & 0xFF, _getDataOut());
+            break;
+        }
+        if (_levels[HOST_SIGNAL_IN] == LOW)
+        {
+            _statistics.ioReads++;
+            break;
+        }
+        if (_levels[HOST_SIGNAL_WR] == LOW)
+        {
+            _statistics.memoryWrites++;
+            _writeMemory(address, _getDataOut());
+        }
+        else if (_levels[HOST_SIGNAL_RD] == LOW)
+        {
+            _statistics.memoryReads++;
+        }
+
+        if (_levels[HOST_SIGNAL_RAS] == LOW)
+        {
+            if (address >= HOST_DRAM_START && (address & (HOST_DRAM_ROWS - 1)) != _rasRow)
+                _statistics.rowMismatches++;
+            if (_casStrobes > 0)
+                _statistics.pageModeStrobes++;
+            _casStrobes++;
+        }
+        break;
+
+    case HOST_SIGNAL_TEST:
+        if (level == LOW)
+        {
+            // The Z80 kept all rows refreshed until now
+            for (uint8_t row = 0; row < HOST_DRAM_ROWS; row++)
+                _lastRowAccess[row] = _cycles;
+        }
+        else
+        {
+            // Close the gaps of rows not refreshed since
+            for (uint8_t row = 0; row < HOST_DRAM_ROWS; row++)
+            {
+                uint64_t gap = _cycles - _lastRowAccess[row];
+                if (gap > _statistics.maxRefreshGap)
+                    _statistics.maxRefreshGap = gap;
+            }
+        }
+        _setBusRequest(level == LOW);
+        break;
+
+    case HOST_SIGNAL_INT:
+        if (level == LOW)
+            _interruptRequestCycle = _cycles;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Mark a DRAM row as refreshed, tracking the longest gap while the Arduino owns the bus
+void HostModel1Class::_touchRow(uint8_t row)
+{
+    if (_levels[HOST_SIGNAL_TEST] != LOW)
+        return;
+
+    uint64_t gap = _cycles - _lastRowAccess[row];
+    if (gap > _statistics.maxRefreshGap)
+        _statistics.maxRefreshGap = gap;
+    _lastRowAccess[row] = _cycles;
+}
+
+// ----------------------------------------
+// ---------- Z80
+// ----------------------------------------
+
+// Run the Z80 from reset at the current cycle, or stop it where it is
+void HostModel1Class::enableZ80(bool enable)
+{
+    if (!_powered)
+        _powerOn();
+
+    if (enable && !_z80Enabled)
+    {
+        _z80Enabled = true;
+        resetZ80();
+        return;
+    }
+
+    _runZ80();
+    _z80Enabled = enable;
+    if (!enable)
+        _interruptAcknowledge = false;
+}
+
+// Check if the Z80 runs
+bool HostModel1Class::hasZ80()
+{
+    return _z80Enabled;
+}
+
+// Reset the Z80; a TEST* already asserted is a bus request right away
+void HostModel1Class::resetZ80()
+{
+    _z80.setBus(&z80Adapter);
+    _z80.reset();
+    _z80Origin = _cycles;
+    _z80Elapsed = 0;
+    _z80Retry = 0;
+    _busRequested = false;
+    _busAcknowledged = false;
+    _acknowledging = false;
+    _interruptAcknowledge = false;
+    _deferredWriteCount = 0;
+
+    if (_levels[HOST_SIGNAL_TEST] == LOW)
+        _setBusRequest(true);
+}
+
+// BUSACK* gates the bus buffers, so the Arduino only reaches the bus once the Z80 let go
+void HostModel1Class::setTestMod(bool installed)
+{
+    _testMod = installed;
+}
+
+// CPU core with its registers; change them only between instructions
+HostZ80 &HostModel1Class::getZ80()
+{
+    return _z80;
+}
+
+// BUSACK* asserted by the Z80
+bool HostModel1Class::isBusAcknowledged()
+{
+    _runZ80();
+    return _busAcknowledged;
+}
+
+// Z80 counters since the last reset
+HostZ80Statistics HostModel1Class::getZ80Statistics()
+{
+    _runZ80();
+    return _z80Statistics;
+}
+
+// Cycle of a half T-state counted from the end of the last committed instruction
+uint64_t HostModel1Class::_getZ80Time(uint32_t halfStates)
+{
+    return _z80Origin + ((2 * _z80Elapsed + halfStates) * F_CPU) / (2 * HOST_Z80_CLOCK);
+}
+
+// Run the Z80 up to the current cycle; WAIT* holds it at the next instruction
+void HostModel1Class::_runZ80()
+{
+    if (!_z80Enabled)
+        return;
+
+    _updateInterruptAcknowledge();
+    while (!_busAcknowledged && _cycles >= _z80Retry && _getZ80Time(0) <= _cycles)
+    {
+        if (_levels[HOST_SIGNAL_WAIT] == LOW)
+        {
+            _z80Origin = _cycles + 1;
+            _z80Elapsed = 0;
+            break;
+        }
+        if (!_stepZ80())
+            break;
+    }
+    _updateInterruptAcknowledge();
+}
+
+// Execute the next instruction or interrupt as a trial and keep it once the
+// part before BUSACK* (or all of it) lies in the past; otherwise undo it and
+// retry later, so a TEST* edge in between still lands in the right bus cycle
+bool HostModel1Class::_stepZ80()
+{
+    uint64_t start = _getZ80Time(0);
+
+    // A bus request from before the instruction is granted right away
+    if (_busRequested && _busRequestCycle <= start)
+    {
+        _acknowledgeBus(start, 0);
+        return true;
+    }
+
+    // INT* is sampled at the end of the previous instruction
+    if (!_acknowledging && _levels[HOST_SIGNAL_INT] == LOW && _interruptRequestCycle <= start && _z80.acceptsInterrupt())
+    {
+        _acknowledging = true;
+        _vectorRead = false;
+    }
+
+    if (_acknowledging && !_vectorRead)
+    {
+        uint64_t sample = _getZ80Time(HOST_Z80_ACK_SAMPLE_HALF_STATES);
+        if (_cycles < sample)
+        {
+            _z80Retry = sample;
+            return false;
+        }
+
+        _vector = _getDataOut();
+        _vectorRead = true;
+        _z80Statistics.lastVector = _vector;
+        _z80Statistics.lastInterruptDelay = sample - _interruptRequestCycle;
+        if (_z80Statistics.lastInterruptDelay > _z80Statistics.maxInterruptDelay)
+            _z80Statistics.maxInterruptDelay = _z80Statistics.lastInterruptDelay;
+    }
+
+    HostZ80 saved = _z80;
+    _trialWriteCount = 0;
+    _trialCorrupted = 0;
+    _trialAck = HOST_Z80_NONE;
+    _trialRequest = HOST_Z80_NONE;
+    if (_busRequested)
+    {
+        uint64_t halfStates = (_busRequestCycle - _z80Origin) * 2 * HOST_Z80_CLOCK / F_CPU - 2 * _z80Elapsed;
+        _trialRequest = halfStates < HOST_Z80_NONE ? halfStates : HOST_Z80_NONE - 1;
+    }
+
+    uint16_t tStates = _acknowledging ? _z80.interrupt(_vector) : _z80.step();
+
+    // A request during the internal cycles at the end is granted with the next instruction
+    if (_trialRequest != HOST_Z80_NONE && _trialAck == HOST_Z80_NONE && _trialRequest < 2 * tStates)
+        _trialAck = tStates;
+
+    uint64_t due = _getZ80Time(2 * (_trialAck != HOST_Z80_NONE ? _trialAck : tStates));
+    if (due > _cycles)
+    {
+        _undoWrites(0);
+        _z80 = saved;
+        _z80Retry = due;
+        return false;
+    }
+
+    _z80Statistics.tStates += tStates;
+    _z80Statistics.corruptedCycles += _trialCorrupted;
+    if (_acknowledging)
+    {
+        _acknowledging = false;
+        _z80Statistics.interrupts++;
+    }
+    else
+    {
+        _z80Statistics.instructions++;
+    }
+
+    if (_trialAck == HOST_Z80_NONE)
+    {
+        _z80Elapsed += tStates;
+        return true;
+    }
+
+    // Writes after BUSACK* reach the bus once TEST* is released
+    uint8_t first = 0;
+    while (first < _trialWriteCount && !_trialWrites[first].deferred)
+        first++;
+    _deferredWriteCount = _trialWriteCount - first;
+    memcpy(_deferredWrites, _trialWrites + first, _deferredWriteCount * sizeof(HostZ80Write));
+    _undoWrites(first);
+
+    _z80Elapsed += _trialAck;
+    _acknowledgeBus(due, tStates - _trialAck);
+    return true;
+}
+
+// Undo the writes of the trial from an index on, newest first
+void HostModel1Class::_undoWrites(uint8_t from)
+{
+    while (_trialWriteCount > from)
+    {
+        const HostZ80Write &write = _trialWrites[--_trialWriteCount];
+        if (write.io)
+        {
+            _ioLatch[write.address & 0xFF] = write.previous;
+        }
+        else
+        {
+            uint8_t *cell = _getMemoryCell(write.address);
+            if (cell)
+                *cell = write.previous;
+        }
+    }
+}
+
+// TEST* drives BUSREQ*; releasing it lets the Z80 finish its instruction one T-state later
+void HostModel1Class::_setBusRequest(bool active)
+{
+    if (!_z80Enabled)
+        return;
+
+    _z80Retry = 0;
+    if (active)
+    {
+        _busRequested = true;
+        _busRequestCycle = _cycles;
+        return;
+    }
+
+    _busRequested = false; // Released before BUSACK*: the request is dropped
+    if (!_busAcknowledged)
+        return;
+
+    _busAcknowledged = false;
+    for (uint8_t i = 0; i < _deferredWriteCount; i++)
+    {
+        const HostZ80Write &write = _deferredWrites[i];
+        if (write.io)
+            _writeIO(write.address & 0xFF, write.data);
+        else
+            _writeMemory(write.address, write.data);
+    }
+    _deferredWriteCount = 0;
+
+    _z80Origin = _cycles;
+    _z80Elapsed = 1 + _z80Remaining;
+}
+
+// The Z80 floats its bus and asserts BUSACK*
+void HostModel1Class::_acknowledgeBus(uint64_t cycle, uint16_t remaining)
+{
+    _busRequested = false;
+    _busAcknowledged = true;
+    _z80Remaining = remaining;
+
+    _z80Statistics.busRequests++;
+    _z80Statistics.lastBusAckDelay = cycle - _busRequestCycle;
+    if (_z80Statistics.lastBusAckDelay > _z80Statistics.maxBusAckDelay)
+        _z80Statistics.maxBusAckDelay = _z80Statistics.lastBusAckDelay;
+}
+
+// INT_ACK* from the first wait state of the acknowledge cycle until the vector was read
+void HostModel1Class::_updateInterruptAcknowledge()
+{
+    _interruptAcknowledge = _acknowledging && !_vectorRead && _cycles >= _getZ80Time(HOST_Z80_ACK_LOW_HALF_STATES);
+}
+
+// Without the TEST* mod the buffers follow TEST* directly; with it they wait for BUSACK*
+bool HostModel1Class::_arduinoOwnsBus()
+{
+    if (!_z80Enabled)
+        return true;
+    if (_levels[HOST_SIGNAL_TEST] == HIGH)
+        return false;
+    return !_testMod || _busAcknowledged;
+}
+
+// Find BUSACK* within the trial: at the end of the bus cycle the request falls
+// into, or before this cycle if it fell into internal T-states. Returns true
+// when TEST* cut the cycle off on a board without the mod
+bool HostModel1Class::_z80BusCycle(HostZ80Cycle cycle, uint16_t tState)
+{
+    if (_trialRequest == HOST_Z80_NONE || _trialAck != HOST_Z80_NONE)
+        return false;
+
+    const HostZ80Window &window = z80Windows[cycle];
+    uint32_t start = 2 * (uint32_t)tState;
+    if (_trialRequest < start)
+    {
+        _trialAck = tState;
+        return false;
+    }
+    if (_trialRequest >= start + window.length)
+        return false;
+
+    _trialAck = tState + window.length / 2;
+    if (_testMod || _trialRequest < start + window.from || _trialRequest >= start + window.to)
+        return false;
+
+    _trialCorrupted++;
+    return true;
+}
+
+// Z80 fetch, memory read or IO read; a cut off cycle reads the floating bus
+uint8_t HostModel1Class::_z80Read(HostZ80Cycle cycle, uint16_t address, uint16_t tState)
+{
+    if (_z80BusCycle(cycle, tState))
+        return 0xFF;
+    if (cycle == HOST_Z80_INPUT)
+        return _readIO(address & 0xFF);
+    return _readMemory(address);
+}
+
+// Z80 memory or IO write, remembered so the trial can be undone; a cut off cycle is lost
+void HostModel1Class::_z80Write(HostZ80Cycle cycle, uint16_t address, uint8_t data, uint16_t tState)
+{
+    if (_z80BusCycle(cycle, tState) || _trialWriteCount >= HOST_Z80_MAX_WRITES)
+        return;
+
+    HostZ80Write &write = _trialWrites[_trialWriteCount++];
+    write.address = address;
+    write.data = data;
+    write.io = (cycle == HOST_Z80_OUTPUT);
+    write.deferred = (_trialAck != HOST_Z80_NONE && tState >= _trialAck);
+
+    if (write.io)
+    {
+        write.previous = _ioLatch[address & 0xFF];
+        _writeIO(address & 0xFF, data);
+    }
+    else
+    {
+        uint8_t *cell = _getMemoryCell(address);
+        write.previous = cell ? *cell : 0;
+        _writeMemory(address, data);
+    }
+}
+
+// ----------------------------------------
+// ---------- Time and Timers
+// ----------------------------------------
+
+// Simulated CPU cycles since power on
+uint64_t HostModel1Class::getCycles()
+{
+    return _cycles;
+}
+
+// Let cycles pass; while interrupts are enabled time is sliced so ISRs fire on schedule
+void HostModel1Class::advance(uint64_t cycles)
+{
+    if (!_powered)
+        _powerOn();
+
+    while (cycles > 0)
+    {
+        uint32_t slice = (!_inInterrupt && (SREG & (1 << SREG_I)) && cycles > HOST_INTERRUPT_SLICE) ? HOST_INTERRUPT_SLICE : (cycles > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)cycles);
+        _cycles += slice;
+        cycles -= slice;
+        _runTimers(slice);
+        _runZ80();
+        _dispatchInterrupts();
+    }
+}
+
+// Call the ISRs that became pending while interrupts were disabled
+void HostModel1Class::takeInterrupts()
+{
+    if (_powered)
+        _dispatchInterrupts();
+}
+
+// Count one timer; returns true when it reached its top value
+static bool countTimer(uint32_t &count, uint32_t top, uint32_t ticks)
+{
+    if (count > top)
+    {
+        // Top moved below the counter: run to the end of the range first
+        count = (count + ticks) & 0xFFFF;
+        return false;
+    }
+
+    uint32_t distance = top - count + 1;
+    if (ticks < distance)
+    {
+        count += ticks;
+        return false;
+    }
+    count = (ticks - distance) % (top + 1);
+    return true;
+}
+
+// Let timers 1, 2 and 5 count on the simulated clock
+void HostModel1Class::_runTimers(uint32_t cycles)
+{
+    static const uint16_t prescalers16[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+    static const uint16_t prescalers8[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+    for (uint8_t timer = 0; timer < 3; timer++)
+    {
+        uint8_t controlA, controlB, flags;
+        bool ctc;
+        uint16_t prescaler;
+        uint32_t count, top, max;
+
+        if (timer == HOST_TIMER_2)
+        {
+            controlA = _timerRegisters[HOST_TCCR2A];
+            controlB = _timerRegisters[HOST_TCCR2B];
+            flags = HOST_TIFR2;
+            prescaler = prescalers8[controlB & 0x07];
+            ctc = controlA & (1 << WGM21);
+            count = _timerRegisters[HOST_TCNT2];
+            top = _timerRegisters[HOST_OCR2A];
+            max = 0xFF;
+        }
+        else
+        {
+            bool isTimer1 = (timer == HOST_TIMER_1);
+            controlB = _timerRegisters[isTimer1 ? HOST_TCCR1B : HOST_TCCR5B];
+            flags = isTimer1 ? HOST_TIFR1 : HOST_TIFR5;
+            prescaler = prescalers16[controlB & 0x07];
+            ctc = controlB & (1 << WGM12);
+            count = isTimer1 ? _timer1Count : _timer5Count;
+            top = isTimer1 ? _timer1Compare : _timer5Compare;
+            max = 0xFFFF;
+        }
+
+        if (prescaler == 0)
+            continue;
+
+        uint64_t total = (uint64_t)_prescaleRemainder[timer] + cycles;
+        uint32_t ticks = total / prescaler;
+        _prescaleRemainder[timer] = total % prescaler;
+        if (ticks == 0)
+            continue;
+
+        if (countTimer(count, ctc ? top : max, ticks))
+            _timerRegisters[flags] |= ctc ? (1 << OCF1A) : (1 << TOV1);
+
+        if (timer == HOST_TIMER_2)
+            _timerRegisters[HOST_TCNT2] = count;
+        else if (timer == HOST_TIMER_1)
+            _timer1Count = count;
+        else
+            _timer5Count = count;
+    }
+}
+
+// Call the ISR of each pending and enabled timer interrupt
+void HostModel1Class::_dispatchInterrupts()
+{
+    struct Vector
+    {
+        uint8_t mask;
+        uint8_t flags;
+        uint8_t bit;
+        void (*handler)(void);
+    };
+    const Vector vectors[3] = {
+        {HOST_TIMSK1, HOST_TIFR1, OCF1A, TIMER1_COMPA_vect},
+        {HOST_TIMSK2, HOST_TIFR2, OCF2A, TIMER2_COMPA_vect},
+        {HOST_TIMSK5, HOST_TIFR5, TOV5, TIMER5_OVF_vect}};
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (_inInterrupt || !(SREG & (1 << SREG_I)))
+            return;
+
+        const Vector &vector = vectors[i];
+        uint8_t bit = 1 << vector.bit;
+        if (!(_timerRegisters[vector.mask] & bit) || !(_timerRegisters[vector.flags] & bit))
+            continue;
+
+        // Entering the ISR clears the flag and disables interrupts
+        _timerRegisters[vector.flags] &= ~bit;
+        _inInterrupt = true;
+        uint8_t oldSREG = SREG;
+        SREG &= (uint8_t)~(1 << SREG_I);
+        advance(HOST_ISR_CYCLES);
+        if (vector.handler)
+            vector.handler();
+        SREG = oldSREG;
+        _inInterrupt = false;
+    }
+}
+
+// ----------------------------------------
+// ---------- Registers
+// ----------------------------------------
+
+// Read a register of the virtual Arduino
+uint8_t HostModel1Class::readRegister(uint8_t id)
+{
+    if (!_powered)
+        _powerOn();
+    _runZ80();
+
+    uint8_t value = 0;
+    if (id < HOST_PORT_COUNT * 3)
+    {
+        uint8_t port = id / 3;
+        switch (id % 3)
+        {
+        case HOST_REGISTER_DDR:
+            value = _ddr[port];
+            break;
+        case HOST_REGISTER_PORT:
+            value = _port[port];
+            break;
+        default:
+            value = _getPinInput(port);
+            break;
+        }
+    }
+    else if (id < HOST_REGISTER_COUNT)
+    {
+        value = _timerRegisters[id];
+    }
+
+    advance(HOST_REGISTER_READ_CYCLES);
+    return value;
+}
+
+// Write a register of the virtual Arduino
+void HostModel1Class::writeRegister(uint8_t id, uint8_t value)
+{
+    if (!_powered)
+        _powerOn();
+    _runZ80(); // The Z80 sees the old levels up to now
+
+    if (id < HOST_PORT_COUNT * 3)
+    {
+        uint8_t port = id / 3;
+        switch (id % 3)
+        {
+        case HOST_REGISTER_DDR:
+            _ddr[port] = value;
+            break;
+        case HOST_REGISTER_PORT:
+            _port[port] = value;
+            break;
+        default:
+            _port[port] ^= value; // Writing PINx toggles PORTx
+            break;
+        }
+        _updateSignals();
+    }
+    else if (id == HOST_TIFR1 || id == HOST_TIFR2 || id == HOST_TIFR5)
+    {
+        _timerRegisters[id] &= ~value; // Flags are cleared by writing a one
+    }
+    else if (id < HOST_REGISTER_COUNT)
+    {
+        _timerRegisters[id] = value;
+    }
+
+    advance(HOST_REGISTER_WRITE_CYCLES);
+}
+
+// Read a 16-bit timer register
+uint16_t HostModel1Class::readRegister16(uint8_t id)
+{
+    if (!_powered)
+        _powerOn();
+
+    uint16_t value = 0;
+    switch (id)
+    {
+    case HOST_TCNT1:
+        value = _timer1Count;
+        break;
+    case HOST_OCR1A:
+        value = _timer1Compare;
+        break;
+    case HOST_TCNT5:
+        value = _timer5Count;
+        break;
+    case HOST_OCR5A:
+        value = _timer5Compare;
+        break;
+    }
+
+    advance(2 * HOST_REGISTER_READ_CYCLES);
+    return value;
+}
+
+// Write a 16-bit timer register
+void HostModel1Class::writeRegister16(uint8_t id, uint16_t value)
+{
+    if (!_powered)
+        _powerOn();
+
+    switch (id)
+    {
+    case HOST_TCNT1:
+        _timer1Count = value;
+        break;
+    case HOST_OCR1A:
+        _timer1Compare = value;
+        break;
+    case HOST_TCNT5:
+        _timer5Count = value;
+        break;
+    case HOST_OCR5A:
+        _timer5Compare = value;
+        break;
+    }
+
+    advance(2 * HOST_REGISTER_WRITE_CYCLES);
+}
+
+// ----------------------------------------
+// ---------- Statistics
+// ----------------------------------------
+
+// Counters since the last reset, including rows still waiting for a refresh
+HostBusStatistics HostModel1Class::getStatistics()
+{
+    HostBusStatistics statistics = _statistics;
+    if (_levels[HOST_SIGNAL_TEST] == LOW)
+    {
+        for (uint8_t row = 0; row < HOST_DRAM_ROWS; row++)
+        {
+            uint64_t gap = _cycles - _lastRowAccess[row];
+            if (gap > statistics.maxRefreshGap)
+                statistics.maxRefreshGap = gap;
+        }
+    }
+    return statistics;
+}
+
+// Clear the counters
+void HostModel1Class::resetStatistics()
+{
+    memset(&_statistics, 0, sizeof(_statistics));
+    memset(&_z80Statistics, 0, sizeof(_z80Statistics));
+    for (uint8_t row = 0; row < HOST_DRAM_ROWS; row++)
+        _lastRowAccess[row] = _cycles;
+}
+
+// Print the counters
+void HostModel1Class::printStatistics(Print &output)
+{
+    HostBusStatistics statistics = getStatistics();
+    output.printf("Memory reads:          %lu\n", (unsigned long)statistics.memoryReads);
+    output.printf("Memory writes:         %lu\n", (unsigned long)statistics.memoryWrites);
+    output.printf("IO reads:              %lu\n", (unsigned long)statistics.ioReads);
+    output.printf("IO writes:             %lu\n", (unsigned long)statistics.ioWrites);
+    output.printf("Refresh cycles:        %lu\n", (unsigned long)statistics.refreshes);
+    output.printf("Page mode strobes:     %lu\n", (unsigned long)statistics.pageModeStrobes);
+    output.printf("Row mismatches:        %lu\n", (unsigned long)statistics.rowMismatches);
+    output.printf("Accesses without TEST: %lu\n", (unsigned long)statistics.accessesWithoutTest);
+    output.printf("Max refresh gap:       %lu us\n", (unsigned long)(statistics.maxRefreshGap / (F_CPU / 1000000UL)));
+
+    if (!_z80Enabled)
+        return;
+
+    HostZ80Statistics z80 = getZ80Statistics();
+    output.printf("Z80 instructions:      %lu\n", (unsigned long)z80.instructions);
+    output.printf("Z80 bus requests:      %lu\n", (unsigned long)z80.busRequests);
+    output.printf("Max BUSACK delay:      %lu ns\n", (unsigned long)(z80.maxBusAckDelay * 1000000000ULL / F_CPU));
+    output.printf("Corrupted Z80 cycles:  %lu\n", (unsigned long)z80.corruptedCycles);
+    output.printf("Lost Arduino accesses: %lu\n", (unsigned long)z80.lostAccesses);
+    output.printf("Z80 interrupts:        %lu\n", (unsigned long)z80.interrupts);
+    output.printf("Max interrupt delay:   %lu ns\n", (unsigned long)(z80.maxInterruptDelay * 1000000000ULL / F_CPU));
+}
+
+// ----------------------------------------
+// ---------- Recording
+// ----------------------------------------
+
+// Record signal edges into a new buffer; recording stops when it is full
+void HostModel1Class::startRecording(size_t maxEvents)
+{
+    delete[] _events;
+    _events = new HostSignalEvent[maxEvents];
+    _eventCapacity = maxEvents;
+    _eventCount = 0;
+    _recording = true;
+}
+
+// Stop recording, keeping the events
+void HostModel1Class::stopRecording()
+{
+    _recording = false;
+}
+
+// Number of recorded edges
+size_t HostModel1Class::getEventCount()
+{
+    return _eventCount;
+}
+
+// A recorded edge
+const HostSignalEvent &HostModel1Class::getEvent(size_t index)
+{
+    return _events[index < _eventCount ? index : _eventCount - 1];
+}
+
+// Name of a signal
+const char *HostModel1Class::getSignalName(uint8_t signal)
+{
+    return (signal < HOST_SIGNAL_COUNT) ? signalNames[signal] : "?";
+}
+
+// Print all recorded edges, one per line
+void HostModel1Class::printRecording(Print &output)
+{
+    uint64_t start = _eventCount > 0 ? _events[0].cycle : 0;
+    for (size_t i = 0; i < _eventCount; i++)
+    {
+        const HostSignalEvent &event = _events[i];
+        output.printf("%8lu ns  %-4s %s  addr=0x%04X data=0x%02X\n",
+                      (unsigned long)((event.cycle - start) * 1000000000ULL / F_CPU),
+                      getSignalName(event.signal),
+                      event.level == LOW ? "LOW " : "HIGH",
+                      event.address, event.data);
+    }
+}
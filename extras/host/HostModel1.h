@@ -0,0 +1,284 @@
+/*
+ * HostModel1.h - Virtual TRS-80 Model 1 behind the simulated Arduino ports
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * The virtual machine sits behind the port registers of the host Arduino core.
+ * It watches RAS, CAS, MUX, RD, WR, IN, OUT and TEST the way the Model 1 board
+ * does and answers with:
+ *
+ * - ROM at 0x0000-0x2FFF (load an image with loadROM()/loadROMFile())
+ * - Keyboard matrix at 0x3800-0x3BFF (pressKey()/releaseKey())
+ * - Video RAM at 0x3C00-0x3FFF (7 bits without the lowercase mod)
+ * - DRAM from 0x4000 (16K, 32K or 48K)
+ * - Cassette/mode port 0xFF and a latch for every other IO port
+ *
+ * Every signal edge can be recorded with a cycle time stamp, and statistics
+ * count bus cycles, refreshes, page mode strobes and timing violations.
+ *
+ * The clock is simulated: each port write costs 2 CPU cycles, each read 1,
+ * and busDelay()/delay() add their cycles. Timers 1, 2 and 5 run on that clock
+ * and call the sketch's ISR() handlers while interrupts are enabled.
+ *
+ * Optionally a Z80 (HostZ80) runs on the same clock at 1.77408 MHz. It gives
+ * up the bus on TEST* with BUSACK*, answers INT* with an acknowledge cycle that
+ * reads the vector from the data bus, and models the board with and without
+ * the TEST* mod (BUSACK* gating the bus buffers).
+ */
+
+#ifndef HOST_MODEL1_H
+#define HOST_MODEL1_H
+
+#include <Arduino.h>
+#include "HostZ80.h"
+
+// Memory map
+#define HOST_ROM_SIZE 0x3000
+#define HOST_KEYBOARD_START 0x3800
+#define HOST_VIDEO_START 0x3C00
+#define HOST_VIDEO_SIZE 0x0400
+#define HOST_DRAM_START 0x4000
+#define HOST_DRAM_ROWS 128
+
+// Simulated cost of register accesses in CPU cycles
+#define HOST_REGISTER_WRITE_CYCLES 2
+#define HOST_REGISTER_READ_CYCLES 1
+
+// Cycles of interrupt entry and exit
+#define HOST_ISR_CYCLES 20
+
+// Z80 writes of one instruction kept for undo
+#define HOST_Z80_MAX_WRITES 8
+
+// Signals driven by the Arduino
+enum HostSignal
+{
+    HOST_SIGNAL_RAS,
+    HOST_SIGNAL_CAS,
+    HOST_SIGNAL_MUX,
+    HOST_SIGNAL_RD,
+    HOST_SIGNAL_WR,
+    HOST_SIGNAL_IN,
+    HOST_SIGNAL_OUT,
+    HOST_SIGNAL_INT,
+    HOST_SIGNAL_TEST,
+    HOST_SIGNAL_WAIT,
+    HOST_SIGNAL_COUNT
+};
+
+// Recorded signal edge
+struct HostSignalEvent
+{
+    uint64_t cycle;   // CPU cycle of the edge
+    uint8_t signal;   // HostSignal that changed
+    uint8_t level;    // New level (HIGH/LOW)
+    uint16_t address; // Address bus at the time
+    uint8_t data;     // Data bus at the time
+};
+
+// Bus statistics
+struct HostBusStatistics
+{
+    uint32_t memoryReads;         // CAS strobes with RD active
+    uint32_t memoryWrites;        // CAS strobes with WR active
+    uint32_t ioReads;             // CAS strobes with IN active
+    uint32_t ioWrites;            // CAS strobes with OUT active
+    uint32_t refreshes;           // RAS cycles without CAS (RAS-only refresh)
+    uint32_t pageModeStrobes;     // Additional CAS strobes within one RAS cycle
+    uint32_t rowMismatches;       // DRAM CAS strobes outside the row latched by RAS
+    uint32_t accessesWithoutTest; // Bus cycles while TEST* was inactive
+    uint64_t maxRefreshGap;       // Longest time a DRAM row went without RAS (cycles, while TEST* is active)
+};
+
+// Z80 statistics
+struct HostZ80Statistics
+{
+    uint32_t instructions;       // Instructions executed, HALT cycles included
+    uint64_t tStates;            // T-states executed
+    uint32_t busRequests;        // TEST* assertions answered with BUSACK*
+    uint64_t lastBusAckDelay;    // Cycles from TEST* low to BUSACK* low, last request
+    uint64_t maxBusAckDelay;     // Cycles from TEST* low to BUSACK* low, longest
+    uint32_t corruptedCycles;    // Z80 bus cycles cut off by TEST* (board without the TEST* mod)
+    uint32_t lostAccesses;       // Arduino bus cycles that did not reach the machine
+    uint32_t interrupts;         // Interrupts accepted
+    uint64_t lastInterruptDelay; // Cycles from INT* low to the vector being read, last interrupt
+    uint64_t maxInterruptDelay;  // Cycles from INT* low to the vector being read, longest
+    uint8_t lastVector;          // Byte read during the last interrupt acknowledge
+};
+
+// Z80 write that can be undone
+struct HostZ80Write
+{
+    uint16_t address; // Memory address or IO port
+    uint8_t data;     // Value written
+    uint8_t previous; // Value before the write
+    bool io;          // IO write
+    bool deferred;    // Bus cycle after BUSACK*, replayed when TEST* is released
+};
+
+class HostModel1Class
+{
+    friend class HostZ80Adapter;
+
+private:
+    bool _powered = false; // Set once reset() initialized the machine
+
+    // ---------- Arduino side
+    uint8_t _ddr[HOST_PORT_COUNT] = {};                // DDRx
+    uint8_t _port[HOST_PORT_COUNT] = {};               // PORTx
+    uint8_t _timerRegisters[HOST_REGISTER_COUNT] = {}; // Timer registers (indexed by register number)
+    uint16_t _timer1Count = 0;                         // TCNT1
+    uint16_t _timer1Compare = 0;                       // OCR1A
+    uint16_t _timer5Count = 0;                         // TCNT5
+    uint16_t _timer5Compare = 0;                       // OCR5A
+    uint32_t _prescaleRemainder[3] = {};               // Cycles not yet counted by timers 1, 2 and 5
+    uint64_t _cycles = 0;                              // Simulated CPU cycles since power on
+    bool _inInterrupt = false;                         // Set while an ISR runs
+
+    // ---------- Machine side
+    uint8_t _rom[HOST_ROM_SIZE] = {};
+    uint8_t _video[HOST_VIDEO_SIZE] = {};
+    uint8_t _dram[0x10000 - HOST_DRAM_START] = {};
+    uint32_t _dramSize = 0xC000;        // Installed DRAM
+    bool _lowerCaseMod = false;         // Video RAM stores bit 6
+    uint8_t _keyboard[8] = {};          // Pressed keys per row
+    uint8_t _ioLatch[256] = {};         // Last value written per IO port
+    uint8_t _ioInput[256] = {};         // Value read per IO port (except 0xFF)
+    bool _cassetteInput = false;        // Cassette input bit of port 0xFF
+    bool _systemReset = false;          // SYS_RES* asserted by the machine
+    bool _interruptAcknowledge = false; // INT_ACK* asserted by the machine
+
+    // ---------- Bus decoding
+    uint8_t _levels[HOST_SIGNAL_COUNT] = {};      // Current signal levels
+    uint8_t _rasRow = 0;                          // Row latched by the last RAS
+    uint8_t _casStrobes = 0;                      // CAS strobes during the current RAS cycle
+    uint64_t _lastRowAccess[HOST_DRAM_ROWS] = {}; // Cycle each row was last refreshed/accessed
+    HostBusStatistics _statistics = {};
+
+    // ---------- Recording
+    HostSignalEvent *_events = nullptr; // Recorded edges
+    size_t _eventCapacity = 0;          // Size of the recording buffer
+    size_t _eventCount = 0;             // Number of recorded edges
+    bool _recording = false;            // Set while recording
+
+    // ---------- Z80
+    HostZ80 _z80;                                           // CPU core
+    bool _z80Enabled = false;                               // Z80 runs on the simulated clock
+    bool _testMod = false;                                  // BUSACK* gates the bus buffers
+    uint64_t _z80Origin = 0;                                // Cycle the Z80 clock was last started
+    uint64_t _z80Elapsed = 0;                               // T-states since the origin
+    uint64_t _z80Retry = 0;                                 // The pending instruction cannot complete before this cycle
+    bool _busRequested = false;                             // TEST* low, not acknowledged yet
+    uint64_t _busRequestCycle = 0;                          // Cycle TEST* went low
+    bool _busAcknowledged = false;                          // BUSACK* low, Z80 off the bus
+    uint16_t _z80Remaining = 0;                             // T-states of the instruction left at BUSACK*
+    uint64_t _interruptRequestCycle = 0;                    // Cycle INT* went low
+    bool _acknowledging = false;                            // Interrupt acknowledge cycle running
+    bool _vectorRead = false;                               // Vector of the acknowledge cycle was read
+    uint8_t _vector = 0xFF;                                 // Vector of the acknowledge cycle
+    uint16_t _trialRequest = 0;                             // Half T-state of a bus request within the trial
+    uint16_t _trialAck = 0;                                 // T-state of BUSACK* within the trial
+    uint8_t _trialCorrupted = 0;                            // Bus cycles cut off during the trial
+    HostZ80Write _trialWrites[HOST_Z80_MAX_WRITES] = {};    // Writes of the trial
+    uint8_t _trialWriteCount = 0;                           // Number of writes of the trial
+    HostZ80Write _deferredWrites[HOST_Z80_MAX_WRITES] = {}; // Writes waiting for TEST* to be released
+    uint8_t _deferredWriteCount = 0;                        // Number of deferred writes
+    HostZ80Statistics _z80Statistics = {};
+
+    void _powerOn();                                    // Initialize on first use
+    uint8_t _readSignal(HostSignal signal);             // Level of a signal as driven by the Arduino
+    uint16_t _getAddress();                             // Value on the address bus
+    uint8_t _getDataOut();                              // Value the Arduino drives on the data bus
+    uint8_t _getPinInput(uint8_t port);                 // Value of a PINx register
+    void _updateSignals();                              // Detect and handle signal edges after a port change
+    void _handleEdge(HostSignal signal, uint8_t level); // React to a single edge
+    void _touchRow(uint8_t row);                        // Mark a DRAM row as refreshed
+    void _runTimers(uint32_t cycles);                   // Let timers count
+    void _dispatchInterrupts();                         // Call pending ISRs
+
+    uint8_t _readMemory(uint16_t address);             // Memory as seen by a bus read
+    void _writeMemory(uint16_t address, uint8_t data); // Memory as changed by a bus write
+    uint8_t _readIO(uint8_t port);                     // IO read
+    void _writeIO(uint8_t port, uint8_t data);         // IO write
+    uint8_t *_getMemoryCell(uint16_t address);         // Storage of a writable address, nullptr if none
+
+    void _runZ80();                                                                      // Run the Z80 up to the current cycle
+    bool _stepZ80();                                                                     // Execute and commit one instruction or interrupt
+    void _undoWrites(uint8_t from);                                                      // Undo the trial writes from an index on
+    uint64_t _getZ80Time(uint32_t halfStates);                                           // Cycle of a half T-state after the last committed instruction
+    void _setBusRequest(bool active);                                                    // TEST* edge as seen by BUSREQ*
+    void _acknowledgeBus(uint64_t cycle, uint16_t remaining);                            // Z80 gives up the bus
+    void _updateInterruptAcknowledge();                                                  // INT_ACK* during the acknowledge cycle
+    bool _arduinoOwnsBus();                                                              // Arduino bus cycles reach the machine
+    bool _z80BusCycle(HostZ80Cycle cycle, uint16_t tState);                              // Bus request timing of a Z80 bus cycle
+    uint8_t _z80Read(HostZ80Cycle cycle, uint16_t address, uint16_t tState);             // Z80 fetch, read or input
+    void _z80Write(HostZ80Cycle cycle, uint16_t address, uint8_t data, uint16_t tState); // Z80 write or output
+
+public:
+    void reset(); // Power-cycle: clear memory, keyboard, IO, signals, clock and statistics
+
+    // ---------- Configuration
+    void setRAMSize(uint32_t size);                     // Installed DRAM: 0x4000, 0x8000 or 0xC000
+    void setLowerCaseMod(bool hasLowerCaseMod);         // Store bit 6 in video RAM
+    bool loadROM(const uint8_t *data, uint16_t length); // Copy a ROM image to 0x0000
+    bool loadROMFile(const char *path);                 // Load a ROM image from a file
+
+    // ---------- Direct access (bypasses the bus)
+    uint8_t peek(uint16_t address);              // Read memory without a bus cycle
+    void poke(uint16_t address, uint8_t data);   // Write memory without a bus cycle (ROM included)
+    uint8_t getIOLatch(uint8_t port);            // Last value written to an IO port
+    void setIOInput(uint8_t port, uint8_t data); // Value returned by reads of an IO port (not 0xFF)
+
+    // ---------- Keyboard
+    void pressKey(uint8_t row, uint8_t column);   // Press a key of the matrix
+    void releaseKey(uint8_t row, uint8_t column); // Release a key of the matrix
+    void releaseAllKeys();                        // Release all keys
+
+    // ---------- Cassette and video mode
+    void setCassetteInput(bool value); // Cassette input bit (bit 7 of port 0xFF)
+    bool is64CharacterMode();          // Video mode selected through port 0xFF
+
+    // ---------- Control signals from the machine
+    void setSystemReset(bool active);          // Assert/release SYS_RES*
+    void setInterruptAcknowledge(bool active); // Assert/release INT_ACK*
+    uint8_t getSignal(HostSignal signal);      // Current level of a signal driven by the Arduino
+
+    // ---------- Z80
+    void enableZ80(bool enable = true);   // Run the Z80 from reset, or stop it
+    bool hasZ80();                        // Check if the Z80 runs
+    void resetZ80();                      // Reset the Z80 at the current cycle
+    void setTestMod(bool installed);      // BUSACK* gates the bus buffers
+    HostZ80 &getZ80();                    // CPU core with its registers
+    bool isBusAcknowledged();             // BUSACK* asserted by the Z80
+    HostZ80Statistics getZ80Statistics(); // Z80 counters since the last reset
+
+    // ---------- Time
+    uint64_t getCycles();          // Simulated CPU cycles since power on
+    void advance(uint64_t cycles); // Let cycles pass, running timers and interrupts
+    void takeInterrupts();         // Call the ISRs that are pending, if interrupts are enabled
+
+    // ---------- Statistics
+    HostBusStatistics getStatistics();   // Counters since the last reset
+    void resetStatistics();              // Clear the counters
+    void printStatistics(Print &output); // Print the counters
+
+    // ---------- Recording
+    void startRecording(size_t maxEvents = 100000);   // Record signal edges into a new buffer
+    void stopRecording();                             // Stop recording, keeping the events
+    size_t getEventCount();                           // Number of recorded edges
+    const HostSignalEvent &getEvent(size_t index);    // A recorded edge
+    static const char *getSignalName(uint8_t signal); // Name of a signal
+    void printRecording(Print &output);               // Print all recorded edges
+
+    // ---------- Register access of the host Arduino core
+    uint8_t readRegister(uint8_t id);
+    void writeRegister(uint8_t id, uint8_t value);
+    uint16_t readRegister16(uint8_t id);
+    void writeRegister16(uint8_t id, uint16_t value);
+};
+
+extern HostModel1Class HostModel1;
+
+#endif // HOST_MODEL1_H
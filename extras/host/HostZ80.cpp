@@ -0,0 +1,1206 @@
+/*
+ * HostZ80.cpp - Z80 CPU core for the virtual Model 1
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "HostZ80.h"
+
+// Flag bits of F
+#define Z80_FLAG_C 0x01
+#define Z80_FLAG_N 0x02
+#define Z80_FLAG_PV 0x04
+#define Z80_FLAG_X 0x08
+#define Z80_FLAG_H 0x10
+#define Z80_FLAG_Y 0x20
+#define Z80_FLAG_Z 0x40
+#define Z80_FLAG_S 0x80
+#define Z80_FLAG_SXY (Z80_FLAG_S | Z80_FLAG_X | Z80_FLAG_Y)
+
+// Receiver of all bus cycles
+void HostZ80::setBus(HostZ80Bus *bus)
+{
+    _bus = bus;
+}
+
+// Power-on reset; AF and SP come up as 0xFFFF on most parts
+void HostZ80::reset()
+{
+    registers = {};
+    registers.af = 0xFFFF;
+    registers.sp = 0xFFFF;
+    _halted = false;
+    _afterEI = false;
+    _index = 0;
+}
+
+// Execute one instruction; while halted the CPU runs NOP cycles at PC
+uint16_t HostZ80::step()
+{
+    _t = 0;
+    _index = 0;
+    _afterEI = false;
+
+    if (_halted)
+    {
+        _bus->z80Read(HOST_Z80_FETCH, registers.pc, _t);
+        _t += 4;
+        registers.r = (registers.r & 0x80) | ((registers.r + 1) & 0x7F);
+        return _t;
+    }
+
+    _execute(_fetch());
+    return _t;
+}
+
+// Maskable interrupt; the acknowledge cycle has two wait states
+uint16_t HostZ80::interrupt(uint8_t data)
+{
+    _t = 0;
+    _index = 0;
+    _afterEI = false;
+    _halted = false;
+    registers.iff1 = false;
+    registers.iff2 = false;
+    registers.r = (registers.r & 0x80) | ((registers.r + 1) & 0x7F);
+
+    switch (registers.im)
+    {
+    case 0:
+        // The byte on the bus is executed, usually RST
+        _t = 6;
+        _execute(data);
+        break;
+
+    case 1:
+        _t = 7;
+        _push(registers.pc);
+        registers.pc = 0x0038;
+        break;
+
+    default:
+    {
+        _t = 7;
+        _push(registers.pc);
+        uint16_t table = ((uint16_t)registers.i << 8) | data;
+        uint8_t low = _read(table);
+        registers.pc = ((uint16_t)_read(table + 1) << 8) | low;
+        break;
+    }
+    }
+
+    return _t;
+}
+
+// Interrupts enabled and the last instruction was not EI
+bool HostZ80::acceptsInterrupt()
+{
+    return registers.iff1 && !_afterEI;
+}
+
+// Waiting for an interrupt after HALT
+bool HostZ80::isHalted()
+{
+    return _halted;
+}
+
+// ----------------------------------------
+// ---------- Bus Cycles
+// ----------------------------------------
+
+// M1 cycle at PC, incrementing the lower 7 bits of R
+uint8_t HostZ80::_fetch()
+{
+    uint8_t data = _bus->z80Read(HOST_Z80_FETCH, registers.pc++, _t);
+    _t += 4;
+    registers.r = (registers.r & 0x80) | ((registers.r + 1) & 0x7F);
+    return data;
+}
+
+// Memory read cycle
+uint8_t HostZ80::_read(uint16_t address)
+{
+    uint8_t data = _bus->z80Read(HOST_Z80_READ, address, _t);
+    _t += 3;
+    return data;
+}
+
+// Memory write cycle
+void HostZ80::_write(uint16_t address, uint8_t data)
+{
+    _bus->z80Write(HOST_Z80_WRITE, address, data, _t);
+    _t += 3;
+}
+
+// Read the byte at PC
+uint8_t HostZ80::_next()
+{
+    return _read(registers.pc++);
+}
+
+// Read the word at PC, low byte first
+uint16_t HostZ80::_next16()
+{
+    uint8_t low = _next();
+    return ((uint16_t)_next() << 8) | low;
+}
+
+// IO read cycle, including the automatic wait state
+uint8_t HostZ80::_input(uint16_t port)
+{
+    uint8_t data = _bus->z80Read(HOST_Z80_INPUT, port, _t);
+    _t += 4;
+    return data;
+}
+
+// IO write cycle, including the automatic wait state
+void HostZ80::_output(uint16_t port, uint8_t data)
+{
+    _bus->z80Write(HOST_Z80_OUTPUT, port, data, _t);
+    _t += 4;
+}
+
+// Push a word, high byte first
+void HostZ80::_push(uint16_t value)
+{
+    _write(--registers.sp, value >> 8);
+    _write(--registers.sp, value & 0xFF);
+}
+
+// Pop a word
+uint16_t HostZ80::_pop()
+{
+    uint8_t low = _read(registers.sp++);
+    return ((uint16_t)_read(registers.sp++) << 8) | low;
+}
+
+// ----------------------------------------
+// ---------- Registers
+// ----------------------------------------
+
+// HL, IX or IY depending on the prefix
+uint16_t &HostZ80::_hl()
+{
+    if (_index == 1)
+        return registers.ix;
+    if (_index == 2)
+        return registers.iy;
+    return registers.hl;
+}
+
+// (HL), or (IX+d)/(IY+d) reading the displacement and adding the internal T-states
+uint16_t HostZ80::_indexedAddress(uint8_t extra)
+{
+    if (!_index)
+        return registers.hl;
+
+    int8_t displacement = (int8_t)_next();
+    _t += extra;
+    return _hl() + displacement;
+}
+
+// B, C, D, E, H, L, -, A; H and L become IXH/IXL or IYH/IYL after a prefix
+uint8_t HostZ80::_getRegister(uint8_t r)
+{
+    switch (r)
+    {
+    case 0:
+        return registers.bc >> 8;
+    case 1:
+        return registers.bc & 0xFF;
+    case 2:
+        return registers.de >> 8;
+    case 3:
+        return registers.de & 0xFF;
+    case 4:
+        return _hl() >> 8;
+    case 5:
+        return _hl() & 0xFF;
+    case 7:
+        return _getA();
+    default:
+        return 0xFF;
+    }
+}
+
+// Set B, C, D, E, H, L or A; H and L become IXH/IXL or IYH/IYL after a prefix
+void HostZ80::_setRegister(uint8_t r, uint8_t v)
+{
+    switch (r)
+    {
+    case 0:
+        registers.bc = (registers.bc & 0x00FF) | ((uint16_t)v << 8);
+        break;
+    case 1:
+        registers.bc = (registers.bc & 0xFF00) | v;
+        break;
+    case 2:
+        registers.de = (registers.de & 0x00FF) | ((uint16_t)v << 8);
+        break;
+    case 3:
+        registers.de = (registers.de & 0xFF00) | v;
+        break;
+    case 4:
+        _hl() = (_hl() & 0x00FF) | ((uint16_t)v << 8);
+        break;
+    case 5:
+        _hl() = (_hl() & 0xFF00) | v;
+        break;
+    case 7:
+        _setA(v);
+        break;
+    default:
+        break;
+    }
+}
+
+// Register of instructions that also use (IX+d), where H and L stay H and L
+uint8_t HostZ80::_getPlainRegister(uint8_t r)
+{
+    uint8_t index = _index;
+    _index = 0;
+    uint8_t v = _getRegister(r);
+    _index = index;
+    return v;
+}
+
+// Set a register of instructions that also use (IX+d)
+void HostZ80::_setPlainRegister(uint8_t r, uint8_t v)
+{
+    uint8_t index = _index;
+    _index = 0;
+    _setRegister(r, v);
+    _index = index;
+}
+
+// BC, DE, HL/IX/IY, SP
+uint16_t HostZ80::_getPair(uint8_t p)
+{
+    switch (p)
+    {
+    case 0:
+        return registers.bc;
+    case 1:
+        return registers.de;
+    case 2:
+        return _hl();
+    default:
+        return registers.sp;
+    }
+}
+
+// Set BC, DE, HL/IX/IY or SP
+void HostZ80::_setPair(uint8_t p, uint16_t v)
+{
+    switch (p)
+    {
+    case 0:
+        registers.bc = v;
+        break;
+    case 1:
+        registers.de = v;
+        break;
+    case 2:
+        _hl() = v;
+        break;
+    default:
+        registers.sp = v;
+        break;
+    }
+}
+
+// BC, DE, HL/IX/IY, AF as used by PUSH and POP
+uint16_t HostZ80::_getPair2(uint8_t p)
+{
+    return p == 3 ? registers.af : _getPair(p);
+}
+
+// Set BC, DE, HL/IX/IY or AF
+void HostZ80::_setPair2(uint8_t p, uint16_t v)
+{
+    if (p == 3)
+        registers.af = v;
+    else
+        _setPair(p, v);
+}
+
+// NZ, Z, NC, C, PO, PE, P, M
+bool HostZ80::_condition(uint8_t c)
+{
+    static const uint8_t masks[4] = {Z80_FLAG_Z, Z80_FLAG_C, Z80_FLAG_PV, Z80_FLAG_S};
+    bool set = _getF() & masks[c >> 1];
+    return (c & 1) ? set : !set;
+}
+
+uint8_t HostZ80::_getA()
+{
+    return registers.af >> 8;
+}
+
+void HostZ80::_setA(uint8_t v)
+{
+    registers.af = (registers.af & 0x00FF) | ((uint16_t)v << 8);
+}
+
+uint8_t HostZ80::_getF()
+{
+    return registers.af & 0xFF;
+}
+
+void HostZ80::_setF(uint8_t v)
+{
+    registers.af = (registers.af & 0xFF00) | v;
+}
+
+// ----------------------------------------
+// ---------- Arithmetic
+// ----------------------------------------
+
+// S, Z, X, Y and even parity of a result
+uint8_t HostZ80::_sziFlags(uint8_t v)
+{
+    uint8_t flags = v & Z80_FLAG_SXY;
+    if (v == 0)
+        flags |= Z80_FLAG_Z;
+    if (!__builtin_parity(v))
+        flags |= Z80_FLAG_PV;
+    return flags;
+}
+
+// ADD, ADC, SUB, SBC, AND, XOR, OR, CP with the accumulator
+void HostZ80::_alu(uint8_t op, uint8_t v)
+{
+    uint8_t a = _getA();
+    uint8_t carry = (op == 1 || op == 3) ? (_getF() & Z80_FLAG_C) : 0;
+    uint16_t result;
+    uint8_t flags;
+
+    switch (op)
+    {
+    case 0: // ADD
+    case 1: // ADC
+        result = a + v + carry;
+        flags = ((a ^ v ^ result) & Z80_FLAG_H) | (result > 0xFF ? Z80_FLAG_C : 0);
+        if ((a ^ ~v) & (a ^ result) & 0x80)
+            flags |= Z80_FLAG_PV;
+        break;
+
+    case 4: // AND
+        result = a & v;
+        flags = Z80_FLAG_H;
+        break;
+
+    case 5: // XOR
+        result = a ^ v;
+        flags = 0;
+        break;
+
+    case 6: // OR
+        result = a | v;
+        flags = 0;
+        break;
+
+    default: // SUB, SBC, CP
+        result = a - v - carry;
+        flags = Z80_FLAG_N | ((a ^ v ^ result) & Z80_FLAG_H) | ((result & 0x100) ? Z80_FLAG_C : 0);
+        if ((a ^ v) & (a ^ result) & 0x80)
+            flags |= Z80_FLAG_PV;
+        break;
+    }
+
+    uint8_t value = result & 0xFF;
+    if (op >= 4 && op <= 6)
+    {
+        _setF(flags | _sziFlags(value));
+        _setA(value);
+        return;
+    }
+
+    flags |= value & Z80_FLAG_S;
+    if (value == 0)
+        flags |= Z80_FLAG_Z;
+
+    if (op == 7)
+    {
+        // CP takes X and Y from the operand and keeps A
+        _setF(flags | (v & (Z80_FLAG_X | Z80_FLAG_Y)));
+        return;
+    }
+
+    _setF(flags | (value & (Z80_FLAG_X | Z80_FLAG_Y)));
+    _setA(value);
+}
+
+// INC with flags; carry is kept
+uint8_t HostZ80::_inc(uint8_t v)
+{
+    uint8_t result = v + 1;
+    uint8_t flags = (_getF() & Z80_FLAG_C) | (result & Z80_FLAG_SXY);
+    if (result == 0)
+        flags |= Z80_FLAG_Z;
+    if ((v & 0x0F) == 0x0F)
+        flags |= Z80_FLAG_H;
+    if (v == 0x7F)
+        flags |= Z80_FLAG_PV;
+    _setF(flags);
+    return result;
+}
+
+// DEC with flags; carry is kept
+uint8_t HostZ80::_dec(uint8_t v)
+{
+    uint8_t result = v - 1;
+    uint8_t flags = (_getF() & Z80_FLAG_C) | Z80_FLAG_N | (result & Z80_FLAG_SXY);
+    if (result == 0)
+        flags |= Z80_FLAG_Z;
+    if ((v & 0x0F) == 0)
+        flags |= Z80_FLAG_H;
+    if (v == 0x80)
+        flags |= Z80_FLAG_PV;
+    _setF(flags);
+    return result;
+}
+
+// RLC, RRC, RL, RR, SLA, SRA, SLL, SRL
+uint8_t HostZ80::_rotate(uint8_t op, uint8_t v)
+{
+    uint8_t carry = _getF() & Z80_FLAG_C;
+    uint8_t result, out;
+
+    switch (op)
+    {
+    case 0: // RLC
+        out = v >> 7;
+        result = (v << 1) | out;
+        break;
+    case 1: // RRC
+        out = v & 1;
+        result = (v >> 1) | (out << 7);
+        break;
+    case 2: // RL
+        out = v >> 7;
+        result = (v << 1) | carry;
+        break;
+    case 3: // RR
+        out = v & 1;
+        result = (v >> 1) | (carry << 7);
+        break;
+    case 4: // SLA
+        out = v >> 7;
+        result = v << 1;
+        break;
+    case 5: // SRA
+        out = v & 1;
+        result = (v >> 1) | (v & 0x80);
+        break;
+    case 6: // SLL (undocumented, shifts in a one)
+        out = v >> 7;
+        result = (v << 1) | 1;
+        break;
+    default: // SRL
+        out = v & 1;
+        result = v >> 1;
+        break;
+    }
+
+    _setF(_sziFlags(result) | out);
+    return result;
+}
+
+// BIT; X and Y come from the operand
+void HostZ80::_bit(uint8_t bit, uint8_t v)
+{
+    uint8_t flags = (_getF() & Z80_FLAG_C) | Z80_FLAG_H | (v & (Z80_FLAG_X | Z80_FLAG_Y));
+    if (!(v & (1 << bit)))
+        flags |= Z80_FLAG_Z | Z80_FLAG_PV;
+    if (bit == 7 && (v & 0x80))
+        flags |= Z80_FLAG_S;
+    _setF(flags);
+}
+
+// ADD HL/IX/IY,rp; S, Z and P/V are kept
+void HostZ80::_addHL(uint16_t v)
+{
+    uint16_t hl = _hl();
+    uint32_t result = (uint32_t)hl + v;
+    uint8_t flags = (_getF() & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_PV)) |
+                    (((hl ^ v ^ result) >> 8) & Z80_FLAG_H) |
+                    ((result >> 8) & (Z80_FLAG_X | Z80_FLAG_Y)) |
+                    (result > 0xFFFF ? Z80_FLAG_C : 0);
+    _setF(flags);
+    _hl() = result;
+    _t += 7;
+}
+
+// ADC HL,rp
+void HostZ80::_adcHL(uint16_t v)
+{
+    uint16_t hl = registers.hl;
+    uint32_t result = (uint32_t)hl + v + (_getF() & Z80_FLAG_C);
+    uint8_t flags = ((result >> 8) & Z80_FLAG_SXY) |
+                    (((hl ^ v ^ result) >> 8) & Z80_FLAG_H) |
+                    (result > 0xFFFF ? Z80_FLAG_C : 0);
+    if ((result & 0xFFFF) == 0)
+        flags |= Z80_FLAG_Z;
+    if ((hl ^ ~v) & (hl ^ result) & 0x8000)
+        flags |= Z80_FLAG_PV;
+    _setF(flags);
+    registers.hl = result;
+    _t += 7;
+}
+
+// SBC HL,rp
+void HostZ80::_sbcHL(uint16_t v)
+{
+    uint16_t hl = registers.hl;
+    uint32_t result = (uint32_t)hl - v - (_getF() & Z80_FLAG_C);
+    uint8_t flags = Z80_FLAG_N | ((result >> 8) & Z80_FLAG_SXY) |
+                    (((hl ^ v ^ result) >> 8) & Z80_FLAG_H) |
+                    ((result & 0x10000) ? Z80_FLAG_C : 0);
+    if ((result & 0xFFFF) == 0)
+        flags |= Z80_FLAG_Z;
+    if ((hl ^ v) & (hl ^ result) & 0x8000)
+        flags |= Z80_FLAG_PV;
+    _setF(flags);
+    registers.hl = result;
+    _t += 7;
+}
+
+// Decimal adjust after BCD addition or subtraction
+void HostZ80::_daa()
+{
+    uint8_t a = _getA();
+    uint8_t flags = _getF();
+    uint8_t correction = 0;
+    bool carry = flags & Z80_FLAG_C;
+    bool halfCarry;
+
+    if ((flags & Z80_FLAG_H) || (a & 0x0F) > 9)
+        correction |= 0x06;
+    if (carry || a > 0x99)
+    {
+        correction |= 0x60;
+        carry = true;
+    }
+
+    uint8_t result;
+    if (flags & Z80_FLAG_N)
+    {
+        halfCarry = (flags & Z80_FLAG_H) && (a & 0x0F) < 6;
+        result = a - correction;
+    }
+    else
+    {
+        halfCarry = (a & 0x0F) > 9;
+        result = a + correction;
+    }
+
+    _setF(_sziFlags(result) | (flags & Z80_FLAG_N) | (halfCarry ? Z80_FLAG_H : 0) | (carry ? Z80_FLAG_C : 0));
+    _setA(result);
+}
+
+// ----------------------------------------
+// ---------- Instructions
+// ----------------------------------------
+
+// Unprefixed opcode, or DD/FD prefixed when _index is set
+void HostZ80::_execute(uint8_t op)
+{
+    uint8_t x = op >> 6;
+    uint8_t y = (op >> 3) & 7;
+    uint8_t z = op & 7;
+    uint8_t p = y >> 1;
+    uint8_t q = y & 1;
+
+    switch (x)
+    {
+    case 0:
+        switch (z)
+        {
+        case 0:
+            if (y == 0) // NOP
+            {
+            }
+            else if (y == 1) // EX AF,AF'
+            {
+                uint16_t af = registers.af;
+                registers.af = registers.af2;
+                registers.af2 = af;
+            }
+            else if (y == 2) // DJNZ d
+            {
+                _t += 1;
+                int8_t displacement = (int8_t)_next();
+                registers.bc -= 0x0100;
+                if (registers.bc >> 8)
+                {
+                    registers.pc += displacement;
+                    _t += 5;
+                }
+            }
+            else // JR d, JR cc,d
+            {
+                int8_t displacement = (int8_t)_next();
+                if (y == 3 || _condition(y - 4))
+                {
+                    registers.pc += displacement;
+                    _t += 5;
+                }
+            }
+            break;
+
+        case 1:
+            if (q == 0) // LD rp,nn
+                _setPair(p, _next16());
+            else // ADD HL,rp
+                _addHL(_getPair(p));
+            break;
+
+        case 2:
+        {
+            if (p == 2) // LD (nn),HL / LD HL,(nn)
+            {
+                uint16_t address = _next16();
+                if (q == 0)
+                {
+                    _write(address, _hl() & 0xFF);
+                    _write(address + 1, _hl() >> 8);
+                }
+                else
+                {
+                    uint8_t low = _read(address);
+                    _hl() = ((uint16_t)_read(address + 1) << 8) | low;
+                }
+                break;
+            }
+
+            // LD (BC),A / LD (DE),A / LD (nn),A and the loads of A
+            uint16_t address = (p == 0) ? registers.bc : (p == 1) ? registers.de : _next16();
+            if (q == 0)
+                _write(address, _getA());
+            else
+                _setA(_read(address));
+            break;
+        }
+
+        case 3: // INC rp / DEC rp
+            _setPair(p, _getPair(p) + (q ? -1 : 1));
+            _t += 2;
+            break;
+
+        case 4: // INC r
+        case 5: // DEC r
+            if (y == 6)
+            {
+                uint16_t address = _indexedAddress(5);
+                uint8_t v = _read(address);
+                _t += 1;
+                _write(address, z == 4 ? _inc(v) : _dec(v));
+            }
+            else
+            {
+                uint8_t v = _getRegister(y);
+                _setRegister(y, z == 4 ? _inc(v) : _dec(v));
+            }
+            break;
+
+        case 6: // LD r,n
+            if (y == 6)
+            {
+                uint16_t address = _indexedAddress(0);
+                uint8_t v = _next();
+                if (_index)
+                    _t += 2;
+                _write(address, v);
+            }
+            else
+            {
+                _setRegister(y, _next());
+            }
+            break;
+
+        default:
+            switch (y)
+            {
+            case 0: // RLCA
+            case 1: // RRCA
+            case 2: // RLA
+            case 3: // RRA
+            {
+                uint8_t flags = _getF();
+                _setA(_rotate(y, _getA()));
+                _setF((flags & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_PV)) | (_getF() & (Z80_FLAG_C | Z80_FLAG_X | Z80_FLAG_Y)));
+                break;
+            }
+            case 4: // DAA
+                _daa();
+                break;
+            case 5: // CPL
+                _setA(~_getA());
+                _setF((_getF() & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_PV | Z80_FLAG_C)) | Z80_FLAG_H | Z80_FLAG_N |
+                      (_getA() & (Z80_FLAG_X | Z80_FLAG_Y)));
+                break;
+            case 6: // SCF
+                _setF((_getF() & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_PV)) | Z80_FLAG_C |
+                      (_getA() & (Z80_FLAG_X | Z80_FLAG_Y)));
+                break;
+            default: // CCF
+            {
+                uint8_t flags = _getF();
+                _setF((flags & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_PV)) | ((flags & Z80_FLAG_C) ? Z80_FLAG_H : Z80_FLAG_C) |
+                      (_getA() & (Z80_FLAG_X | Z80_FLAG_Y)));
+                break;
+            }
+            }
+            break;
+        }
+        break;
+
+    case 1:
+        if (y == 6 && z == 6) // HALT
+            _halted = true;
+        else if (y == 6) // LD (HL),r
+            _write(_indexedAddress(5), _getPlainRegister(z));
+        else if (z == 6) // LD r,(HL)
+            _setPlainRegister(y, _read(_indexedAddress(5)));
+        else // LD r,r'
+            _setRegister(y, _getRegister(z));
+        break;
+
+    case 2: // ALU A,r
+        _alu(y, z == 6 ? _read(_indexedAddress(5)) : _getRegister(z));
+        break;
+
+    default:
+        switch (z)
+        {
+        case 0: // RET cc
+            _t += 1;
+            if (_condition(y))
+                registers.pc = _pop();
+            break;
+
+        case 1:
+            if (q == 0) // POP rp
+            {
+                _setPair2(p, _pop());
+            }
+            else if (p == 0) // RET
+            {
+                registers.pc = _pop();
+            }
+            else if (p == 1) // EXX
+            {
+                uint16_t bc = registers.bc, de = registers.de, hl = registers.hl;
+                registers.bc = registers.bc2;
+                registers.de = registers.de2;
+                registers.hl = registers.hl2;
+                registers.bc2 = bc;
+                registers.de2 = de;
+                registers.hl2 = hl;
+            }
+            else if (p == 2) // JP (HL)
+            {
+                registers.pc = _hl();
+            }
+            else // LD SP,HL
+            {
+                registers.sp = _hl();
+                _t += 2;
+            }
+            break;
+
+        case 2: // JP cc,nn
+        {
+            uint16_t address = _next16();
+            if (_condition(y))
+                registers.pc = address;
+            break;
+        }
+
+        case 3:
+            switch (y)
+            {
+            case 0: // JP nn
+                registers.pc = _next16();
+                break;
+            case 1: // CB prefix
+                if (_index)
+                    _executeIndexedCB();
+                else
+                    _executeCB();
+                break;
+            case 2: // OUT (n),A
+            {
+                uint8_t n = _next();
+                _output(((uint16_t)_getA() << 8) | n, _getA());
+                break;
+            }
+            case 3: // IN A,(n)
+            {
+                uint8_t n = _next();
+                _setA(_input(((uint16_t)_getA() << 8) | n));
+                break;
+            }
+            case 4: // EX (SP),HL
+            {
+                uint8_t low = _read(registers.sp);
+                uint8_t high = _read(registers.sp + 1);
+                _t += 1;
+                _write(registers.sp + 1, _hl() >> 8);
+                _write(registers.sp, _hl() & 0xFF);
+                _t += 2;
+                _hl() = ((uint16_t)high << 8) | low;
+                break;
+            }
+            case 5: // EX DE,HL (never IX/IY)
+            {
+                uint16_t de = registers.de;
+                registers.de = registers.hl;
+                registers.hl = de;
+                break;
+            }
+            case 6: // DI
+                registers.iff1 = false;
+                registers.iff2 = false;
+                break;
+            default: // EI
+                registers.iff1 = true;
+                registers.iff2 = true;
+                _afterEI = true;
+                break;
+            }
+            break;
+
+        case 4: // CALL cc,nn
+        {
+            uint16_t address = _next16();
+            if (_condition(y))
+            {
+                _t += 1;
+                _push(registers.pc);
+                registers.pc = address;
+            }
+            break;
+        }
+
+        case 5:
+            if (q == 0) // PUSH rp
+            {
+                _t += 1;
+                _push(_getPair2(p));
+            }
+            else if (p == 0) // CALL nn
+            {
+                uint16_t address = _next16();
+                _t += 1;
+                _push(registers.pc);
+                registers.pc = address;
+            }
+            else if (p == 2) // ED prefix, ignores DD/FD
+            {
+                _index = 0;
+                _executeED(_fetch());
+            }
+            else // DD/FD prefix; the last one counts
+            {
+                _index = (p == 1) ? 1 : 2;
+                _execute(_fetch());
+            }
+            break;
+
+        case 6: // ALU A,n
+            _alu(y, _next());
+            break;
+
+        default: // RST
+            _t += 1;
+            _push(registers.pc);
+            registers.pc = y << 3;
+            break;
+        }
+        break;
+    }
+}
+
+// Rotates, shifts and bit operations on registers and (HL)
+void HostZ80::_executeCB()
+{
+    uint8_t op = _fetch();
+    uint8_t x = op >> 6;
+    uint8_t y = (op >> 3) & 7;
+    uint8_t z = op & 7;
+
+    uint8_t v = (z == 6) ? _read(registers.hl) : _getRegister(z);
+    if (z == 6)
+        _t += 1;
+
+    uint8_t result;
+    switch (x)
+    {
+    case 0:
+        result = _rotate(y, v);
+        break;
+    case 1:
+        _bit(y, v);
+        return;
+    case 2:
+        result = v & ~(1 << y);
+        break;
+    default:
+        result = v | (1 << y);
+        break;
+    }
+
+    if (z == 6)
+        _write(registers.hl, result);
+    else
+        _setRegister(z, result);
+}
+
+// DDCB d op / FDCB d op; the opcode is read without M1 and the result is
+// also copied to a register unless the opcode addresses (HL)
+void HostZ80::_executeIndexedCB()
+{
+    int8_t displacement = (int8_t)_next();
+    uint8_t op = _next();
+    _t += 2;
+
+    uint8_t x = op >> 6;
+    uint8_t y = (op >> 3) & 7;
+    uint8_t z = op & 7;
+    uint16_t address = _hl() + displacement;
+
+    uint8_t v = _read(address);
+    _t += 1;
+
+    uint8_t result;
+    switch (x)
+    {
+    case 0:
+        result = _rotate(y, v);
+        break;
+    case 1:
+        _bit(y, v);
+        return;
+    case 2:
+        result = v & ~(1 << y);
+        break;
+    default:
+        result = v | (1 << y);
+        break;
+    }
+
+    _write(address, result);
+    if (z != 6)
+        _setPlainRegister(z, result);
+}
+
+// ED group; undefined opcodes are 8 T-state NOPs
+void HostZ80::_executeED(uint8_t op)
+{
+    uint8_t x = op >> 6;
+    uint8_t y = (op >> 3) & 7;
+    uint8_t z = op & 7;
+    uint8_t p = y >> 1;
+    uint8_t q = y & 1;
+
+    if (x == 2)
+    {
+        if (z <= 3 && y >= 4)
+            _executeBlock(y, z);
+        return;
+    }
+    if (x != 1)
+        return;
+
+    switch (z)
+    {
+    case 0: // IN r,(C); IN (C) only sets flags
+    {
+        uint8_t v = _input(registers.bc);
+        _setF((_getF() & Z80_FLAG_C) | _sziFlags(v));
+        if (y != 6)
+            _setRegister(y, v);
+        break;
+    }
+
+    case 1: // OUT (C),r; OUT (C),0
+        _output(registers.bc, y == 6 ? 0 : _getRegister(y));
+        break;
+
+    case 2: // SBC HL,rp / ADC HL,rp
+        if (q == 0)
+            _sbcHL(_getPair(p));
+        else
+            _adcHL(_getPair(p));
+        break;
+
+    case 3: // LD (nn),rp / LD rp,(nn)
+    {
+        uint16_t address = _next16();
+        if (q == 0)
+        {
+            uint16_t v = _getPair(p);
+            _write(address, v & 0xFF);
+            _write(address + 1, v >> 8);
+        }
+        else
+        {
+            uint8_t low = _read(address);
+            _setPair(p, ((uint16_t)_read(address + 1) << 8) | low);
+        }
+        break;
+    }
+
+    case 4: // NEG
+    {
+        uint8_t v = _getA();
+        _setA(0);
+        _alu(2, v);
+        break;
+    }
+
+    case 5: // RETN / RETI
+        registers.pc = _pop();
+        registers.iff1 = registers.iff2;
+        break;
+
+    case 6: // IM 0/1/2
+    {
+        static const uint8_t modes[8] = {0, 0, 1, 2, 0, 0, 1, 2};
+        registers.im = modes[y];
+        break;
+    }
+
+    default:
+        switch (y)
+        {
+        case 0: // LD I,A
+            _t += 1;
+            registers.i = _getA();
+            break;
+        case 1: // LD R,A
+            _t += 1;
+            registers.r = _getA();
+            break;
+        case 2: // LD A,I
+        case 3: // LD A,R
+        {
+            _t += 1;
+            uint8_t v = (y == 2) ? registers.i : registers.r;
+            _setA(v);
+            uint8_t flags = (_getF() & Z80_FLAG_C) | (v & Z80_FLAG_SXY);
+            if (v == 0)
+                flags |= Z80_FLAG_Z;
+            if (registers.iff2)
+                flags |= Z80_FLAG_PV;
+            _setF(flags);
+            break;
+        }
+        case 4: // RRD
+        case 5: // RLD
+        {
+            uint8_t v = _read(registers.hl);
+            uint8_t a = _getA();
+            _t += 4;
+            if (y == 4)
+            {
+                _write(registers.hl, (a << 4) | (v >> 4));
+                a = (a & 0xF0) | (v & 0x0F);
+            }
+            else
+            {
+                _write(registers.hl, (v << 4) | (a & 0x0F));
+                a = (a & 0xF0) | (v >> 4);
+            }
+            _setA(a);
+            _setF((_getF() & Z80_FLAG_C) | _sziFlags(a));
+            break;
+        }
+        default: // NOP
+            break;
+        }
+        break;
+    }
+}
+
+// LDI, CPI, INI, OUTI, their decrementing forms and the repeating ones
+void HostZ80::_executeBlock(uint8_t y, uint8_t z)
+{
+    int16_t step = (y & 1) ? -1 : 1;
+    bool repeat = y >= 6;
+    bool again = false;
+
+    switch (z)
+    {
+    case 0: // LDI
+    {
+        uint8_t v = _read(registers.hl);
+        _write(registers.de, v);
+        _t += 2;
+        registers.hl += step;
+        registers.de += step;
+        registers.bc--;
+
+        uint8_t n = v + _getA();
+        uint8_t flags = (_getF() & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_C)) | (n & Z80_FLAG_X) | ((n << 4) & Z80_FLAG_Y);
+        if (registers.bc)
+            flags |= Z80_FLAG_PV;
+        _setF(flags);
+        again = registers.bc != 0;
+        break;
+    }
+
+    case 1: // CPI
+    {
+        uint8_t v = _read(registers.hl);
+        _t += 5;
+        registers.hl += step;
+        registers.bc--;
+
+        uint8_t a = _getA();
+        uint8_t result = a - v;
+        uint8_t flags = (_getF() & Z80_FLAG_C) | Z80_FLAG_N | (result & Z80_FLAG_S) | ((a ^ v ^ result) & Z80_FLAG_H);
+        if (result == 0)
+            flags |= Z80_FLAG_Z;
+        if (registers.bc)
+            flags |= Z80_FLAG_PV;
+        uint8_t n = result - ((flags & Z80_FLAG_H) ? 1 : 0);
+        flags |= (n & Z80_FLAG_X) | ((n << 4) & Z80_FLAG_Y);
+        _setF(flags);
+        again = registers.bc != 0 && result != 0;
+        break;
+    }
+
+    case 2: // INI
+    {
+        _t += 1;
+        uint8_t v = _input(registers.bc);
+        _write(registers.hl, v);
+        registers.hl += step;
+        registers.bc -= 0x0100;
+        _setF((_getF() & Z80_FLAG_C) | Z80_FLAG_N | ((registers.bc >> 8) & Z80_FLAG_SXY) | ((registers.bc >> 8) ? 0 : Z80_FLAG_Z));
+        again = (registers.bc >> 8) != 0;
+        break;
+    }
+
+    default: // OUTI
+    {
+        _t += 1;
+        uint8_t v = _read(registers.hl);
+        registers.bc -= 0x0100;
+        _output(registers.bc, v);
+        registers.hl += step;
+        _setF((_getF() & Z80_FLAG_C) | Z80_FLAG_N | ((registers.bc >> 8) & Z80_FLAG_SXY) | ((registers.bc >> 8) ? 0 : Z80_FLAG_Z));
+        again = (registers.bc >> 8) != 0;
+        break;
+    }
+    }
+
+    if (repeat && again)
+    {
+        registers.pc -= 2;
+        _t += 5;
+    }
+}
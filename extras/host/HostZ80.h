@@ -0,0 +1,123 @@
+/*
+ * HostZ80.h - Z80 CPU core for the virtual Model 1
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * Instruction level Z80 core with the documented instruction set, including
+ * the CB, ED, DD, FD, DDCB and FDCB groups, IXH/IXL/IYH/IYL and interrupt
+ * modes 0, 1 and 2.
+ *
+ * Each instruction performs its bus cycles through a HostZ80Bus together with
+ * the T-state at which the machine cycle starts, so the virtual machine can
+ * tell which cycle a bus request or a TEST* edge falls into. step() returns
+ * the T-states of the instruction; they match the Zilog timing tables.
+ *
+ * Not emulated: NMI, the undocumented flag bits of BIT n,(HL) and the block
+ * I/O instructions, and interrupt mode 0 with other than single byte vectors.
+ */
+
+#ifndef HOST_Z80_H
+#define HOST_Z80_H
+
+#include <stdint.h>
+
+// Z80 clock of the Model 1 in Hz
+#define HOST_Z80_CLOCK 1774080UL
+
+// Bus cycle types
+enum HostZ80Cycle
+{
+    HOST_Z80_FETCH,  // Opcode fetch (M1), 4 T-states including refresh
+    HOST_Z80_READ,   // Memory read, 3 T-states
+    HOST_Z80_WRITE,  // Memory write, 3 T-states
+    HOST_Z80_INPUT,  // IO read, 4 T-states
+    HOST_Z80_OUTPUT, // IO write, 4 T-states
+};
+
+// Receives the bus cycles of the core
+class HostZ80Bus
+{
+public:
+    virtual uint8_t z80Read(HostZ80Cycle cycle, uint16_t address, uint16_t tState) = 0;              // Fetch, memory read or IO read starting at tState
+    virtual void z80Write(HostZ80Cycle cycle, uint16_t address, uint8_t data, uint16_t tState) = 0; // Memory or IO write starting at tState
+};
+
+// Register file
+struct HostZ80Registers
+{
+    uint16_t af, bc, de, hl;     // Main registers
+    uint16_t af2, bc2, de2, hl2; // Alternate registers
+    uint16_t ix, iy, sp, pc;     // Index registers, stack pointer and program counter
+    uint8_t i, r;                // Interrupt vector base and refresh counter
+    bool iff1, iff2;             // Interrupt enable flip-flops
+    uint8_t im;                  // Interrupt mode 0, 1 or 2
+};
+
+class HostZ80
+{
+public:
+    HostZ80Registers registers = {}; // Register file, may be changed between steps
+
+    void setBus(HostZ80Bus *bus); // Receiver of all bus cycles
+    void reset();                 // Power-on reset: PC, I, R and IFFs cleared, interrupt mode 0
+
+    uint16_t step();                  // Execute one instruction (or one HALT cycle); returns its T-states
+    uint16_t interrupt(uint8_t data); // Take a maskable interrupt with the byte read during acknowledge; returns its T-states
+    bool acceptsInterrupt();          // Interrupts enabled and the last instruction was not EI
+    bool isHalted();                  // Waiting for an interrupt after HALT
+
+private:
+    HostZ80Bus *_bus = nullptr; // Receiver of the bus cycles
+    uint16_t _t = 0;            // T-states into the current instruction
+    bool _halted = false;       // Set by HALT until an interrupt
+    bool _afterEI = false;      // Interrupts are not taken right after EI
+    uint8_t _index = 0;         // 0 = HL, 1 = IX, 2 = IY for the current instruction
+
+    uint8_t _fetch();                           // M1 cycle at PC
+    uint8_t _read(uint16_t address);            // Memory read cycle
+    void _write(uint16_t address, uint8_t data); // Memory write cycle
+    uint8_t _next();                            // Read the byte at PC
+    uint16_t _next16();                         // Read the word at PC
+    uint8_t _input(uint16_t port);              // IO read cycle
+    void _output(uint16_t port, uint8_t data);  // IO write cycle
+    void _push(uint16_t value);                 // Push a word
+    uint16_t _pop();                            // Pop a word
+
+    uint16_t &_hl();                          // HL, IX or IY
+    uint16_t _indexedAddress(uint8_t extra);  // (HL) or (IX+d) with extra internal T-states for the displacement
+    uint8_t _getRegister(uint8_t r);          // Register by its 3-bit code (not 6), honouring IXH/IXL
+    void _setRegister(uint8_t r, uint8_t v);  // Register by its 3-bit code (not 6), honouring IXH/IXL
+    uint8_t _getPlainRegister(uint8_t r);     // Register by its 3-bit code, H and L never replaced
+    void _setPlainRegister(uint8_t r, uint8_t v);
+    uint16_t _getPair(uint8_t p);             // BC, DE, HL/IX/IY, SP
+    void _setPair(uint8_t p, uint16_t v);
+    uint16_t _getPair2(uint8_t p);            // BC, DE, HL/IX/IY, AF
+    void _setPair2(uint8_t p, uint16_t v);
+    bool _condition(uint8_t c);               // NZ, Z, NC, C, PO, PE, P, M
+
+    uint8_t _getA();
+    void _setA(uint8_t v);
+    uint8_t _getF();
+    void _setF(uint8_t v);
+
+    void _alu(uint8_t op, uint8_t v);    // ADD, ADC, SUB, SBC, AND, XOR, OR, CP
+    uint8_t _inc(uint8_t v);             // INC with flags
+    uint8_t _dec(uint8_t v);             // DEC with flags
+    uint8_t _rotate(uint8_t op, uint8_t v); // RLC, RRC, RL, RR, SLA, SRA, SLL, SRL with flags
+    void _bit(uint8_t bit, uint8_t v);   // BIT with flags
+    void _addHL(uint16_t v);             // ADD HL/IX/IY,rp
+    void _adcHL(uint16_t v);             // ADC HL,rp
+    void _sbcHL(uint16_t v);             // SBC HL,rp
+    void _daa();                         // Decimal adjust
+    uint8_t _sziFlags(uint8_t v);        // S, Z, X, Y and parity of a result
+
+    void _execute(uint8_t op);          // Unprefixed or DD/FD prefixed opcode
+    void _executeCB();                  // CB group
+    void _executeIndexedCB();           // DDCB/FDCB group
+    void _executeED(uint8_t op);        // ED group
+    void _executeBlock(uint8_t y, uint8_t z); // LDI, CPI, INI, OUTI and their repeating forms
+};
+
+#endif // HOST_Z80_H
@@ -0,0 +1,58 @@
+/*
+ * Adafruit_GFX.h - Host replacement of the Adafruit GFX base class (draws nothing)
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+class Adafruit_GFX : public Print
+{
+protected:
+    int16_t _width;   // Display width in pixels
+    int16_t _height;  // Display height in pixels
+    int16_t _cursorX; // Text cursor column
+    int16_t _cursorY; // Text cursor row
+
+public:
+    Adafruit_GFX(int16_t width, int16_t height) : _width(width), _height(height), _cursorX(0), _cursorY(0) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) {}
+    virtual void startWrite() {}
+    virtual void endWrite() {}
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {}
+    virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {}
+    virtual void fillScreen(uint16_t color) {}
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {}
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {}
+    virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {}
+    virtual void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg) {}
+
+    void setCursor(int16_t x, int16_t y)
+    {
+        _cursorX = x;
+        _cursorY = y;
+    }
+    void setTextSize(uint8_t size) {}
+    void setTextColor(uint16_t color) {}
+    void setTextColor(uint16_t color, uint16_t background) {}
+    void setTextWrap(bool wrap) {}
+    void getTextBounds(const char *str, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+    {
+        *x1 = x;
+        *y1 = y;
+        *w = 6 * strlen(str);
+        *h = 8;
+    }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    size_t write(uint8_t ch) override { return 1; }
+    using Print::write;
+};
+
+#endif // HOST_ADAFRUIT_GFX_H
@@ -0,0 +1,347 @@
+/*
+ * Arduino.cpp - Host replacement of the Arduino core for the virtual Model 1
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include <Arduino.h>
+#include <SD.h>
+#include "HostModel1.h"
+
+// Cycles a call to millis()/micros() takes on the Arduino; also keeps polling loops moving
+#define HOST_TIME_READ_CYCLES 16
+
+// ----------------------------------------
+// ---------- Registers
+// ----------------------------------------
+
+HostStatusRegister SREG(1 << SREG_I);
+
+#define HOST_DEFINE_PORT(_port)                                                           \
+    HostRegister DDR##_port(HOST_PORT_REGISTER(#_port[0], HOST_REGISTER_DDR));   \
+    HostRegister PORT##_port(HOST_PORT_REGISTER(#_port[0], HOST_REGISTER_PORT)); \
+    HostRegister PIN##_port(HOST_PORT_REGISTER(#_port[0], HOST_REGISTER_PIN));
+
+HOST_DEFINE_PORT(A)
+HOST_DEFINE_PORT(B)
+HOST_DEFINE_PORT(C)
+HOST_DEFINE_PORT(D)
+HOST_DEFINE_PORT(E)
+HOST_DEFINE_PORT(F)
+HOST_DEFINE_PORT(G)
+HOST_DEFINE_PORT(H)
+HOST_DEFINE_PORT(J)
+HOST_DEFINE_PORT(K)
+HOST_DEFINE_PORT(L)
+
+HostRegister TCCR1A(HOST_TCCR1A), TCCR1B(HOST_TCCR1B), TIMSK1(HOST_TIMSK1), TIFR1(HOST_TIFR1);
+HostRegister TCCR2A(HOST_TCCR2A), TCCR2B(HOST_TCCR2B), TIMSK2(HOST_TIMSK2), TIFR2(HOST_TIFR2), TCNT2(HOST_TCNT2), OCR2A(HOST_OCR2A);
+HostRegister TCCR5A(HOST_TCCR5A), TCCR5B(HOST_TCCR5B), TIMSK5(HOST_TIMSK5), TIFR5(HOST_TIFR5);
+HostRegister16 TCNT1(HOST_TCNT1), OCR1A(HOST_OCR1A), TCNT5(HOST_TCNT5), OCR5A(HOST_OCR5A);
+
+uint8_t hostReadRegister(uint8_t id)
+{
+    return HostModel1.readRegister(id);
+}
+
+void hostWriteRegister(uint8_t id, uint8_t value)
+{
+    HostModel1.writeRegister(id, value);
+}
+
+uint16_t hostReadRegister16(uint8_t id)
+{
+    return HostModel1.readRegister16(id);
+}
+
+void hostWriteRegister16(uint8_t id, uint16_t value)
+{
+    HostModel1.writeRegister16(id, value);
+}
+
+void hostDelayCycles(uint32_t cycles)
+{
+    HostModel1.advance(cycles);
+}
+
+void hostInterruptsEnabled()
+{
+    HostModel1.takeInterrupts();
+}
+
+// ----------------------------------------
+// ---------- Pins
+// ----------------------------------------
+
+static uint8_t pinModes[HOST_PIN_COUNT];
+static int pinOutputs[HOST_PIN_COUNT];
+static int pinInputs[HOST_PIN_COUNT];
+static bool pinInputSet[HOST_PIN_COUNT];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < HOST_PIN_COUNT)
+        pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < HOST_PIN_COUNT)
+        pinOutputs[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= HOST_PIN_COUNT)
+        return LOW;
+    if (pinInputSet[pin])
+        return pinInputs[pin] ? HIGH : LOW;
+    if (pinModes[pin] == OUTPUT)
+        return pinOutputs[pin] ? HIGH : LOW;
+    return (pinModes[pin] == INPUT_PULLUP) ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    if (pin < HOST_PIN_COUNT && pinInputSet[pin])
+        return pinInputs[pin];
+    return 512; // Centered joystick
+}
+
+void analogWrite(uint8_t pin, int value)
+{
+    digitalWrite(pin, value);
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+{
+}
+
+void noTone(uint8_t pin)
+{
+}
+
+void hostSetPinInput(uint8_t pin, int value)
+{
+    if (pin >= HOST_PIN_COUNT)
+        return;
+    pinInputs[pin] = value;
+    pinInputSet[pin] = true;
+}
+
+// ----------------------------------------
+// ---------- Time
+// ----------------------------------------
+
+unsigned long millis()
+{
+    HostModel1.advance(HOST_TIME_READ_CYCLES);
+    return HostModel1.getCycles() / (F_CPU / 1000UL);
+}
+
+unsigned long micros()
+{
+    HostModel1.advance(HOST_TIME_READ_CYCLES);
+    return HostModel1.getCycles() / (F_CPU / 1000000UL);
+}
+
+void delay(unsigned long ms)
+{
+    HostModel1.advance(ms * (F_CPU / 1000UL));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    HostModel1.advance(us * (F_CPU / 1000000UL));
+}
+
+// ----------------------------------------
+// ---------- Random
+// ----------------------------------------
+
+long random(long max)
+{
+    return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max)
+{
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+    srand(seed);
+}
+
+// ----------------------------------------
+// ---------- Print
+// ----------------------------------------
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+        n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(long value, int base)
+{
+    if (value < 0 && base == DEC)
+        return print('-') + _printNumber((unsigned long)-value, base);
+    return _printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return write(buffer);
+}
+
+size_t Print::_printNumber(unsigned long value, int base)
+{
+    char buffer[40];
+    char *p = buffer + sizeof(buffer) - 1;
+    *p = 0;
+    if (base < 2)
+        base = DEC;
+    do
+    {
+        int digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while (value);
+    return write(p);
+}
+
+HardwareSerial Serial;
+
+// ----------------------------------------
+// ---------- SD
+// ----------------------------------------
+
+SDClass SD;
+
+File::File(FILE *file, const char *name, bool directory)
+{
+    _file = file;
+    _directory = directory;
+    strncpy(_name, name, sizeof(_name) - 1);
+    _name[sizeof(_name) - 1] = 0;
+}
+
+size_t File::write(uint8_t ch)
+{
+    return (_file && fputc(ch, _file) != EOF) ? 1 : 0;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    return _file ? fwrite(buffer, 1, size, _file) : 0;
+}
+
+int File::read()
+{
+    return _file ? fgetc(_file) : -1;
+}
+
+int File::read(void *buffer, size_t size)
+{
+    return _file ? (int)fread(buffer, 1, size, _file) : -1;
+}
+
+int File::peek()
+{
+    if (!_file)
+        return -1;
+    int ch = fgetc(_file);
+    if (ch != EOF)
+        ungetc(ch, _file);
+    return ch;
+}
+
+int File::available()
+{
+    return _file ? (int)(size() - position()) : 0;
+}
+
+bool File::seek(uint32_t position)
+{
+    return _file && fseek(_file, position, SEEK_SET) == 0;
+}
+
+uint32_t File::position()
+{
+    return _file ? ftell(_file) : 0;
+}
+
+uint32_t File::size()
+{
+    if (!_file)
+        return 0;
+    long position = ftell(_file);
+    fseek(_file, 0, SEEK_END);
+    long end = ftell(_file);
+    fseek(_file, position, SEEK_SET);
+    return end;
+}
+
+void File::flush()
+{
+    if (_file)
+        fflush(_file);
+}
+
+void File::close()
+{
+    if (_file)
+        fclose(_file);
+    _file = nullptr;
+    _directory = false;
+}
+
+String File::readStringUntil(char terminator)
+{
+    String result;
+    int ch;
+    while ((ch = read()) >= 0 && ch != terminator)
+        result += (char)ch;
+    return result;
+}
+
+// Files are opened relative to the working directory; FILE_WRITE appends like on the Arduino
+File SDClass::open(const char *path, uint8_t mode)
+{
+    FILE *file = fopen(path, mode == FILE_WRITE ? "ab+" : "rb");
+    return File(file, path);
+}
+
+bool SDClass::exists(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file)
+        fclose(file);
+    return file != nullptr;
+}
+
+bool SDClass::remove(const char *path)
+{
+    return ::remove(path) == 0;
+}
+
+bool SDClass::mkdir(const char *path)
+{
+    return true;
+}
@@ -0,0 +1,482 @@
+/*
+ * Arduino.h - Host replacement of the Arduino core for the virtual Model 1
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * Provides just enough of the Arduino core and the ATmega2560 registers to
+ * build the library on a desktop compiler.
+ *
+ * The port and timer registers are HostRegister objects: every read and write
+ * is forwarded to the virtual Model 1 (HostModel1.h), which decodes the bus
+ * signals, answers reads and advances a simulated 16 MHz clock. millis() and
+ * micros() follow that clock, so timings measured on the host approximate the
+ * ones on the Arduino.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+#include <type_traits>
+#include "Print.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+// ---------- Program memory (plain memory on the host)
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) ((const __FlashStringHelper *)(s))
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define pgm_read_float(address) (*(const float *)(address))
+#define pgm_read_ptr(address) (*(void *const *)(address))
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strcmp_P strcmp
+#define strcasecmp_P strcasecmp
+#define memcpy_P memcpy
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+// ---------- Bits
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitValue) ((bitValue) ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+#define _BV(b) (1 << (b))
+
+template <typename T, typename U>
+typename std::common_type<T, U>::type min(T a, U b) { return a < b ? a : b; }
+template <typename T, typename U>
+typename std::common_type<T, U>::type max(T a, U b) { return a > b ? a : b; }
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+// ---------- Simulated registers
+
+// Register numbers: three per port (DDR, PORT, PIN) for ports A-L, followed by the timer registers
+#define HOST_PORT_REGISTER(_port, _kind) (((_port) - 'A') * 3 + (_kind))
+#define HOST_REGISTER_DDR 0
+#define HOST_REGISTER_PORT 1
+#define HOST_REGISTER_PIN 2
+#define HOST_PORT_COUNT 12
+
+enum HostTimerRegister
+{
+    HOST_TCCR1A = HOST_PORT_COUNT * 3,
+    HOST_TCCR1B,
+    HOST_TIMSK1,
+    HOST_TIFR1,
+    HOST_TCCR2A,
+    HOST_TCCR2B,
+    HOST_TIMSK2,
+    HOST_TIFR2,
+    HOST_TCNT2,
+    HOST_OCR2A,
+    HOST_TCCR5A,
+    HOST_TCCR5B,
+    HOST_TIMSK5,
+    HOST_TIFR5,
+    HOST_REGISTER_COUNT
+};
+
+enum HostTimerRegister16
+{
+    HOST_TCNT1,
+    HOST_OCR1A,
+    HOST_TCNT5,
+    HOST_OCR5A,
+    HOST_REGISTER16_COUNT
+};
+
+uint8_t hostReadRegister(uint8_t id);                 // Read a register of the virtual Arduino
+void hostWriteRegister(uint8_t id, uint8_t value);    // Write a register of the virtual Arduino
+uint16_t hostReadRegister16(uint8_t id);              // Read a 16-bit timer register
+void hostWriteRegister16(uint8_t id, uint16_t value); // Write a 16-bit timer register
+void hostDelayCycles(uint32_t cycles);                // Let simulated CPU cycles pass
+void hostInterruptsEnabled();                         // Take interrupts that became pending while disabled
+
+// 8-bit I/O register forwarding all accesses to the virtual Model 1
+class HostRegister
+{
+private:
+    uint8_t _id; // Register number
+
+public:
+    constexpr HostRegister(uint8_t id) : _id(id) {}
+
+    constexpr uint8_t getId() const { return _id; }
+    constexpr uint8_t getPort() const { return _id / 3; }
+
+    operator uint8_t() const { return hostReadRegister(_id); }
+    HostRegister &operator=(uint8_t value)
+    {
+        hostWriteRegister(_id, value);
+        return *this;
+    }
+    HostRegister &operator=(const HostRegister &other) { return *this = (uint8_t)other; }
+    HostRegister &operator|=(uint8_t value) { return *this = (uint8_t)(hostReadRegister(_id) | value); }
+    HostRegister &operator&=(uint8_t value) { return *this = (uint8_t)(hostReadRegister(_id) & value); }
+    HostRegister &operator^=(uint8_t value) { return *this = (uint8_t)(hostReadRegister(_id) ^ value); }
+};
+
+// 16-bit timer register forwarding all accesses to the virtual Model 1
+class HostRegister16
+{
+private:
+    uint8_t _id; // Register number
+
+public:
+    constexpr HostRegister16(uint8_t id) : _id(id) {}
+
+    operator uint16_t() const { return hostReadRegister16(_id); }
+    HostRegister16 &operator=(uint16_t value)
+    {
+        hostWriteRegister16(_id, value);
+        return *this;
+    }
+    HostRegister16 &operator=(const HostRegister16 &other) { return *this = (uint16_t)other; }
+};
+
+#define HOST_DECLARE_PORT(_port)  \
+    extern HostRegister DDR##_port;  \
+    extern HostRegister PORT##_port; \
+    extern HostRegister PIN##_port;
+
+HOST_DECLARE_PORT(A)
+HOST_DECLARE_PORT(B)
+HOST_DECLARE_PORT(C)
+HOST_DECLARE_PORT(D)
+HOST_DECLARE_PORT(E)
+HOST_DECLARE_PORT(F)
+HOST_DECLARE_PORT(G)
+HOST_DECLARE_PORT(H)
+HOST_DECLARE_PORT(J)
+HOST_DECLARE_PORT(K)
+HOST_DECLARE_PORT(L)
+
+extern HostRegister TCCR1A, TCCR1B, TIMSK1, TIFR1;
+extern HostRegister TCCR2A, TCCR2B, TIMSK2, TIFR2, TCNT2, OCR2A;
+extern HostRegister TCCR5A, TCCR5B, TIMSK5, TIFR5;
+extern HostRegister16 TCNT1, OCR1A, TCNT5, OCR5A;
+
+#define SREG_I 7
+
+// Status register; bit 7 enables interrupts. Setting it takes pending interrupts like the AVR does
+class HostStatusRegister
+{
+private:
+    volatile uint8_t _value; // Register value
+
+public:
+    constexpr HostStatusRegister(uint8_t value) : _value(value) {}
+
+    operator uint8_t() const { return _value; }
+    HostStatusRegister &operator=(uint8_t value)
+    {
+        bool enabled = !(_value & (1 << SREG_I)) && (value & (1 << SREG_I));
+        _value = value;
+        if (enabled)
+            hostInterruptsEnabled();
+        return *this;
+    }
+    HostStatusRegister &operator|=(uint8_t value) { return *this = (uint8_t)(_value | value); }
+    HostStatusRegister &operator&=(uint8_t value) { return *this = (uint8_t)(_value & value); }
+};
+
+extern HostStatusRegister SREG;
+
+#define cli() (SREG &= (uint8_t) ~(1 << SREG_I))
+#define sei() (SREG |= (1 << SREG_I))
+#define noInterrupts() cli()
+#define interrupts() sei()
+
+// Timer bits (ATmega2560)
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define TOIE1 0
+#define OCIE1A 1
+#define TOV1 0
+#define OCF1A 1
+
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM21 1
+#define TOIE2 0
+#define OCIE2A 1
+#define TOV2 0
+#define OCF2A 1
+
+#define CS50 0
+#define CS51 1
+#define CS52 2
+#define WGM52 3
+#define TOIE5 0
+#define OCIE5A 1
+#define TOV5 0
+#define OCF5A 1
+
+// Interrupt handlers; a sketch defines them with ISR() and the virtual Arduino calls them
+#define ISR(vector) void vector(void)
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER2_COMPA_vect(void) __attribute__((weak));
+void TIMER5_OVF_vect(void) __attribute__((weak));
+
+// ---------- Pins
+
+// Analog pins of the Mega
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#define A8 62
+#define A9 63
+#define A10 64
+#define A11 65
+#define A12 66
+#define A13 67
+#define A14 68
+#define A15 69
+
+#define HOST_PIN_COUNT 70
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+void hostSetPinInput(uint8_t pin, int value); // Set what digitalRead()/analogRead() return for a pin (e.g. a pressed button)
+
+// ---------- Time (simulated clock)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// ---------- Random
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// ---------- Strings
+
+class String
+{
+private:
+    std::string _value;
+
+public:
+    String(const char *str = "") : _value(str ? str : "") {}
+    String(const __FlashStringHelper *str) : _value((const char *)str) {}
+    String(const std::string &str) : _value(str) {}
+    String(char ch) : _value(1, ch) {}
+    String(int value, int base = DEC) : _value(_format((long)value, base)) {}
+    String(unsigned int value, int base = DEC) : _value(_format((unsigned long)value, base)) {}
+    String(long value, int base = DEC) : _value(_format(value, base)) {}
+    String(unsigned long value, int base = DEC) : _value(_format(value, base)) {}
+    String(double value, int digits = 2)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+        _value = buffer;
+    }
+
+    const char *c_str() const { return _value.c_str(); }
+    unsigned int length() const { return _value.size(); }
+    bool reserve(unsigned int size)
+    {
+        _value.reserve(size);
+        return true;
+    }
+
+    String &operator+=(const String &other)
+    {
+        _value += other._value;
+        return *this;
+    }
+    String &operator+=(const char *other)
+    {
+        _value += other;
+        return *this;
+    }
+    String &operator+=(char ch)
+    {
+        _value += ch;
+        return *this;
+    }
+    bool concat(const String &other)
+    {
+        *this += other;
+        return true;
+    }
+    friend String operator+(const String &a, const String &b) { return String(a._value + b._value); }
+
+    bool operator==(const String &other) const { return _value == other._value; }
+    bool operator!=(const String &other) const { return _value != other._value; }
+    bool operator<(const String &other) const { return _value < other._value; }
+    char operator[](unsigned int index) const { return index < _value.size() ? _value[index] : 0; }
+    char &operator[](unsigned int index) { return _value[index]; }
+
+    char charAt(unsigned int index) const { return (*this)[index]; }
+    void setCharAt(unsigned int index, char ch)
+    {
+        if (index < _value.size())
+            _value[index] = ch;
+    }
+    int compareTo(const String &other) const { return _value.compare(other._value); }
+    bool equals(const String &other) const { return _value == other._value; }
+    bool equalsIgnoreCase(const String &other) const { return strcasecmp(_value.c_str(), other._value.c_str()) == 0; }
+    bool startsWith(const String &prefix) const { return _value.compare(0, prefix._value.size(), prefix._value) == 0; }
+    bool endsWith(const String &suffix) const { return _value.size() >= suffix._value.size() && _value.compare(_value.size() - suffix._value.size(), suffix._value.size(), suffix._value) == 0; }
+    int indexOf(char ch, unsigned int from = 0) const
+    {
+        size_t index = _value.find(ch, from);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    int indexOf(const String &str, unsigned int from = 0) const
+    {
+        size_t index = _value.find(str._value, from);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    int lastIndexOf(char ch) const
+    {
+        size_t index = _value.rfind(ch);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    int lastIndexOf(const String &str) const
+    {
+        size_t index = _value.rfind(str._value);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    String substring(unsigned int from) const { return from < _value.size() ? String(_value.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const { return (from < _value.size() && to > from) ? String(_value.substr(from, to - from)) : String(); }
+    void remove(unsigned int index) { _value.erase(min(index, (unsigned int)_value.size())); }
+    void remove(unsigned int index, unsigned int count)
+    {
+        if (index < _value.size())
+            _value.erase(index, count);
+    }
+    void replace(const String &from, const String &to)
+    {
+        if (from._value.empty())
+            return;
+        size_t index = 0;
+        while ((index = _value.find(from._value, index)) != std::string::npos)
+        {
+            _value.replace(index, from._value.size(), to._value);
+            index += to._value.size();
+        }
+    }
+    void toLowerCase()
+    {
+        for (auto &ch : _value)
+            ch = tolower(ch);
+    }
+    void toUpperCase()
+    {
+        for (auto &ch : _value)
+            ch = toupper(ch);
+    }
+    void trim()
+    {
+        while (!_value.empty() && isspace((unsigned char)_value.back()))
+            _value.pop_back();
+        size_t index = 0;
+        while (index < _value.size() && isspace((unsigned char)_value[index]))
+            index++;
+        _value.erase(0, index);
+    }
+    long toInt() const { return atol(_value.c_str()); }
+    void toCharArray(char *buffer, unsigned int size) const
+    {
+        if (size == 0)
+            return;
+        strncpy(buffer, _value.c_str(), size - 1);
+        buffer[size - 1] = 0;
+    }
+
+private:
+    static std::string _format(unsigned long value, int base)
+    {
+        char buffer[40];
+        char *p = buffer + sizeof(buffer) - 1;
+        *p = 0;
+        do
+        {
+            int digit = value % base;
+            *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+            value /= base;
+        } while (value);
+        return p;
+    }
+    static std::string _format(long value, int base)
+    {
+        if (value < 0 && base == DEC)
+            return "-" + _format((unsigned long)-value, base);
+        return _format((unsigned long)value, base);
+    }
+};
+
+inline size_t Print::print(const String &str) { return write(str.c_str()); }
+
+// ---------- Serial (standard output)
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long baud) {}
+    void end() {}
+    operator bool() const { return true; }
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    void flush() { fflush(stdout); }
+    size_t write(uint8_t ch) override
+    {
+        fputc(ch, stdout);
+        return 1;
+    }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
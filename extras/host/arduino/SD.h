@@ -0,0 +1,60 @@
+/*
+ * SD.h - Host replacement of the Arduino SD library, backed by the local file system
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include <Arduino.h>
+
+#define FILE_READ 0
+#define FILE_WRITE 1
+
+class File : public Print
+{
+private:
+    FILE *_file;     // Open file, nullptr for directories and closed files
+    bool _directory; // Set for directories
+    char _name[64];  // File name as opened
+
+public:
+    File(FILE *file = nullptr, const char *name = "", bool directory = false);
+
+    operator bool() const { return _file != nullptr || _directory; }
+
+    size_t write(uint8_t ch) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    int read();
+    int read(void *buffer, size_t size);
+    int peek();
+    int available();
+    bool seek(uint32_t position);
+    uint32_t position();
+    uint32_t size();
+    void flush();
+    void close();
+
+    const char *name() { return _name; }
+    bool isDirectory() { return _directory; }
+    File openNextFile() { return File(); }
+    void rewindDirectory() {}
+    String readStringUntil(char terminator);
+};
+
+class SDClass
+{
+public:
+    bool begin(uint8_t csPin = 0) { return true; }
+    File open(const char *path, uint8_t mode = FILE_READ);
+    bool exists(const char *path);
+    bool remove(const char *path);
+    bool mkdir(const char *path);
+};
+
+extern SDClass SD;
+
+#endif // HOST_SD_H
@@ -0,0 +1,12 @@
+/*
+ * SPI.h - Host replacement of the Arduino SPI library (empty)
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#endif // HOST_SPI_H
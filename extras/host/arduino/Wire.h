@@ -0,0 +1,12 @@
+/*
+ * Wire.h - Host replacement of the Arduino Wire library (empty)
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+#endif // HOST_WIRE_H
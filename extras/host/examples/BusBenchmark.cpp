@@ -0,0 +1,16 @@
+/*
+ * BusBenchmark.cpp - Runs the BusBenchmark sketch on the virtual Model 1
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+// The sketch is compiled unchanged; times are simulated CPU cycles at F_CPU
+#include "../../../examples/Model1/Benchmark/BusBenchmark/BusBenchmark.ino"
+
+#include "HostModel1.h"
+
+int main()
+{
+    setup();
+    return 0;
+}
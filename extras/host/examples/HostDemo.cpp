@@ -0,0 +1,236 @@
+/*
+ * HostDemo.cpp - Runs the library against the virtual Model 1 and checks the results
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include <Arduino.h>
+#include <Model1.h>
+#include <ROM.h>
+#include <Video.h>
+#include <Keyboard.h>
+#include <Cassette.h>
+#include <bus_timing.h>
+#include "HostModel1.h"
+
+static uint16_t failures = 0;
+
+// Report a single check
+static void check(const char *name, bool passed)
+{
+    Serial.print(passed ? F("  PASS  ") : F("  FAIL  "));
+    Serial.println(name);
+    if (!passed)
+        failures++;
+}
+
+// DRAM refresh, exactly as in the sketches
+ISR(TIMER2_COMPA_vect)
+{
+    Model1.nextUpdate();
+}
+
+// Synthetic ROM image so the checksum is known
+static void loadTestROM()
+{
+    static uint8_t image[HOST_ROM_SIZE];
+    for (uint16_t i = 0; i < HOST_ROM_SIZE; i++)
+        image[i] = (uint8_t)(i * 7 + (i >> 8));
+    HostModel1.loadROM(image, HOST_ROM_SIZE);
+}
+
+// Expected checksum of the synthetic ROM
+static uint16_t expectedROMChecksum(uint16_t start, uint16_t length)
+{
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < length; i++)
+        sum += HostModel1.peek(start + i);
+    return sum;
+}
+
+static void testMemory()
+{
+    Serial.println(F("Memory"));
+
+    Model1.writeMemory(0x4000, 0xA5);
+    check("Single byte write lands in DRAM", HostModel1.peek(0x4000) == 0xA5);
+    check("Single byte read returns DRAM", Model1.readMemory(0x4000) == 0xA5);
+
+    uint8_t pattern[64];
+    for (uint8_t i = 0; i < sizeof(pattern); i++)
+        pattern[i] = i ^ 0x5A;
+    Model1.writeMemoryFrom(0x7F00, pattern, sizeof(pattern));
+    uint8_t buffer[64] = {};
+    Model1.readMemoryInto(0x7F00, buffer, sizeof(buffer));
+    check("Block transfer round-trips", memcmp(pattern, buffer, sizeof(pattern)) == 0);
+
+    Model1.fillMemory(0xEE, 0xC000, 0x100);
+    bool filled = true;
+    for (uint16_t i = 0; i < 0x100; i++)
+        filled &= HostModel1.peek(0xC000 + i) == 0xEE;
+    check("Fill covers the range", filled);
+}
+
+static void testROM()
+{
+    Serial.println(F("ROM"));
+
+    ROM rom;
+    bool matches = true;
+    for (uint8_t i = 0; i < 3; i++)
+        matches &= rom.getChecksum(i) == expectedROMChecksum(rom.getROMStartAddress(i), rom.getROMLength(i));
+    check("Checksums match the loaded image", matches);
+}
+
+static void testVideo()
+{
+    Serial.println(F("Video"));
+
+    Video video;
+    video.cls();
+    video.print(0, 0, "HELLO HOST");
+    check("Text appears in video RAM", HostModel1.peek(0x3C00) == 'H' && HostModel1.peek(0x3C09) == 'T');
+    check("Screen is cleared with spaces", HostModel1.peek(0x3FFF) == ' ');
+
+    video.enableShadow();
+    video.print(0, 1, "SHADOW");
+    check("Shadow output waits for flush", HostModel1.peek(0x3C40) == ' ' && video.isDirty());
+    video.flush();
+    check("Flush writes the shadow buffer", HostModel1.peek(0x3C40) == 'S' && HostModel1.peek(0x3C45) == 'W' && !video.isDirty());
+    video.disableShadow();
+}
+
+static void testKeyboard()
+{
+    Serial.println(F("Keyboard"));
+
+    Keyboard keyboard;
+    keyboard.update();
+    check("No key pressed", !keyboard.isKeyPressed());
+
+    HostModel1.pressKey(0, 1); // 'a'
+    check("Pressed key is seen", keyboard.isKeyPressed());
+    check("Key value is 'a'", keyboard.getFirstJustPressedKey() == 'a');
+
+    HostModel1.releaseAllKeys();
+    keyboard.update();
+    check("Key release is seen", !keyboard.isKeyPressed());
+}
+
+static void testCassette()
+{
+    Serial.println(F("Cassette"));
+
+    Cassette cassette;
+    cassette.set32CharacterMode();
+    check("32 character mode latched", !HostModel1.is64CharacterMode() && !cassette.is64CharacterMode());
+    cassette.set64CharacterMode();
+    check("64 character mode latched", HostModel1.is64CharacterMode() && cassette.is64CharacterMode());
+}
+
+static void testTiming()
+{
+    Serial.println(F("Timing"));
+
+    HostModel1.resetStatistics();
+    delay(100);
+    HostBusStatistics statistics = HostModel1.getStatistics();
+    check("Refresh runs in the background", statistics.refreshes > 100);
+    check("No DRAM row starved for 2 ms", statistics.maxRefreshGap < 2UL * (F_CPU / 1000UL));
+    check("No bus cycle without TEST*", statistics.accessesWithoutTest == 0);
+}
+
+// Z80 program: IM 2 with the table at 0x2000, then count at 0x4800 forever;
+// the handler for vector 0x42 counts at 0x4801
+static void loadZ80Program()
+{
+    static const uint8_t program[] = {
+        0x31, 0x00, 0x50, // LD SP,0x5000
+        0xED, 0x5E,       // IM 2
+        0x3E, 0x20,       // LD A,0x20
+        0xED, 0x47,       // LD I,A
+        0xFB,             // EI
+        0x21, 0x00, 0x48, // LD HL,0x4800
+        0x34,             // loop: INC (HL)
+        0x18, 0xFD};      // JR loop
+    static const uint8_t handler[] = {
+        0x3A, 0x01, 0x48, // LD A,(0x4801)
+        0x3C,             // INC A
+        0x32, 0x01, 0x48, // LD (0x4801),A
+        0xFB,             // EI
+        0xED, 0x4D};      // RETI
+
+    for (uint8_t i = 0; i < sizeof(program); i++)
+        HostModel1.poke(i, program[i]);
+    for (uint8_t i = 0; i < sizeof(handler); i++)
+        HostModel1.poke(0x0100 + i, handler[i]);
+    HostModel1.poke(0x2042, 0x00);
+    HostModel1.poke(0x2043, 0x01);
+}
+
+static void testZ80()
+{
+    Serial.println(F("Z80"));
+
+    loadZ80Program();
+    HostModel1.poke(0x4800, 0);
+    HostModel1.poke(0x4801, 0);
+    HostModel1.setTestMod(true);
+    HostModel1.enableZ80();
+    delay(1);
+    check("Z80 runs the program", HostModel1.peek(0x4800) != 0);
+
+    Model1.activateTestSignal();
+    uint8_t count = Model1.readMemory(0x4800);
+    delay(1);
+    HostZ80Statistics statistics = HostModel1.getZ80Statistics();
+    check("TEST* is answered with BUSACK*", HostModel1.isBusAcknowledged() && statistics.busRequests == 1);
+    check("Z80 stands still while the Arduino owns the bus", Model1.readMemory(0x4800) == count);
+    check("BUSACK* comes within the TEST* settle time",
+          statistics.lastBusAckDelay <= (uint64_t)M1_TEST_SETTLE_NS * (F_CPU / 1000000UL) / 1000UL);
+    check("No Arduino access lost with the TEST* mod", statistics.lostAccesses == 0);
+    Model1.deactivateTestSignal();
+
+    bool taken = Model1.triggerInterrupt(0x42);
+    delay(1);
+    statistics = HostModel1.getZ80Statistics();
+    check("Interrupt is acknowledged", taken && statistics.interrupts == 1);
+    check("IM 2 handler is reached through the vector", statistics.lastVector == 0x42 && HostModel1.peek(0x4801) == 1);
+}
+
+int main()
+{
+    Serial.begin(115200);
+    Serial.println(F("TRS-80 Model 1 library on the virtual Model 1"));
+
+    loadTestROM();
+    Model1.begin(2);
+    Model1.activateTestSignal();
+
+    testMemory();
+    testROM();
+    testVideo();
+    testKeyboard();
+    testCassette();
+    testTiming();
+
+    // Show how a single read looks on the bus
+    Serial.println();
+    Serial.println(F("Signal trace of readMemory(0x4000):"));
+    HostModel1.startRecording(64);
+    Model1.readMemory(0x4000);
+    HostModel1.stopRecording();
+    HostModel1.printRecording(Serial);
+
+    Model1.deactivateTestSignal();
+
+    testZ80();
+
+    Serial.println();
+    HostModel1.printStatistics(Serial);
+
+    Serial.println();
+    Serial.print(failures);
+    Serial.println(F(" failure(s)"));
+    return failures ? 1 : 0;
+}
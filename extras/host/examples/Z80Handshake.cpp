@@ -0,0 +1,225 @@
+/*
+ * Z80Handshake.cpp - Measures the TEST* and INT* handshakes against the simulated Z80
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * Usage: Z80Handshake [rom-image]
+ *
+ * Runs the library's bus handshakes against the Z80 of the virtual Model 1:
+ *
+ * - Sweeps the moment TEST* is asserted over every cycle of a Z80 loop, on a
+ *   board without and with the TEST* mod, and counts the Z80 bus cycles cut
+ *   off and the runs in which the Z80 program crashed.
+ * - Measures how long the Z80 takes to answer TEST* with BUSACK* and how long
+ *   activateTestSignal()/deactivateTestSignal() take.
+ * - Measures the interrupt latency of triggerInterrupt().
+ *
+ * Without a ROM image, a keyboard polling loop like the idle loop of the
+ * Level II ROM runs. With a ROM image, the ROM boots and is interrupted in
+ * whatever it does after 20 ms; crashes cannot be told apart then and only
+ * the cut off cycles are counted.
+ */
+
+#include <Arduino.h>
+#include <Model1.h>
+#include "HostModel1.h"
+
+#define SWEEP_PHASES 262          // Cycles of one pass through the polling loop (29 T-states)
+#define PROGRAM_RUN_IN_CYCLES 1000 // Time the test program runs before TEST*
+#define ROM_RUN_IN_MS 20           // Time the ROM runs before TEST*
+#define SETTLE_CYCLES 5000         // Time the Z80 runs after TEST* before it is checked
+#define INTERRUPTS 100             // Interrupts triggered for the latency measurement
+
+// Result of one sweep
+struct SweepResult
+{
+    uint16_t corrupted;  // Runs with at least one Z80 bus cycle cut off
+    uint16_t crashed;    // Runs after which the program left its loop
+    uint32_t lost;       // Arduino bus cycles lost before BUSACK*
+    uint64_t minAck;     // Shortest TEST* to BUSACK* delay in cycles
+    uint64_t maxAck;     // Longest TEST* to BUSACK* delay in cycles
+    uint64_t totalAck;   // Sum of the BUSACK* delays
+    uint64_t handshake;  // Cycles of activateTestSignal() and deactivateTestSignal() of the last run
+};
+
+static bool useROM = false;
+
+// DRAM refresh, exactly as in the sketches
+ISR(TIMER2_COMPA_vect)
+{
+    Model1.nextUpdate();
+}
+
+// Test program: IM 2 with the table at 0x2000, then poll keyboard row 6 until
+// a key is pressed. Unused ROM reads 0xFF (RST 38), where the program halts.
+static void loadProgram()
+{
+    static const uint8_t program[] = {
+        0x31, 0x00, 0x50, // LD SP,0x5000
+        0xED, 0x5E,       // IM 2
+        0x3E, 0x20,       // LD A,0x20
+        0xED, 0x47,       // LD I,A
+        0xFB,             // EI
+        0x3A, 0x40, 0x38, // loop: LD A,(0x3840)
+        0xB7,             // OR A
+        0x28, 0xFA,       // JR Z,loop
+        0x76};            // HALT
+    static const uint8_t handler[] = {
+        0xF5,             // PUSH AF
+        0x3A, 0x01, 0x48, // LD A,(0x4801)
+        0x3C,             // INC A
+        0x32, 0x01, 0x48, // LD (0x4801),A
+        0xF1,             // POP AF
+        0xFB,             // EI
+        0xED, 0x4D};      // RETI
+
+    for (uint8_t i = 0; i < sizeof(program); i++)
+        HostModel1.poke(i, program[i]);
+    for (uint8_t i = 0; i < sizeof(handler); i++)
+        HostModel1.poke(0x0100 + i, handler[i]);
+    HostModel1.poke(0x0038, 0x76); // HALT
+    HostModel1.poke(0x2042, 0x00);
+    HostModel1.poke(0x2043, 0x01);
+}
+
+// Program still polling the keyboard
+static bool isInLoop()
+{
+    HostZ80 &z80 = HostModel1.getZ80();
+    return !z80.isHalted() && z80.registers.pc >= 0x000A && z80.registers.pc < 0x0010;
+}
+
+// Assert TEST* at every cycle of the loop once and do a few bus cycles
+static SweepResult sweep(bool testMod)
+{
+    SweepResult result = {0, 0, 0, UINT64_MAX, 0, 0, 0};
+    HostModel1.setTestMod(testMod);
+
+    for (uint16_t phase = 0; phase < SWEEP_PHASES; phase++)
+    {
+        HostModel1.resetZ80();
+        if (useROM)
+            delay(ROM_RUN_IN_MS);
+        HostModel1.advance(PROGRAM_RUN_IN_CYCLES + phase);
+
+        HostZ80Statistics before = HostModel1.getZ80Statistics();
+        uint64_t start = HostModel1.getCycles();
+
+        Model1.activateTestSignal();
+        Model1.writeMemory(0x4800, (uint8_t)phase);
+        Model1.readMemory(0x4800);
+        Model1.deactivateTestSignal();
+
+        result.handshake = HostModel1.getCycles() - start;
+        HostModel1.advance(SETTLE_CYCLES);
+        HostZ80Statistics after = HostModel1.getZ80Statistics();
+
+        if (after.corruptedCycles != before.corruptedCycles)
+            result.corrupted++;
+        if (!useROM && !isInLoop())
+            result.crashed++;
+        result.lost += after.lostAccesses - before.lostAccesses;
+
+        if (after.busRequests != before.busRequests)
+        {
+            uint64_t ack = after.lastBusAckDelay;
+            result.totalAck += ack;
+            if (ack < result.minAck)
+                result.minAck = ack;
+            if (ack > result.maxAck)
+                result.maxAck = ack;
+        }
+    }
+
+    return result;
+}
+
+// Nanoseconds of a number of cycles
+static unsigned long toNanoseconds(uint64_t cycles)
+{
+    return (unsigned long)(cycles * 1000000000ULL / F_CPU);
+}
+
+// Print the result of one sweep
+static void printSweep(const char *title, const SweepResult &result)
+{
+    Serial.printf("%s\n", title);
+    Serial.printf("  Cycles cut off:   %u of %u runs (%u%%)\n",
+                  result.corrupted, SWEEP_PHASES, (unsigned)(result.corrupted * 100UL / SWEEP_PHASES));
+    if (!useROM)
+        Serial.printf("  Program crashed:  %u of %u runs (%u%%)\n",
+                      result.crashed, SWEEP_PHASES, (unsigned)(result.crashed * 100UL / SWEEP_PHASES));
+    Serial.printf("  Lost accesses:    %lu\n", (unsigned long)result.lost);
+    Serial.printf("  BUSACK* delay:    %lu / %lu / %lu ns (min / mean / max)\n",
+                  toNanoseconds(result.minAck), toNanoseconds(result.totalAck / SWEEP_PHASES), toNanoseconds(result.maxAck));
+    Serial.printf("  Handshake:        %lu ns (activate, 2 bus cycles, deactivate)\n", toNanoseconds(result.handshake));
+}
+
+// Trigger interrupts at different points of the loop
+static void measureInterrupts()
+{
+    HostModel1.resetZ80();
+    HostModel1.advance(PROGRAM_RUN_IN_CYCLES);
+    HostModel1.resetStatistics();
+
+    uint64_t total = 0;
+    uint64_t longest = 0;
+    uint16_t taken = 0;
+    for (uint16_t i = 0; i < INTERRUPTS; i++)
+    {
+        HostModel1.advance(1000 + i * 7);
+
+        uint64_t start = HostModel1.getCycles();
+        if (Model1.triggerInterrupt(0x42))
+            taken++;
+        uint64_t duration = HostModel1.getCycles() - start;
+
+        total += duration;
+        if (duration > longest)
+            longest = duration;
+    }
+    HostModel1.advance(SETTLE_CYCLES);
+
+    HostZ80Statistics statistics = HostModel1.getZ80Statistics();
+    Serial.printf("Interrupts (IM 2, vector 0x42)\n");
+    Serial.printf("  Acknowledged:     %u of %u, handler ran %u times\n", taken, INTERRUPTS, HostModel1.peek(0x4801));
+    Serial.printf("  INT* to vector:   %lu ns max\n", toNanoseconds(statistics.maxInterruptDelay));
+    Serial.printf("  triggerInterrupt: %lu ns mean, %lu ns max\n", toNanoseconds(total / INTERRUPTS), toNanoseconds(longest));
+}
+
+int main(int argc, char **argv)
+{
+    Serial.begin(115200);
+
+    if (argc > 1)
+    {
+        if (!HostModel1.loadROMFile(argv[1]))
+        {
+            Serial.printf("Cannot read ROM image %s\n", argv[1]);
+            return 1;
+        }
+        useROM = true;
+    }
+    else
+    {
+        loadProgram();
+    }
+
+    Model1.begin(2);
+    HostModel1.enableZ80();
+
+    Serial.printf("TEST* asserted at %u points of the %s\n\n", SWEEP_PHASES, useROM ? "ROM" : "keyboard polling loop");
+    printSweep("Without the TEST* mod", sweep(false));
+    Serial.println();
+    printSweep("With the TEST* mod (BUSACK* gates the buffers)", sweep(true));
+
+    if (!useROM)
+    {
+        Serial.println();
+        measureInterrupts();
+    }
+
+    return 0;
+}
@@ -49,8 +49,7 @@ void AddressBus::writeMemoryAddress(uint16_t address)
 {
     if (!_writable)
     {
-        if (_logger)
-            _logger->errF(F("Address bus is not writable."));
+        M1_LOG_ERR(_logger, "Address bus is not writable.");
         return;
     }
     Model1LowLevel::writeAddressBus(address);
@@ -73,8 +72,7 @@ void AddressBus::writeIOAddress(uint8_t address)
 {
     if (!_writable)
     {
-        if (_logger)
-            _logger->errF(F("IO address bus is not writable."));
+        M1_LOG_ERR(_logger, "IO address bus is not writable.");
         return;
     }
     Model1LowLevel::writeAddressBus(address);
@@ -111,10 +109,7 @@ char *AddressBus::getState()
     char *buffer = (char *)malloc(LEN);
     if (!buffer)
     {
-        if (_logger)
-        {
-            _logger->errF(F("AddressBus: Failed to allocate memory for state string"));
-        }
+        M1_LOG_ERR(_logger, "AddressBus: Failed to allocate memory for state string");
         return nullptr;
     }
     char addrChars[17];
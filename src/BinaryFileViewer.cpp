@@ -6,6 +6,7 @@
 
 #include "BinaryFileViewer.h"
 #include "M1Shield.h"
+#include "MemoryDiagnostics.h"
 
 // Constructor
 BinaryFileViewer::BinaryFileViewer(const char *filename)
@@ -72,7 +73,7 @@ bool BinaryFileViewer::_loadCurrentPage()
     if (_bufferSize == 0)
     {
         _bufferSize = _getPageSize();
-        _pageBuffer = (uint8_t *)malloc(_bufferSize);
+        _pageBuffer = (uint8_t *)MemoryDiagnostics.allocate(_bufferSize, MEMORY_TAG_VIEWER);
         if (!_pageBuffer)
         {
             return false;
@@ -95,7 +96,7 @@ void BinaryFileViewer::_freePageBuffer()
 {
     if (_pageBuffer)
     {
-        free(_pageBuffer);
+        MemoryDiagnostics.release(_pageBuffer, MEMORY_TAG_VIEWER);
         _pageBuffer = nullptr;
         _bufferSize = 0;
         _bytesInBuffer = 0;
@@ -0,0 +1,312 @@
+/*
+ * BusJob.cpp - Resumable bus transfers that advance in bounded chunks
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "BusJob.h"
+#include "Model1.h"
+#include "M1Shield.h"
+#include "Profiler.h"
+
+// Constructor
+BusJob::BusJob(uint16_t address, uint32_t length)
+{
+    _address = address;
+    _length = length > 0x10000UL ? 0x10000UL : length;
+    _offset = 0;
+    _chunkSize = BUS_JOB_CHUNK_SIZE;
+    _state = BUS_JOB_READY;
+    _logger = nullptr;
+}
+
+// Set the logger for debugging output
+void BusJob::setLogger(ILogger &logger)
+{
+    _logger = &logger;
+}
+
+// Bytes moved per step; smaller chunks keep the loop responsive, larger ones are faster
+void BusJob::setChunkSize(uint16_t chunkSize)
+{
+    _chunkSize = chunkSize > 0 ? chunkSize : 1;
+}
+
+// Bytes moved per step
+uint16_t BusJob::getChunkSize()
+{
+    return _chunkSize;
+}
+
+// ----------------------------------------
+// ---------- Control
+// ----------------------------------------
+
+// Start from the beginning; a running job is not restarted
+bool BusJob::start()
+{
+    if (_state == BUS_JOB_RUNNING)
+        return false;
+
+    _offset = 0;
+    if (!_open(false))
+    {
+        _state = BUS_JOB_FAILED;
+        return false;
+    }
+
+    _state = BUS_JOB_RUNNING;
+    return true;
+}
+
+// Continue a failed or cancelled job at its checkpoint
+bool BusJob::resume()
+{
+    if (_state != BUS_JOB_FAILED && _state != BUS_JOB_CANCELLED)
+        return false;
+
+    if (!_open(true))
+        return false;
+
+    M1_LOG_INFO(_logger, "BusJob: Resuming at 0x%04X, %lu of %lu bytes done",
+                (uint16_t)(_address + _offset), (unsigned long)_offset, (unsigned long)_length);
+
+    _state = BUS_JOB_RUNNING;
+    return true;
+}
+
+// Stop a running job; the checkpoint is kept for resume()
+void BusJob::cancel()
+{
+    if (_state != BUS_JOB_RUNNING)
+        return;
+
+    _close(false);
+    _state = BUS_JOB_CANCELLED;
+
+    M1_LOG_INFO(_logger, "BusJob: Cancelled at 0x%04X, %lu of %lu bytes done",
+                (uint16_t)(_address + _offset), (unsigned long)_offset, (unsigned long)_length);
+}
+
+// Stop after an error; the chunk that failed is done again on resume()
+void BusJob::_fail()
+{
+    _close(false);
+    _state = BUS_JOB_FAILED;
+
+    M1_LOG_ERR(_logger, "BusJob: Failed at 0x%04X, %lu of %lu bytes done",
+               (uint16_t)(_address + _offset), (unsigned long)_offset, (unsigned long)_length);
+}
+
+// Move the checkpoint; only used by jobs while opening
+void BusJob::_setOffset(uint32_t offset)
+{
+    _offset = offset > _length ? _length : offset;
+}
+
+// ----------------------------------------
+// ---------- Stepping
+// ----------------------------------------
+
+// Move one chunk, holding TEST* only for the chunk unless the caller holds it
+BusJobState BusJob::step()
+{
+    if (_state != BUS_JOB_RUNNING)
+        return _state;
+
+    if (_offset < _length)
+    {
+        M1_PROFILE("BusJob::step");
+
+        uint32_t remaining = _length - _offset;
+        uint16_t length = remaining < _chunkSize ? (uint16_t)remaining : _chunkSize;
+
+        bool claimed = !Model1.hasActiveTestSignal();
+        if (claimed)
+            Model1.activateTestSignal();
+
+        bool success = _transfer(_address + _offset, length);
+
+        if (claimed)
+            Model1.deactivateTestSignal();
+
+        if (!success)
+        {
+            _fail();
+            return _state;
+        }
+
+        _offset += length;
+    }
+
+    if (_offset >= _length)
+    {
+        _close(true);
+        _state = BUS_JOB_DONE;
+    }
+
+    return _state;
+}
+
+// Step until the task budget is used up; the scheduler removes the job once it stops running
+bool BusJob::run()
+{
+    while (step() == BUS_JOB_RUNNING)
+    {
+        if (TaskScheduler.shouldYield())
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------
+// ---------- Progress
+// ----------------------------------------
+
+// Current state
+BusJobState BusJob::getState()
+{
+    return _state;
+}
+
+// Started and not finished, failed or cancelled
+bool BusJob::isRunning()
+{
+    return _state == BUS_JOB_RUNNING;
+}
+
+// First address
+uint16_t BusJob::getAddress()
+{
+    return _address;
+}
+
+// Bytes to move
+uint32_t BusJob::getLength()
+{
+    return _length;
+}
+
+// Bytes completed; the checkpoint resume() continues from
+uint32_t BusJob::getOffset()
+{
+    return _offset;
+}
+
+// Percent completed (0-100)
+uint8_t BusJob::getProgress()
+{
+    if (_length == 0)
+        return 100;
+    return (uint8_t)(_offset * 100UL / _length);
+}
+
+// ----------------------------------------
+// ---------- MemoryDumpJob
+// ----------------------------------------
+
+// Constructor
+MemoryDumpJob::MemoryDumpJob(uint16_t address, uint32_t length, const char *filename) : BusJob(address, length)
+{
+    _filename = filename;
+    _base = 0;
+}
+
+// Open the file for appending; on resume, continue after the data that reached the card
+bool MemoryDumpJob::_open(bool resume)
+{
+    if (!_filename)
+    {
+        M1_LOG_ERR(_logger, "MemoryDumpJob: No filename");
+        return false;
+    }
+
+    if (!SD.begin(M1Shield.getSDCardSelectPin()))
+    {
+        M1_LOG_ERR(_logger, "MemoryDumpJob: Failed to initialize SD card");
+        return false;
+    }
+
+    _file = SD.open(_filename, FILE_WRITE);
+    if (!_file)
+    {
+        M1_LOG_ERR(_logger, "MemoryDumpJob: Failed to open file %s for writing", _filename);
+        return false;
+    }
+
+    uint32_t size = _file.size();
+    if (!resume)
+    {
+        _base = size;
+        return true;
+    }
+
+    // The file was changed by someone else; the checkpoint cannot be trusted
+    if (size < _base)
+    {
+        M1_LOG_ERR(_logger, "MemoryDumpJob: %s is shorter than before, start again", _filename);
+        _file.close();
+        return false;
+    }
+
+    // Bytes of a failed chunk that made it to the card are kept, lost ones are read again
+    _setOffset(size - _base);
+    return true;
+}
+
+// Read a chunk from memory and append it to the file
+bool MemoryDumpJob::_transfer(uint16_t address, uint16_t length)
+{
+    uint8_t buffer[BUS_JOB_BUFFER_SIZE];
+
+    while (length > 0)
+    {
+        uint16_t size = length < BUS_JOB_BUFFER_SIZE ? length : BUS_JOB_BUFFER_SIZE;
+
+        if (!Model1.readMemoryInto(address, buffer, size))
+        {
+            M1_LOG_ERR(_logger, "MemoryDumpJob: Failed to read memory at address 0x%04X", address);
+            return false;
+        }
+
+        size_t written = _file.write(buffer, size);
+        if (written != size)
+        {
+            M1_LOG_ERR(_logger, "MemoryDumpJob: Failed to write to %s (wrote %u of %u bytes)",
+                       _filename, (unsigned)written, size);
+            return false;
+        }
+
+        address += size;
+        length -= size;
+    }
+
+    return true;
+}
+
+// Close the file; everything written so far stays on the card
+void MemoryDumpJob::_close(bool finished)
+{
+    if (_file)
+        _file.close();
+
+    if (finished)
+        M1_LOG_INFO(_logger, "MemoryDumpJob: Dumped %lu bytes to %s", (unsigned long)getLength(), _filename);
+}
+
+// ----------------------------------------
+// ---------- MemoryFillJob
+// ----------------------------------------
+
+// Constructor
+MemoryFillJob::MemoryFillJob(uint16_t address, uint32_t length, uint8_t value) : BusJob(address, length)
+{
+    _value = value;
+}
+
+// Fill a chunk using the burst write of Model1
+bool MemoryFillJob::_transfer(uint16_t address, uint16_t length)
+{
+    Model1.fillMemory(_value, address, length);
+    return true;
+}
@@ -0,0 +1,127 @@
+/*
+ * BusJob.h - Resumable bus transfers that advance in bounded chunks
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * A BusJob moves a range of Model 1 memory a chunk at a time instead of in
+ * one blocking call, so the shield stays responsive during transfers that
+ * take seconds:
+ *
+ *     MemoryDumpJob dump(0x0000, 0x3000, "rom.bin");
+ *     dump.start();
+ *     TaskScheduler.addTask(F("Dump"), dump, 0, 2000, TASK_PRIORITY_LOW);
+ *
+ * Every step() moves at most getChunkSize() bytes, claiming the bus with
+ * TEST* only for that chunk unless the caller already holds it. As a Task,
+ * a job steps until its budget is used up (TaskScheduler::shouldYield()).
+ *
+ * The offset of the last completed chunk is the checkpoint. A job that
+ * failed or was cancelled continues from there with resume(); a
+ * MemoryDumpJob resumes at the end of the data that actually reached the
+ * card.
+ */
+
+#ifndef BUSJOB_H
+#define BUSJOB_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "ILogger.h"
+#include "TaskScheduler.h"
+
+// Default number of bytes moved per step
+#ifndef BUS_JOB_CHUNK_SIZE
+#define BUS_JOB_CHUNK_SIZE 64
+#endif
+
+// Bytes a MemoryDumpJob reads from the bus at once (buffer on the stack)
+#define BUS_JOB_BUFFER_SIZE 64
+
+// State of a job
+enum BusJobState : uint8_t
+{
+    BUS_JOB_READY,     // Not started yet
+    BUS_JOB_RUNNING,   // Started, more chunks to move
+    BUS_JOB_DONE,      // All bytes moved
+    BUS_JOB_FAILED,    // Stopped by an error; can be resumed
+    BUS_JOB_CANCELLED, // Stopped by cancel(); can be resumed
+};
+
+// Transfer of a memory range in chunks
+class BusJob : public Task
+{
+private:
+    uint16_t _address;   // First address
+    uint32_t _length;    // Bytes to move, up to 64K
+    uint32_t _offset;    // Bytes completed (checkpoint)
+    uint16_t _chunkSize; // Bytes moved per step
+    BusJobState _state;  // Current state
+
+    void _fail(); // Stop after an error
+
+protected:
+    ILogger *_logger; // Logger instance for debugging output
+
+    virtual bool _open(bool resume) { return true; }               // Acquire resources; on resume the checkpoint may be moved
+    virtual bool _transfer(uint16_t address, uint16_t length) = 0; // Move one chunk with the bus held; false on error
+    virtual void _close(bool finished) {}                          // Release resources
+
+    void _setOffset(uint32_t offset); // Move the checkpoint, e.g. to the data that reached the card
+
+public:
+    BusJob(uint16_t address, uint32_t length); // Constructor
+    virtual ~BusJob() = default;
+
+    void setLogger(ILogger &logger); // Set logger for debugging output
+
+    void setChunkSize(uint16_t chunkSize); // Bytes moved per step (default BUS_JOB_CHUNK_SIZE)
+    uint16_t getChunkSize();               // Bytes moved per step
+
+    bool start();  // Start from the beginning
+    bool resume(); // Continue a failed or cancelled job at its checkpoint
+    void cancel(); // Stop a running job
+
+    BusJobState step();  // Move one chunk; returns the new state
+    bool run() override; // Step until the task budget is used up; false when no longer running
+
+    BusJobState getState(); // Current state
+    bool isRunning();       // Started and not finished, failed or cancelled
+    uint16_t getAddress();  // First address
+    uint32_t getLength();   // Bytes to move
+    uint32_t getOffset();   // Bytes completed
+    uint8_t getProgress();  // Percent completed (0-100), for ContentScreen::setProgressValue()
+};
+
+// Dump a memory range to a file on the SD card; appends like Model1::dumpMemoryToSD()
+class MemoryDumpJob : public BusJob
+{
+private:
+    const char *_filename; // File name, owned by the caller
+    File _file;            // Open file while running
+    uint32_t _base;        // File size before the job started
+
+protected:
+    bool _open(bool resume) override;
+    bool _transfer(uint16_t address, uint16_t length) override;
+    void _close(bool finished) override;
+
+public:
+    MemoryDumpJob(uint16_t address, uint32_t length, const char *filename); // Constructor
+};
+
+// Fill a memory range with one byte value
+class MemoryFillJob : public BusJob
+{
+private:
+    uint8_t _value; // Fill byte
+
+protected:
+    bool _transfer(uint16_t address, uint16_t length) override;
+
+public:
+    MemoryFillJob(uint16_t address, uint32_t length, uint8_t value); // Constructor
+};
+
+#endif // BUSJOB_H
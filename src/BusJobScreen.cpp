@@ -0,0 +1,146 @@
+/*
+ * BusJobScreen.cpp - ContentScreen running a BusJob with progress bar and cancel button
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "BusJobScreen.h"
+#include "M1Shield.h"
+#include "TaskScheduler.h"
+
+#define BUS_JOB_SCREEN_LINE_HEIGHT 10 // Text size 1 plus spacing
+
+// Constructor
+BusJobScreen::BusJobScreen(BusJob &job, const __FlashStringHelper *title) : _job(job)
+{
+    _lastState = job.getState();
+    _lastProgress = job.getProgress();
+    _taskId = -1;
+
+    setTitleF(title);
+
+    const char *buttons[] = {"M:Cancel", "Sel:Resume"};
+    setButtonItems(buttons, 2);
+}
+
+// Add the job to the scheduler; it removes the job again when it stops running
+void BusJobScreen::_schedule()
+{
+    _taskId = TaskScheduler.addTask(F("BusJob"), _job, 0, BUS_JOB_SCREEN_BUDGET_US, TASK_PRIORITY_LOW);
+    if (_taskId < 0)
+    {
+        _job.cancel();
+        notifyF(F("No free task slot"), 3000, 0xF800);
+    }
+}
+
+// Start the job unless it already runs
+bool BusJobScreen::open()
+{
+    if (_job.getState() == BUS_JOB_READY)
+    {
+        if (_job.start())
+            _schedule();
+    }
+
+    _lastState = _job.getState();
+    _lastProgress = _job.getProgress();
+    setProgressValue(_lastProgress);
+
+    return ContentScreen::open();
+}
+
+// Redraw the bar when the progress changes and the content when the state changes
+void BusJobScreen::loop()
+{
+    ContentScreen::loop();
+
+    if (!isActive())
+        return;
+
+    uint8_t progress = _job.getProgress();
+    BusJobState state = _job.getState();
+
+    if (progress != _lastProgress)
+    {
+        _lastProgress = progress;
+        setProgressValue(progress);
+    }
+
+    if (state != _lastState)
+    {
+        _lastState = state;
+        clearContentArea();
+        _drawContent();
+        M1Shield.display();
+
+        if (state == BUS_JOB_DONE)
+            notifyF(F("Done"));
+        else if (state == BUS_JOB_FAILED)
+            notifyF(F("Failed, Sel to resume"), 3000, 0xF800);
+    }
+}
+
+// Draw range, bytes done and state
+void BusJobScreen::_drawContent()
+{
+    char line[32];
+    uint32_t last = _job.getLength() ? _job.getAddress() + _job.getLength() - 1 : _job.getAddress();
+
+    snprintf(line, sizeof(line), "0x%04X-0x%04X", _job.getAddress(), (unsigned)(last & 0xFFFF));
+    drawText(0, 0, line, 0xFFFF, 1);
+
+    snprintf(line, sizeof(line), "%lu of %lu bytes", (unsigned long)_job.getOffset(), (unsigned long)_job.getLength());
+    drawText(0, BUS_JOB_SCREEN_LINE_HEIGHT, line, 0xFFFF, 1);
+
+    switch (_job.getState())
+    {
+    case BUS_JOB_READY:
+        drawTextF(0, 2 * BUS_JOB_SCREEN_LINE_HEIGHT, F("Not started"), 0xFFFF, 1);
+        break;
+    case BUS_JOB_RUNNING:
+        drawTextF(0, 2 * BUS_JOB_SCREEN_LINE_HEIGHT, F("Running"), 0xFFE0, 1);
+        break;
+    case BUS_JOB_DONE:
+        drawTextF(0, 2 * BUS_JOB_SCREEN_LINE_HEIGHT, F("Done"), 0x07E0, 1);
+        break;
+    case BUS_JOB_FAILED:
+        drawTextF(0, 2 * BUS_JOB_SCREEN_LINE_HEIGHT, F("Failed"), 0xF800, 1);
+        break;
+    case BUS_JOB_CANCELLED:
+        drawTextF(0, 2 * BUS_JOB_SCREEN_LINE_HEIGHT, F("Cancelled"), 0xF800, 1);
+        break;
+    }
+}
+
+// Menu cancels a running job, select resumes a failed or cancelled one
+Screen *BusJobScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY)
+{
+    (void)offsetX; // Parameter not used
+    (void)offsetY; // Parameter not used
+
+    if (!isActive())
+        return nullptr;
+
+    if (action & BUTTON_MENU)
+    {
+        // A running job started here is still scheduled; remove it so a resume does not add it twice
+        if (_job.isRunning())
+        {
+            _job.cancel();
+            if (_taskId >= 0)
+                TaskScheduler.removeTask(_taskId);
+            _taskId = -1;
+        }
+        return nullptr;
+    }
+
+    if (action & (BUTTON_SELECT | BUTTON_JOYSTICK))
+    {
+        if (_job.resume())
+            _schedule();
+        return nullptr;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,41 @@
+/*
+ * BusJobScreen.h - ContentScreen running a BusJob with progress bar and cancel button
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef BUSJOBSCREEN_H
+#define BUSJOBSCREEN_H
+
+#include <Arduino.h>
+#include "ContentScreen.h"
+#include "BusJob.h"
+
+// Time budget of the job task per pass of M1Shield::loop()
+#ifndef BUS_JOB_SCREEN_BUDGET_US
+#define BUS_JOB_SCREEN_BUDGET_US 2000
+#endif
+
+// Runs a job as a low priority task and shows its progress; menu cancels, select resumes
+class BusJobScreen : public ContentScreen
+{
+private:
+    BusJob &_job;           // Job shown, owned by the caller
+    BusJobState _lastState; // State when the content was last drawn
+    uint8_t _lastProgress;  // Progress when the bar was last drawn
+    int8_t _taskId;         // Task of the running job, -1 if not scheduled by this screen
+
+    void _schedule(); // Add the job to the TaskScheduler
+
+public:
+    BusJobScreen(BusJob &job, const __FlashStringHelper *title); // Constructor, sets title and button items
+
+    bool open() override; // Start the job unless it already runs
+    void loop() override; // Follow progress and state
+    Screen *actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY) override;
+
+protected:
+    void _drawContent() override; // Draw range, bytes done and state
+};
+
+#endif /* BUSJOBSCREEN_H */
@@ -0,0 +1,482 @@
+/*
+ * BusTrace.cpp - Class for recording TRS-80 Model 1 bus signal transitions
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "BusTrace.h"
+#include <SD.h>
+#include "M1Shield.h"
+#include "bus_timing.h"
+#include "cycle_counter.h"
+#include "MemoryDiagnostics.h"
+#include "Profiler.h"
+
+// Number of VCD variables: 7 control signals, address, data out, data in
+#define BUS_TRACE_VCD_VARIABLES 10
+#define BUS_TRACE_VCD_ADDRESS 7
+
+static const char signalRAS[] PROGMEM = "RAS";
+static const char signalCAS[] PROGMEM = "CAS";
+static const char signalMUX[] PROGMEM = "MUX";
+static const char signalRD[] PROGMEM = "RD";
+static const char signalWR[] PROGMEM = "WR";
+static const char signalIN[] PROGMEM = "IN";
+static const char signalOUT[] PROGMEM = "OUT";
+static const char signalAddressLow[] PROGMEM = "ADDRESS_LOW";
+static const char signalAddressHigh[] PROGMEM = "ADDRESS_HIGH";
+static const char signalDataOut[] PROGMEM = "DATA_OUT";
+static const char signalDataIn[] PROGMEM = "DATA_IN";
+
+static const char *const signalNames[BUS_TRACE_SIGNAL_COUNT] PROGMEM = {
+    signalRAS, signalCAS, signalMUX, signalRD, signalWR, signalIN, signalOUT,
+    signalAddressLow, signalAddressHigh, signalDataOut, signalDataIn};
+
+BusTraceClass BusTrace;
+
+// Constructor
+BusTraceClass::BusTraceClass()
+{
+    _logger = nullptr;
+    _events = nullptr;
+    _capacity = 0;
+    _head = 0;
+    _count = 0;
+    _dropped = 0;
+    _active = false;
+    _compensation = 0;
+    _overhead = 0;
+}
+
+// Set the logger for debugging output
+void BusTraceClass::setLogger(ILogger &logger)
+{
+    _logger = &logger;
+}
+
+// Allocate the ring buffer and start the cycle counter
+bool BusTraceClass::begin(uint16_t capacity)
+{
+#if !defined(M1_BUS_TRACE)
+    M1_LOG_ERR(_logger, "BusTrace: Library compiled without M1_BUS_TRACE");
+    return false;
+#else
+    end();
+
+    if (capacity < 2)
+    {
+        M1_LOG_ERR(_logger, "BusTrace: Capacity must be at least 2 events");
+        return false;
+    }
+
+    _events = (BusTraceEvent *)MemoryDiagnostics.allocate(capacity * sizeof(BusTraceEvent), MEMORY_TAG_TRACE);
+    if (!_events)
+    {
+        M1_LOG_ERR(_logger, "BusTrace: Not enough memory for %u events", capacity);
+        return false;
+    }
+    _capacity = capacity;
+
+    cycleCounterBegin();
+
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    _calibrate();
+    SREG = oldSREG;
+
+    clear();
+    return true;
+#endif
+}
+
+// Release the cycle counter and free the ring buffer
+void BusTraceClass::end()
+{
+    _active = false;
+
+    if (_events)
+    {
+        cycleCounterEnd();
+        MemoryDiagnostics.release(_events, MEMORY_TAG_TRACE);
+        _events = nullptr;
+    }
+    _capacity = 0;
+    _head = 0;
+    _count = 0;
+}
+
+// Measure how many cycles one record() call adds between two transitions
+void BusTraceClass::_calibrate()
+{
+    _overhead = 0;
+    _compensation = 0;
+    _head = 0;
+    _count = 0;
+
+    _active = true;
+    record(BUS_TRACE_SIGNAL_COUNT, 0);
+    record(BUS_TRACE_SIGNAL_COUNT, 0);
+    _active = false;
+
+    _overhead = _events[1].cycle - _events[0].cycle;
+}
+
+// ----------------------------------------
+// ---------- Recording
+// ----------------------------------------
+
+// Start recording
+void BusTraceClass::start()
+{
+    if (!_events)
+    {
+        M1_LOG_ERR(_logger, "BusTrace: start() called before begin()");
+        return;
+    }
+    _active = true;
+}
+
+// Stop recording
+void BusTraceClass::stop()
+{
+    _active = false;
+}
+
+// Discard all events
+void BusTraceClass::clear()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    _head = 0;
+    _count = 0;
+    _dropped = 0;
+    _compensation = 0;
+    SREG = oldSREG;
+}
+
+// Check if recording
+bool BusTraceClass::isActive()
+{
+    return _active;
+}
+
+// Store one event, overwriting the oldest when the buffer is full
+void BusTraceClass::_record(uint8_t signal, uint8_t value)
+{
+    // The overhead of all earlier calls is removed, so gaps match an untraced run
+    BusTraceEvent &event = _events[_head];
+    event.cycle = cycleCounterRead() - _compensation;
+    event.signal = signal;
+    event.value = value;
+    _compensation += _overhead;
+
+    if (++_head == _capacity)
+        _head = 0;
+    if (_count < _capacity)
+        _count++;
+    else
+        _dropped++;
+}
+
+// ----------------------------------------
+// ---------- Events
+// ----------------------------------------
+
+// Get the number of events in the buffer
+uint16_t BusTraceClass::getEventCount()
+{
+    return _count;
+}
+
+// Get the number of events lost because the buffer was full
+uint32_t BusTraceClass::getDroppedCount()
+{
+    return _dropped;
+}
+
+// Get an event by index, oldest first
+const BusTraceEvent &BusTraceClass::getEvent(uint16_t index)
+{
+    uint16_t oldest = (_count < _capacity) ? 0 : _head;
+    uint32_t position = (uint32_t)oldest + index;
+    if (position >= _capacity)
+        position -= _capacity;
+    return _events[position];
+}
+
+// Get the name of a signal
+const char *BusTraceClass::getSignalName(uint8_t signal)
+{
+    static char name[16];
+    if (signal >= BUS_TRACE_SIGNAL_COUNT)
+        return "?";
+    strncpy_P(name, (const char *)pgm_read_ptr(&signalNames[signal]), sizeof(name) - 1);
+    name[sizeof(name) - 1] = 0;
+    return name;
+}
+
+// Convert CPU cycles to nanoseconds
+uint32_t BusTraceClass::_toNanoseconds(uint32_t cycles)
+{
+    return (uint32_t)(((uint64_t)cycles * 1000000000ULL) / F_CPU);
+}
+
+// ----------------------------------------
+// ---------- Measurements
+// ----------------------------------------
+
+// Walk the trace; counts intervals shorter than a limit and returns the shortest one (ns).
+// With a qualifier, only intervals starting while that signal is LOW are measured.
+static uint32_t scanIntervals(BusTraceClass &trace, uint8_t fromSignal, uint16_t fromValue, uint8_t toSignal, uint16_t toValue,
+                              uint8_t qualifier, uint32_t limitNs, uint16_t *violations)
+{
+    uint8_t levels[BUS_TRACE_ADDRESS_LOW];
+    memset(levels, 0xFF, sizeof(levels)); // Unknown
+
+    uint32_t shortest = 0xFFFFFFFF;
+    uint32_t start = 0;
+    bool pending = false;
+    uint16_t count = trace.getEventCount();
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        const BusTraceEvent &event = trace.getEvent(i);
+
+        // Writes that repeat the current level are not transitions
+        if (event.signal < BUS_TRACE_ADDRESS_LOW)
+        {
+            if (levels[event.signal] == event.value)
+                continue;
+            levels[event.signal] = event.value;
+        }
+
+        if (pending && event.signal == toSignal && (toValue == BUS_TRACE_ANY_VALUE || event.value == toValue))
+        {
+            uint32_t ns = ((uint64_t)(event.cycle - start) * 1000000000ULL) / F_CPU;
+            if (ns < shortest)
+                shortest = ns;
+            if (violations && ns < limitNs)
+                (*violations)++;
+            pending = false;
+        }
+
+        if (event.signal == fromSignal && (fromValue == BUS_TRACE_ANY_VALUE || event.value == fromValue) &&
+            (qualifier >= BUS_TRACE_ADDRESS_LOW || levels[qualifier] == LOW))
+        {
+            start = event.cycle;
+            pending = true;
+        }
+    }
+
+    return shortest;
+}
+
+// Get the shortest time from a transition to the following matching transition
+uint32_t BusTraceClass::getMinimumTime(uint8_t fromSignal, uint16_t fromValue, uint8_t toSignal, uint16_t toValue)
+{
+    return scanIntervals(*this, fromSignal, fromValue, toSignal, toValue, BUS_TRACE_SIGNAL_COUNT, 0, nullptr);
+}
+
+// Check the trace against the DRAM and access timings of bus_timing.h
+uint16_t BusTraceClass::verifyDRAMTiming()
+{
+    struct Check
+    {
+        uint8_t fromSignal;
+        uint16_t fromValue;
+        uint8_t toSignal;
+        uint16_t toValue;
+        uint8_t qualifier;
+        uint16_t minimumNs;
+        const char *name;
+    };
+    static const char nameRAS[] PROGMEM = "tRAS";
+    static const char nameCAS[] PROGMEM = "tCAS";
+    static const char nameRP[] PROGMEM = "tRP";
+    static const char nameAccess[] PROGMEM = "read access";
+    const Check checks[] = {
+        {BUS_TRACE_RAS, LOW, BUS_TRACE_RAS, HIGH, BUS_TRACE_SIGNAL_COUNT, M1_DRAM_T_RAS_NS, nameRAS},
+        {BUS_TRACE_CAS, LOW, BUS_TRACE_CAS, HIGH, BUS_TRACE_SIGNAL_COUNT, M1_DRAM_T_CAS_NS, nameCAS},
+        {BUS_TRACE_RAS, HIGH, BUS_TRACE_RAS, LOW, BUS_TRACE_SIGNAL_COUNT, M1_DRAM_T_RP_NS, nameRP},
+        {BUS_TRACE_CAS, LOW, BUS_TRACE_DATA_IN, BUS_TRACE_ANY_VALUE, BUS_TRACE_RD, M1_READ_ACCESS_NS, nameAccess}};
+
+    uint16_t total = 0;
+    for (uint8_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++)
+    {
+        const Check &check = checks[i];
+        uint16_t violations = 0;
+        uint32_t shortest = scanIntervals(*this, check.fromSignal, check.fromValue, check.toSignal, check.toValue, check.qualifier, check.minimumNs, &violations);
+
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_WARN) && violations && _logger)
+        {
+            char name[16];
+            strncpy_P(name, check.name, sizeof(name) - 1);
+            name[sizeof(name) - 1] = '\0';
+            _logger->warnF(F("BusTrace: %s violated %u times, shortest %lu ns (minimum %u ns)"), name, violations, (unsigned long)shortest, check.minimumNs);
+        }
+        total += violations;
+    }
+
+    if (_dropped)
+        M1_LOG_WARN(_logger, "BusTrace: %lu events were overwritten; only the newest were checked", (unsigned long)_dropped);
+
+    return total;
+}
+
+// ----------------------------------------
+// ---------- Export
+// ----------------------------------------
+
+// Map a signal to its VCD variable
+static uint8_t vcdVariable(uint8_t signal)
+{
+    if (signal < BUS_TRACE_ADDRESS_LOW)
+        return signal;
+    if (signal <= BUS_TRACE_ADDRESS_HIGH)
+        return BUS_TRACE_VCD_ADDRESS;
+    return signal - 1;
+}
+
+// Write a VCD bus value; bits outside the known mask are written as x
+static void vcdPrintVector(Print &output, uint16_t value, uint16_t known, uint8_t bits, char id)
+{
+    output.print('b');
+    for (int8_t bit = bits - 1; bit >= 0; bit--)
+    {
+        uint16_t mask = 1 << bit;
+        output.print((known & mask) ? ((value & mask) ? '1' : '0') : 'x');
+    }
+    output.print(' ');
+    output.println(id);
+}
+
+// Write the trace as Value Change Dump
+bool BusTraceClass::exportVCD(Print &output)
+{
+    if (!_events || _count == 0)
+    {
+        M1_LOG_ERR(_logger, "BusTrace: No events to export");
+        return false;
+    }
+
+    // Header and variable definitions; identifiers start at '!'
+    output.println(F("$version TRS-80 Model 1 BusTrace $end"));
+    output.println(F("$timescale 1 ns $end"));
+    output.println(F("$scope module model1 $end"));
+    for (uint8_t variable = 0; variable < BUS_TRACE_VCD_VARIABLES; variable++)
+    {
+        uint8_t width = (variable < BUS_TRACE_VCD_ADDRESS) ? 1 : (variable == BUS_TRACE_VCD_ADDRESS) ? 16 : 8;
+        const char *name = (variable == BUS_TRACE_VCD_ADDRESS) ? "ADDRESS" : getSignalName(variable < BUS_TRACE_VCD_ADDRESS ? variable : variable + 1);
+        output.print(F("$var wire "));
+        output.print(width);
+        output.print(' ');
+        output.print((char)('!' + variable));
+        output.print(' ');
+        output.print(name);
+        output.println(F(" $end"));
+    }
+    output.println(F("$upscope $end"));
+    output.println(F("$enddefinitions $end"));
+
+    // Everything is unknown until the first transition
+    output.println(F("#0"));
+    output.println(F("$dumpvars"));
+    for (uint8_t variable = 0; variable < BUS_TRACE_VCD_VARIABLES; variable++)
+    {
+        if (variable < BUS_TRACE_VCD_ADDRESS)
+        {
+            output.print('x');
+            output.println((char)('!' + variable));
+        }
+        else
+        {
+            vcdPrintVector(output, 0, 0, (variable == BUS_TRACE_VCD_ADDRESS) ? 16 : 8, '!' + variable);
+        }
+    }
+    output.println(F("$end"));
+
+    uint8_t levels[BUS_TRACE_ADDRESS_LOW];
+    memset(levels, 0xFF, sizeof(levels));
+    uint16_t address = 0;
+    uint16_t addressKnown = 0;
+    uint32_t first = getEvent(0).cycle;
+    uint32_t lastTime = 0;
+
+    for (uint16_t i = 0; i < _count; i++)
+    {
+        const BusTraceEvent &event = getEvent(i);
+
+        if (event.signal < BUS_TRACE_ADDRESS_LOW)
+        {
+            if (levels[event.signal] == event.value)
+                continue;
+            levels[event.signal] = event.value;
+        }
+
+        uint32_t time = _toNanoseconds(event.cycle - first);
+        if (time != lastTime)
+        {
+            output.print('#');
+            output.println(time);
+            lastTime = time;
+        }
+
+        char id = '!' + vcdVariable(event.signal);
+        switch (event.signal)
+        {
+        case BUS_TRACE_ADDRESS_LOW:
+            address = (address & 0xFF00) | event.value;
+            addressKnown |= 0x00FF;
+            vcdPrintVector(output, address, addressKnown, 16, id);
+            break;
+        case BUS_TRACE_ADDRESS_HIGH:
+            address = (address & 0x00FF) | (event.value << 8);
+            addressKnown |= 0xFF00;
+            vcdPrintVector(output, address, addressKnown, 16, id);
+            break;
+        case BUS_TRACE_DATA_OUT:
+        case BUS_TRACE_DATA_IN:
+            vcdPrintVector(output, event.value, 0xFF, 8, id);
+            break;
+        default:
+            output.print(event.value ? '1' : '0');
+            output.println(id);
+            break;
+        }
+    }
+
+    return true;
+}
+
+// Write the trace as Value Change Dump to an SD card file
+bool BusTraceClass::exportVCDToSD(const char *filename)
+{
+    M1_PROFILE("BusTrace::exportToSD");
+
+    if (!filename)
+    {
+        M1_LOG_ERR(_logger, "BusTrace: exportVCDToSD() called with null filename");
+        return false;
+    }
+
+    if (!SD.begin(M1Shield.getSDCardSelectPin()))
+    {
+        M1_LOG_ERR(_logger, "BusTrace: Failed to initialize SD card");
+        return false;
+    }
+
+    // FILE_WRITE appends, so start from an empty file
+    if (SD.exists(filename))
+        SD.remove(filename);
+
+    File file = SD.open(filename, FILE_WRITE);
+    if (!file)
+    {
+        M1_LOG_ERR(_logger, "BusTrace: Failed to open file %s for writing", filename);
+        return false;
+    }
+
+    bool success = exportVCD(file);
+    file.close();
+    return success;
+}
@@ -0,0 +1,121 @@
+/*
+ * BusTrace.h - Class for recording TRS-80 Model 1 bus signal transitions
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * BusTrace timestamps every transition Model1LowLevel drives (RAS, CAS, MUX,
+ * RD, WR, IN, OUT, address bus and data bus) and every data bus read into a
+ * ring buffer. Timestamps come from the shared timer 5 cycle counter.
+ *
+ * The hooks in Model1LowLevel only exist when the library is compiled with
+ * M1_BUS_TRACE defined (e.g. build_flags = -DM1_BUS_TRACE); otherwise they
+ * cost nothing and begin() fails.
+ *
+ * The trace can be exported as a Value Change Dump (VCD) for GTKWave or
+ * PulseView, and checked against the DRAM timings of bus_timing.h.
+ */
+
+#ifndef BUSTRACE_H
+#define BUSTRACE_H
+
+#include <Arduino.h>
+#include "ILogger.h"
+
+// Default number of events kept in the ring buffer (6 bytes each)
+#ifndef BUS_TRACE_DEFAULT_EVENTS
+#define BUS_TRACE_DEFAULT_EVENTS 256
+#endif
+
+// Value matching any level or bus value in measurements
+#define BUS_TRACE_ANY_VALUE 0x100
+
+// Traced signals
+enum BusTraceSignal
+{
+    BUS_TRACE_RAS,          // Row address strobe
+    BUS_TRACE_CAS,          // Column address strobe
+    BUS_TRACE_MUX,          // Address multiplexer
+    BUS_TRACE_RD,           // Memory read
+    BUS_TRACE_WR,           // Memory write
+    BUS_TRACE_IN,           // IO read
+    BUS_TRACE_OUT,          // IO write
+    BUS_TRACE_ADDRESS_LOW,  // Address bus A0-A7
+    BUS_TRACE_ADDRESS_HIGH, // Address bus A8-A15
+    BUS_TRACE_DATA_OUT,     // Data driven by the Arduino
+    BUS_TRACE_DATA_IN,      // Data sampled by the Arduino
+    BUS_TRACE_SIGNAL_COUNT
+};
+
+// Recorded transition
+struct BusTraceEvent
+{
+    uint32_t cycle; // CPU cycles, corrected for the tracing overhead
+    uint8_t signal; // BusTraceSignal
+    uint8_t value;  // New level or bus value
+};
+
+class BusTraceClass
+{
+private:
+    ILogger *_logger; // Logger instance for debugging output
+
+    BusTraceEvent *_events; // Ring buffer
+    uint16_t _capacity;     // Size of the ring buffer
+    uint16_t _head;         // Index of the next event to write
+    uint16_t _count;        // Number of events in the buffer
+    uint32_t _dropped;      // Events overwritten since the last clear()
+    volatile bool _active;  // Set while recording
+
+    uint32_t _compensation; // Tracing overhead accumulated so far
+    uint16_t _overhead;     // Cycles one record() call adds to the bus cycle
+
+    void _record(uint8_t signal, uint8_t value); // Store one event
+    uint32_t _toNanoseconds(uint32_t cycles);    // Convert cycles to nanoseconds
+    void _calibrate();                           // Measure the cost of record()
+
+public:
+    BusTraceClass(); // Constructor
+
+    void setLogger(ILogger &logger); // Set logger for debugging output
+
+    bool begin(uint16_t capacity = BUS_TRACE_DEFAULT_EVENTS); // Allocate the buffer and start the cycle counter
+    void end();                                               // Release the cycle counter and free the buffer
+
+    void start();    // Start recording
+    void stop();     // Stop recording
+    void clear();    // Discard all events
+    bool isActive(); // Check if recording
+
+    // Called by Model1LowLevel for every transition
+    inline void record(uint8_t signal, uint8_t value)
+    {
+        if (_active)
+            _record(signal, value);
+    }
+
+    uint16_t getEventCount();                         // Number of events in the buffer
+    uint32_t getDroppedCount();                       // Number of events overwritten because the buffer was full
+    const BusTraceEvent &getEvent(uint16_t index);    // Event by index, oldest first
+    static const char *getSignalName(uint8_t signal); // Name of a signal
+
+    // ---------- Measurements
+    uint32_t getMinimumTime(uint8_t fromSignal, uint16_t fromValue, uint8_t toSignal, uint16_t toValue); // Shortest time (ns) from a transition to the following one, 0xFFFFFFFF if none
+    uint16_t verifyDRAMTiming();                                                                         // Count (and log) violations of tRAS, tCAS, tRP and the read access time
+
+    // ---------- Export
+    bool exportVCD(Print &output);            // Write the trace as Value Change Dump
+    bool exportVCDToSD(const char *filename); // Write the trace as Value Change Dump to an SD card file
+};
+
+extern BusTraceClass BusTrace;
+
+// Hook used by Model1LowLevel
+#if defined(M1_BUS_TRACE)
+#define M1_TRACE(signal, value) BusTrace.record(signal, value)
+#else
+#define M1_TRACE(signal, value)
+#endif
+
+#endif // BUSTRACE_H
@@ -145,7 +145,7 @@ void ButtonScreen::_setSelectedButtonItemIndex(uint8_t index)
         _selectedButtonItemIndex = index;
         _adjustViewWindow();
 
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && getLogger())
         {
             const char *title = getTitle();
             getLogger()->infoF(F("ButtonScreen[%s]: Selected item %d, view starts at %d"),
@@ -188,7 +188,7 @@ Screen *ButtonScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t off
         if (_isButtonItemEnabled(selectedIndex))
         {
             uint8_t selectedIndex = _getSelectedButtonItemIndex();
-            if (getLogger())
+            if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && getLogger())
             {
                 const char *title = getTitle();
                 getLogger()->infoF(F("ButtonScreen[%s]: Selecting button item %d"),
@@ -197,7 +197,7 @@ Screen *ButtonScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t off
             return _getSelectedButtonItemScreen(selectedIndex);
         }
         // If current item is disabled, don't activate it
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_WARN) && getLogger())
         {
             const char *title = getTitle();
             getLogger()->warnF(F("ButtonScreen[%s]: Attempted to select disabled button item %d"),
@@ -209,7 +209,7 @@ Screen *ButtonScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t off
     // Exit menu - return to previous screen
     if (action & BUTTON_MENU)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && getLogger())
         {
             const char *title = getTitle();
             getLogger()->infoF(F("ButtonScreen[%s]: Exiting button screen via menu button"),
@@ -370,7 +370,7 @@ void ButtonScreen::_drawFooter()
             else
             {
                 // Log malloc failure with screen title context
-                if (getLogger())
+                if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
                 {
                     const char *title = getTitle();
                     getLogger()->errF(F("ButtonScreen[%s]: Failed to allocate %d bytes for config value display"),
@@ -136,21 +136,18 @@ void Cassette::play(uint16_t frequency, uint32_t durationMs)
 {
     if (frequency == 0)
     {
-        if (_logger)
-            _logger->errF(F("Cassette: Invalid frequency 0 Hz - cannot play"));
+        M1_LOG_ERR(_logger, "Cassette: Invalid frequency 0 Hz - cannot play");
         return;
     }
 
     if (frequency > 10000)
     {
-        if (_logger)
-            _logger->warnF(F("Cassette: High frequency %d Hz may not be suitable for cassette playback"), frequency);
+        M1_LOG_WARN(_logger, "Cassette: High frequency %d Hz may not be suitable for cassette playback", frequency);
     }
 
     if (durationMs == 0)
     {
-        if (_logger)
-            _logger->warnF(F("Cassette: Duration 0ms - no output generated"));
+        M1_LOG_WARN(_logger, "Cassette: Duration 0ms - no output generated");
         return;
     }
 
@@ -246,6 +243,20 @@ void Cassette::setCharGenB()
     _write(_state);
 }
 
+// Get the port latch value, with the mode read back from hardware
+uint8_t Cassette::getState()
+{
+    update();
+    return _state;
+}
+
+// Write a complete port latch value
+void Cassette::setState(uint8_t state)
+{
+    _state = state;
+    _write(_state);
+}
+
 // Check if cassette is in 64-character mode
 bool Cassette::is64CharacterMode()
 {
@@ -117,6 +117,9 @@ public:
 
     void update(); // Update cassette interface state
 
+    uint8_t getState();           // Current port 0xFF latch value (mode read from hardware)
+    void setState(uint8_t state); // Write a complete port 0xFF latch value
+
     void setLogger(ILogger &logger); // Set logger for debugging output
 
     void writeRaw(bool value1, bool value2); // Write raw boolean values to cassette output
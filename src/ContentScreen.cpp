@@ -6,6 +6,7 @@
 
 #include "ContentScreen.h"
 #include "M1Shield.h"
+#include "MemoryDiagnostics.h"
 #include <Adafruit_GFX.h>
 
 // Text sizing constants for layout calculations
@@ -472,7 +473,7 @@ void ContentScreen::setButtonItemsF(const __FlashStringHelper **buttonItems, uin
     char **stringArray = (char **)malloc(buttonItemCount * sizeof(char *));
     if (stringArray == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *title = getTitle();
             getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for button items array"),
@@ -499,7 +500,7 @@ void ContentScreen::setButtonItemsF(const __FlashStringHelper **buttonItems, uin
             {
                 strcpy_P(stringArray[i], (const char *)buttonItems[i]);
             }
-            else if (getLogger())
+            else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
             {
                 const char *title = getTitle();
                 getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for button item %d"),
@@ -528,7 +529,7 @@ void ContentScreen::setButtonItems(const char **buttonItems, uint8_t buttonItemC
     if (buttonItems != nullptr && buttonItemCount > 0)
     {
         // Allocate array of string pointers
-        _buttonItems = (char **)malloc(buttonItemCount * sizeof(char *));
+        _buttonItems = (char **)MemoryDiagnostics.allocate(buttonItemCount * sizeof(char *), MEMORY_TAG_SCREEN);
         if (_buttonItems != nullptr)
         {
             _buttonItemCount = buttonItemCount;
@@ -545,12 +546,12 @@ void ContentScreen::setButtonItems(const char **buttonItems, uint8_t buttonItemC
                 if (buttonItems[i] != nullptr && buttonItems[i][0] != '\0')
                 {
                     size_t labelLen = strlen(buttonItems[i]);
-                    _buttonItems[i] = (char *)malloc(labelLen + 1); // +1 for null terminator
+                    _buttonItems[i] = (char *)MemoryDiagnostics.allocate(labelLen + 1, MEMORY_TAG_SCREEN); // +1 for null terminator
                     if (_buttonItems[i] != nullptr)
                     {
                         strcpy(_buttonItems[i], buttonItems[i]); // Safe because we allocated exact size needed
                     }
-                    else if (getLogger())
+                    else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
                     {
                         const char *currentTitle = getTitle();
                         getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for button label %d"),
@@ -559,7 +560,7 @@ void ContentScreen::setButtonItems(const char **buttonItems, uint8_t buttonItemC
                 }
             }
         }
-        else if (getLogger())
+        else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for button items array"),
@@ -587,10 +588,10 @@ void ContentScreen::clearButtonItems()
         {
             if (_buttonItems[i] != nullptr)
             {
-                free(_buttonItems[i]);
+                MemoryDiagnostics.release(_buttonItems[i], MEMORY_TAG_SCREEN);
             }
         }
-        free(_buttonItems);
+        MemoryDiagnostics.release(_buttonItems, MEMORY_TAG_SCREEN);
         _buttonItems = nullptr;
     }
     _buttonItemCount = 0;
@@ -754,7 +755,7 @@ void ContentScreen::notify(const char *text, unsigned long durationMs, uint16_t
     if (text == nullptr)
         return;
 
-    if (getLogger())
+    if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && getLogger())
     {
         const char *title = getTitle();
         getLogger()->infoF(F("ContentScreen[%s]: Showing notification '%s' for %lu ms"),
@@ -769,7 +770,7 @@ void ContentScreen::notify(const char *text, unsigned long durationMs, uint16_t
     _notificationText = (char *)malloc(len + 1);
     if (_notificationText == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *title = getTitle();
             getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for notification"),
@@ -918,10 +919,7 @@ void ContentScreen::alert(const char *text)
     // Clear any existing notification to prevent conflicts
     _clearNotification();
 
-    if (getLogger())
-    {
-        getLogger()->infoF(F("ContentScreen: Showing alert '%s'"), text);
-    }
+    M1_LOG_INFO(getLogger(), "ContentScreen: Showing alert '%s'", text);
 
     // Draw the alert dialog
     _drawAlert(text);
@@ -938,10 +936,7 @@ void ContentScreen::alert(const char *text)
         delay(10); // Small delay to prevent excessive CPU usage
     }
 
-    if (getLogger())
-    {
-        getLogger()->infoF(F("ContentScreen: Alert confirmed"));
-    }
+    M1_LOG_INFO(getLogger(), "ContentScreen: Alert confirmed");
 
     // Restore the footer efficiently (no need for full screen refresh)
     Adafruit_GFX &gfx = M1Shield.getGFX();
@@ -968,7 +963,7 @@ void ContentScreen::alertF(const __FlashStringHelper *text)
     char *buffer = (char *)malloc(len + 1);
     if (buffer == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for flash alert text"),
@@ -995,10 +990,7 @@ ConfirmResult ContentScreen::confirm(const char *text, const char *leftText, con
     // Clear any existing notification to prevent conflicts
     _clearNotification();
 
-    if (getLogger())
-    {
-        getLogger()->infoF(F("ContentScreen: Showing confirmation dialog '%s' with buttons '%s' and '%s'"), text, leftText, rightText);
-    }
+    M1_LOG_INFO(getLogger(), "ContentScreen: Showing confirmation dialog '%s' with buttons '%s' and '%s'", text, leftText, rightText);
 
     // Draw the confirmation dialog
     _drawConfirm(text, leftText, rightText);
@@ -1009,10 +1001,7 @@ ConfirmResult ContentScreen::confirm(const char *text, const char *leftText, con
     {
         if (M1Shield.wasLeftPressed())
         {
-            if (getLogger())
-            {
-                getLogger()->infoF(F("ContentScreen: Confirmed with left button '%s'"), leftText);
-            }
+            M1_LOG_INFO(getLogger(), "ContentScreen: Confirmed with left button '%s'", leftText);
 
             // Restore the footer efficiently and return left choice
             Adafruit_GFX &gfx = M1Shield.getGFX();
@@ -1024,10 +1013,7 @@ ConfirmResult ContentScreen::confirm(const char *text, const char *leftText, con
         }
         else if (M1Shield.wasRightPressed())
         {
-            if (getLogger())
-            {
-                getLogger()->infoF(F("ContentScreen: Confirmed with right button '%s'"), rightText);
-            }
+            M1_LOG_INFO(getLogger(), "ContentScreen: Confirmed with right button '%s'", rightText);
 
             // Restore the footer efficiently and return right choice
             Adafruit_GFX &gfx = M1Shield.getGFX();
@@ -1066,7 +1052,7 @@ ConfirmResult ContentScreen::confirmF(const __FlashStringHelper *text, const __F
 
     if (textBuffer == nullptr || leftBuffer == nullptr || rightBuffer == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for flash confirm dialog"),
@@ -1246,7 +1232,7 @@ char *ContentScreen::_truncateText(const char *text, uint16_t availableWidth, ui
         char *copy = (char *)malloc(textLen + 1);
         if (copy == nullptr)
         {
-            if (getLogger())
+            if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
             {
                 const char *currentTitle = getTitle();
                 getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for text copy"),
@@ -1268,7 +1254,7 @@ char *ContentScreen::_truncateText(const char *text, uint16_t availableWidth, ui
             char *truncated = (char *)malloc(4);
             if (truncated == nullptr)
             {
-                if (getLogger())
+                if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
                 {
                     const char *currentTitle = getTitle();
                     getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for truncated text ..."),
@@ -1287,7 +1273,7 @@ char *ContentScreen::_truncateText(const char *text, uint16_t availableWidth, ui
     char *truncated = (char *)malloc(maxChars + 1);
     if (truncated == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("ContentScreen[%s]: Failed to allocate memory for truncated text"),
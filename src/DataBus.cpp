@@ -50,8 +50,7 @@ void DataBus::writeData(uint8_t data)
 {
   if (!_writable)
   {
-    if (_logger)
-      _logger->errF(F("Data bus is not writable."));
+    M1_LOG_ERR(_logger, "Data bus is not writable.");
     return;
   }
   Model1LowLevel::writeDataBus(data);
@@ -88,10 +87,7 @@ char *DataBus::getState()
   char *buffer = (char *)malloc(LEN);
   if (!buffer)
   {
-    if (_logger)
-    {
-      _logger->errF(F("DataBus: Failed to allocate memory for state string"));
-    }
+    M1_LOG_ERR(_logger, "DataBus: Failed to allocate memory for state string");
     return nullptr;
   }
   char dataChars[9];
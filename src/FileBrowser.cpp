@@ -6,6 +6,7 @@
 
 #include "FileBrowser.h"
 #include "M1Shield.h"
+#include "MemoryDiagnostics.h"
 
 // Constructor - handles all usage patterns intelligently
 FileBrowser::FileBrowser(const String &directoryOrPath, const String &targetFile, bool restrictToRoot) : MenuScreen()
@@ -68,6 +69,7 @@ void FileBrowser::_cleanupArrays()
     if (_files)
     {
         delete[] _files;
+        MemoryDiagnostics.untrack(MEMORY_TAG_FILES, _fileCapacity * sizeof(FileEntry));
         _files = nullptr;
     }
     _fileCount = 0;
@@ -94,6 +96,7 @@ void FileBrowser::_ensureFileCapacity(uint8_t minCapacity)
         newCapacity = minCapacity;
 
     FileEntry *newFiles = new FileEntry[newCapacity];
+    MemoryDiagnostics.track(MEMORY_TAG_FILES, newCapacity * sizeof(FileEntry));
 
     // Copy existing data
     for (uint8_t i = 0; i < _fileCount; i++)
@@ -105,6 +108,7 @@ void FileBrowser::_ensureFileCapacity(uint8_t minCapacity)
     if (_files)
     {
         delete[] _files;
+        MemoryDiagnostics.untrack(MEMORY_TAG_FILES, _fileCapacity * sizeof(FileEntry));
     }
 
     _files = newFiles;
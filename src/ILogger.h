@@ -9,6 +9,18 @@
 
 #include <Print.h>
 
+// Log levels for M1_LOG_LEVEL
+#define M1_LOG_LEVEL_NONE 0  // No library messages
+#define M1_LOG_LEVEL_ERROR 1 // Errors only
+#define M1_LOG_LEVEL_WARN 2  // Errors and warnings
+#define M1_LOG_LEVEL_INFO 3  // Errors, warnings and progress
+#define M1_LOG_LEVEL_DEBUG 4 // Everything (default)
+
+// Lowest level of library messages compiled in, e.g. build_flags = -DM1_LOG_LEVEL=M1_LOG_LEVEL_ERROR
+#ifndef M1_LOG_LEVEL
+#define M1_LOG_LEVEL M1_LOG_LEVEL_DEBUG
+#endif
+
 class ILogger : public Print
 {
 public:
@@ -173,4 +185,62 @@ public:
     virtual size_t write(const uint8_t *buffer, size_t size) = 0; // Write buffer of characters (Print interface)
 };
 
+/**
+ * Library messages go through these macros, so messages below M1_LOG_LEVEL
+ * are removed at compile time together with their format strings in flash:
+ *
+ *     M1_LOG_ERR(_logger, "Model1: Failed to open file %s", filename);
+ *
+ * The first argument is a logger pointer and may be nullptr. The format is a
+ * string literal; it is put into flash with F(). Arguments of removed
+ * messages are not evaluated.
+ */
+
+#if M1_LOG_LEVEL >= M1_LOG_LEVEL_ERROR
+#define M1_LOG_ERR(logger, fmt, ...)               \
+    do                                             \
+    {                                              \
+        if (logger)                                \
+            (logger)->errF(F(fmt), ##__VA_ARGS__); \
+    } while (0)
+#else
+#define M1_LOG_ERR(logger, fmt, ...) ((void)0)
+#endif
+
+#if M1_LOG_LEVEL >= M1_LOG_LEVEL_WARN
+#define M1_LOG_WARN(logger, fmt, ...)               \
+    do                                              \
+    {                                               \
+        if (logger)                                 \
+            (logger)->warnF(F(fmt), ##__VA_ARGS__); \
+    } while (0)
+#else
+#define M1_LOG_WARN(logger, fmt, ...) ((void)0)
+#endif
+
+#if M1_LOG_LEVEL >= M1_LOG_LEVEL_INFO
+#define M1_LOG_INFO(logger, fmt, ...)               \
+    do                                              \
+    {                                               \
+        if (logger)                                 \
+            (logger)->infoF(F(fmt), ##__VA_ARGS__); \
+    } while (0)
+#else
+#define M1_LOG_INFO(logger, fmt, ...) ((void)0)
+#endif
+
+#if M1_LOG_LEVEL >= M1_LOG_LEVEL_DEBUG
+#define M1_LOG_DEBUG(logger, fmt, ...)               \
+    do                                               \
+    {                                                \
+        if (logger)                                  \
+            (logger)->debugF(F(fmt), ##__VA_ARGS__); \
+    } while (0)
+#else
+#define M1_LOG_DEBUG(logger, fmt, ...) ((void)0)
+#endif
+
+// Level is compiled in; guards logging that needs more than one call
+#define M1_LOG_ENABLED(level) (M1_LOG_LEVEL >= (level))
+
 #endif /* ILOGGER_H */
\ No newline at end of file
@@ -31,25 +31,28 @@ bool Keyboard::isKeyPressed() const
   return Model1.readMemory(KEYBOARD_ALL_ADDRESS) > 0;
 }
 
-// Update keyboard state by reading current values
-void Keyboard::update()
+// Read all keyboard rows into a caller-owned buffer of 8 bytes
+void Keyboard::_readState(uint8_t *state)
 {
+  // Rows are selected by single address bits, so they are not contiguous in memory
   for (int i = 0; i < 8; i++)
   {
     uint16_t keyMemAddress = KEYBOARD_MEM_ADDRESS + (1 << i);
-    _previousState[i] = Model1.readMemory(keyMemAddress);
+    state[i] = Model1.readMemory(keyMemAddress);
   }
 }
 
+// Update keyboard state by reading current values
+void Keyboard::update()
+{
+  _readState(_previousState);
+}
+
 // Get iterator for keyboard state changes since last update
 KeyboardChangeIterator Keyboard::changes()
 {
   uint8_t keyboardState[8];
-  for (int i = 0; i < 8; i++)
-  {
-    uint16_t keyMemAddress = KEYBOARD_MEM_ADDRESS + (1 << i);
-    keyboardState[i] = Model1.readMemory(keyMemAddress);
-  }
+  _readState(keyboardState);
 
   KeyboardChangeIterator it(_previousState, keyboardState);
 
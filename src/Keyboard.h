@@ -18,6 +18,8 @@ private:
   ILogger *_logger;          // Logger instance for debugging output
   uint8_t _previousState[8]; // Previous keyboard state for change detection
 
+  void _readState(uint8_t *state); // Read all 8 keyboard rows into caller-owned buffer
+
 public:
   Keyboard(); // Constructor
 
@@ -6,6 +6,7 @@
 
 #include "LoggerScreen.h"
 #include "M1Shield.h"
+#include "MemoryDiagnostics.h"
 #include <Arduino.h>
 
 class LoggerScreen::LoggerAdapter : public ILogger
@@ -113,9 +114,10 @@ LoggerScreen::~LoggerScreen()
     {
         for (uint16_t i = 0; i < _bufferSize; i++)
         {
-            delete[] _logBuffer[i].message;
+            MemoryDiagnostics.release(_logBuffer[i].message, MEMORY_TAG_LOGGER);
         }
         delete[] _logBuffer;
+        MemoryDiagnostics.untrack(MEMORY_TAG_LOGGER, _bufferSize * sizeof(LogEntry));
     }
 
     // Base class handles cleanup
@@ -180,9 +182,10 @@ void LoggerScreen::setLogBufferSize(uint16_t size)
     {
         for (uint16_t i = 0; i < _bufferSize; i++)
         {
-            delete[] _logBuffer[i].message;
+            MemoryDiagnostics.release(_logBuffer[i].message, MEMORY_TAG_LOGGER);
         }
         delete[] _logBuffer;
+        MemoryDiagnostics.untrack(MEMORY_TAG_LOGGER, _bufferSize * sizeof(LogEntry));
     }
 
     _logBuffer = nullptr;
@@ -196,6 +199,7 @@ void LoggerScreen::setLogBufferSize(uint16_t size)
         _logBuffer = new LogEntry[size];
         if (_logBuffer) // Check allocation success
         {
+            MemoryDiagnostics.track(MEMORY_TAG_LOGGER, size * sizeof(LogEntry));
             _bufferSize = size;
             // Initialize all message pointers to nullptr
             for (uint16_t i = 0; i < size; i++)
@@ -222,7 +226,7 @@ void LoggerScreen::clearLogBuffer()
         // Free all dynamically allocated message strings
         for (uint16_t i = 0; i < _bufferSize; i++)
         {
-            delete[] _logBuffer[i].message;
+            MemoryDiagnostics.release(_logBuffer[i].message, MEMORY_TAG_LOGGER);
             _logBuffer[i].message = nullptr;
         }
     }
@@ -359,13 +363,13 @@ void LoggerScreen::_addToBuffer(const char *logLine, uint16_t color)
     // Free existing message at head position if buffer is full (about to overwrite)
     if (_bufferCount == _bufferSize && _logBuffer[_bufferHead].message)
     {
-        delete[] _logBuffer[_bufferHead].message;
+        MemoryDiagnostics.release(_logBuffer[_bufferHead].message, MEMORY_TAG_LOGGER);
         _logBuffer[_bufferHead].message = nullptr;
     }
 
     // Allocate memory for the new message
     size_t msgLen = strlen(logLine) + 1;
-    _logBuffer[_bufferHead].message = new char[msgLen];
+    _logBuffer[_bufferHead].message = (char *)MemoryDiagnostics.allocate(msgLen, MEMORY_TAG_LOGGER);
     if (_logBuffer[_bufferHead].message)
     {
         strcpy(_logBuffer[_bufferHead].message, logLine);
@@ -10,6 +10,8 @@
 #include <SD.h>
 #include <Arduino.h>
 #include "Model1.h"
+#include "Profiler.h"
+#include "TaskScheduler.h"
 
 // Hardware timing constants
 constexpr unsigned long DEBOUNCE_TIME = 250; // Button debounce time in milliseconds
@@ -132,10 +134,7 @@ bool M1ShieldClass::begin(DisplayProvider &provider)
 
     if (!success)
     {
-        if (_logger)
-        {
-            _logger->errF(F("M1Shield: Failed to initialize display provider"));
-        }
+        M1_LOG_ERR(_logger, "M1Shield: Failed to initialize display provider");
         return false;
     }
 
@@ -143,10 +142,7 @@ bool M1ShieldClass::begin(DisplayProvider &provider)
     _screenWidth = provider.width();
     _screenHeight = provider.height();
 
-    if (_logger)
-    {
-        _logger->infoF(F("M1Shield: Display initialized successfully (%dx%d)"), _screenWidth, _screenHeight);
-    }
+    M1_LOG_INFO(_logger, "M1Shield: Display initialized successfully (%dx%d)", _screenWidth, _screenHeight);
 
     return success;
 }
@@ -174,10 +170,7 @@ Adafruit_GFX &M1ShieldClass::getGFX()
 {
     if (!_displayProvider)
     {
-        if (_logger)
-        {
-            _logger->errF(F("M1Shield: Attempted to get GFX without initialized display provider"));
-        }
+        M1_LOG_ERR(_logger, "M1Shield: Attempted to get GFX without initialized display provider");
         // This will likely cause a crash, but at least we log it
     }
     return _displayProvider->getGFX();
@@ -200,10 +193,7 @@ DisplayProvider &M1ShieldClass::getDisplayProvider() const
 {
     if (!_displayProvider)
     {
-        if (_logger)
-        {
-            _logger->errF(F("M1Shield: Attempted to get display provider that is not initialized"));
-        }
+        M1_LOG_ERR(_logger, "M1Shield: Attempted to get display provider that is not initialized");
         // This will likely cause a crash, but at least we log it
     }
     return *_displayProvider;
@@ -227,17 +217,14 @@ bool M1ShieldClass::display()
     if (_displayProvider)
     {
         bool result = _displayProvider->display();
-        if (!result && _logger)
+        if (!result)
         {
-            _logger->warnF(F("M1Shield: Display update failed"));
+            M1_LOG_WARN(_logger, "M1Shield: Display update failed");
         }
         return result;
     }
 
-    if (_logger)
-    {
-        _logger->warnF(F("M1Shield: Attempted to update display without initialized display provider"));
-    }
+    M1_LOG_WARN(_logger, "M1Shield: Attempted to update display without initialized display provider");
     return false;
 }
 
@@ -256,17 +243,14 @@ bool M1ShieldClass::setScreen(Screen *screen)
 {
     if (!screen)
     {
-        if (_logger)
-        {
-            _logger->warnF(F("M1Shield: Attempted to set null screen"));
-        }
+        M1_LOG_WARN(_logger, "M1Shield: Attempted to set null screen");
         return false;
     }
 
     // Free up the old screen to avoid memory leaks
     if (_screen)
     {
-        if (_logger)
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && _logger)
         {
             // Log screen closing with title if available
             const char *title = _screen->getTitle();
@@ -292,7 +276,7 @@ bool M1ShieldClass::setScreen(Screen *screen)
     }
 
     // Log new screen opening with context if available
-    if (_logger)
+    if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && _logger)
     {
         const char *title = screen->getTitle();
         if (title)
@@ -307,10 +291,7 @@ bool M1ShieldClass::setScreen(Screen *screen)
 
     if (!screen->open())
     {
-        if (_logger)
-        {
-            _logger->errF(F("M1Shield: Failed to open new screen"));
-        }
+        M1_LOG_ERR(_logger, "M1Shield: Failed to open new screen");
         // Screen failed to open, clean up
         delete screen;
         _screen = nullptr;
@@ -319,10 +300,7 @@ bool M1ShieldClass::setScreen(Screen *screen)
 
     _screen = screen;
 
-    if (_logger)
-    {
-        _logger->infoF(F("M1Shield: Screen transition completed successfully"));
-    }
+    M1_LOG_INFO(_logger, "M1Shield: Screen transition completed successfully");
 
     return true;
 }
@@ -621,13 +599,13 @@ bool M1ShieldClass::isSDCardInserted() const
     // Try to initialize the SD card with the configured chip select pin
     bool cardDetected = SD.begin(PIN_SD_SELECT);
 
-    if (cardDetected && _logger)
+    if (cardDetected)
     {
-        _logger->infoF(F("M1Shield: SD card detected and initialized successfully"));
+        M1_LOG_INFO(_logger, "M1Shield: SD card detected and initialized successfully");
     }
-    else if (!cardDetected && _logger)
+    else
     {
-        _logger->warnF(F("M1Shield: SD card not detected or initialization failed"));
+        M1_LOG_WARN(_logger, "M1Shield: SD card not detected or initialization failed");
     }
 
     return cardDetected;
@@ -658,6 +636,8 @@ void M1ShieldClass::buzz(unsigned int durationMs) const
 // Main loop - Process input and update current screen
 void M1ShieldClass::loop()
 {
+    M1_PROFILE("M1Shield::loop");
+
     // Keep track of TEST* signal and show state
     if (Model1.hasActiveTestSignal())
     {
@@ -668,6 +648,9 @@ void M1ShieldClass::loop()
         _inactive();
     }
 
+    // Run due background tasks before the input is handled
+    TaskScheduler.loop();
+
     // If there is no screen attached, don't do more and ignore the rest
     if (!_screen)
         return;
@@ -0,0 +1,379 @@
+/*
+ * MemoryDiagnostics.cpp - Class for measuring SRAM use of stack and heap
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "MemoryDiagnostics.h"
+
+#if defined(M1_HOST)
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#else
+// avr-libc malloc internals (malloc.c); not declared in any header
+struct __freelist
+{
+    size_t sz;             // Usable size of the free block
+    struct __freelist *nx; // Next free block
+};
+extern "C" char *__brkval;           // Heap break, nullptr before the first allocation
+extern "C" struct __freelist *__flp; // Head of the free list
+#endif
+
+static const char tagScreen[] PROGMEM = "Screen";
+static const char tagMenu[] PROGMEM = "Menu";
+static const char tagLogger[] PROGMEM = "Logger";
+static const char tagFiles[] PROGMEM = "Files";
+static const char tagViewer[] PROGMEM = "Viewer";
+static const char tagModel1[] PROGMEM = "Model1";
+static const char tagTrace[] PROGMEM = "BusTrace";
+static const char tagVideo[] PROGMEM = "Video";
+static const char tagShadow[] PROGMEM = "Shadow";
+static const char tagSketch[] PROGMEM = "Sketch";
+
+static const char *const tagNames[MEMORY_TAG_COUNT] PROGMEM = {
+    tagScreen, tagMenu, tagLogger, tagFiles, tagViewer, tagModel1, tagTrace, tagVideo, tagShadow, tagSketch};
+
+MemoryDiagnosticsClass MemoryDiagnostics;
+
+// Constructor
+MemoryDiagnosticsClass::MemoryDiagnosticsClass()
+{
+    _logger = nullptr;
+    _painted = false;
+    _heapPeak = 0;
+    _paintFrom = 0;
+
+#if defined(M1_MEMORY_TAGS)
+    memset(_tags, 0, sizeof(_tags));
+#endif
+}
+
+// Set the logger for debugging output
+void MemoryDiagnosticsClass::setLogger(ILogger &logger)
+{
+    _logger = &logger;
+}
+
+// Paint the stack; everything the stack used before is not measured
+void MemoryDiagnosticsClass::begin()
+{
+    sample();
+    _paint();
+}
+
+// Remember the highest heap break; called by allocate() and the statistics
+void MemoryDiagnosticsClass::sample()
+{
+    uintptr_t end = _getHeapEnd();
+    if (end > _heapPeak)
+        _heapPeak = end;
+}
+
+// Repaint the stack and restart the heap and tag peaks at the current use
+void MemoryDiagnosticsClass::resetPeaks()
+{
+    _heapPeak = 0;
+    sample();
+
+#if defined(M1_MEMORY_TAGS)
+    for (uint8_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        _tags[i].peak = _tags[i].current;
+#endif
+
+    if (_painted)
+        _paint();
+}
+
+// Fill the unused memory between heap break and stack pointer with the canary
+void MemoryDiagnosticsClass::_paint()
+{
+#if !defined(M1_HOST)
+    uint8_t *address = (uint8_t *)_getHeapEnd();
+    uint8_t *end = (uint8_t *)_getStackPointer();
+
+    _paintFrom = (uintptr_t)address;
+    while (address < end)
+        *address++ = MEMORY_CANARY;
+
+    _painted = true;
+#endif
+}
+
+// ----------------------------------------
+// ---------- Stack and Heap
+// ----------------------------------------
+
+// First heap address
+uintptr_t MemoryDiagnosticsClass::_getHeapStart()
+{
+#if defined(M1_HOST)
+    return 0;
+#else
+    return (uintptr_t)__malloc_heap_start;
+#endif
+}
+
+// Current heap break; the heap start before the first allocation
+uintptr_t MemoryDiagnosticsClass::_getHeapEnd()
+{
+#if defined(M1_HOST)
+    return 0;
+#else
+    return __brkval ? (uintptr_t)__brkval : (uintptr_t)__malloc_heap_start;
+#endif
+}
+
+// Current stack pointer; the stack grows down from RAMEND
+uintptr_t MemoryDiagnosticsClass::_getStackPointer()
+{
+#if defined(M1_HOST)
+    return 0;
+#else
+    return (uintptr_t)SP;
+#endif
+}
+
+// Stack use now and the deepest byte the stack overwrote since painting
+StackStatistics MemoryDiagnosticsClass::getStackStatistics()
+{
+    StackStatistics statistics = {0, 0, 0};
+
+#if !defined(M1_HOST)
+    uintptr_t stackPointer = _getStackPointer();
+    statistics.current = RAMEND - stackPointer;
+    statistics.peak = statistics.current;
+
+    if (!_painted)
+        return statistics;
+
+    // Canaries below the highest heap break may have been overwritten by the heap
+    sample();
+    uintptr_t from = _heapPeak > _paintFrom ? _heapPeak : _paintFrom;
+
+    const uint8_t *address = (const uint8_t *)from;
+    while ((uintptr_t)address < stackPointer && *address == MEMORY_CANARY)
+        address++;
+
+    statistics.unused = (uintptr_t)address - from;
+    if (RAMEND - (uintptr_t)address > statistics.peak)
+        statistics.peak = RAMEND - (uintptr_t)address;
+#endif
+
+    return statistics;
+}
+
+// Heap size and peak, and the free memory from the free list and the gap to the stack
+HeapStatistics MemoryDiagnosticsClass::getHeapStatistics()
+{
+    HeapStatistics statistics = {0, 0, 0, 0, 0, 0};
+
+#if !defined(M1_HOST)
+    sample();
+    uintptr_t start = _getHeapStart();
+    uintptr_t end = _getHeapEnd();
+    statistics.size = end - start;
+    statistics.peak = _heapPeak - start;
+
+    uint16_t largest = 0;
+    for (struct __freelist *block = __flp; block; block = block->nx)
+    {
+        statistics.free += block->sz + sizeof(size_t);
+        if (block->sz > largest)
+            largest = block->sz;
+        if (statistics.fragments < 0xFF)
+            statistics.fragments++;
+    }
+
+    // malloc() keeps __malloc_margin bytes away from the stack
+    uintptr_t limit = __malloc_heap_end ? (uintptr_t)__malloc_heap_end : _getStackPointer() - __malloc_margin;
+    if (limit > end)
+    {
+        uint16_t gap = limit - end;
+        statistics.free += gap;
+        if (gap > sizeof(size_t) && gap - sizeof(size_t) > largest)
+            largest = gap - sizeof(size_t);
+    }
+
+    statistics.largestFree = largest;
+    if (statistics.free)
+        statistics.fragmentation = 100 - (uint8_t)(((uint32_t)largest * 100) / statistics.free);
+#endif
+
+    return statistics;
+}
+
+// ----------------------------------------
+// ---------- Tags
+// ----------------------------------------
+
+// malloc() counted for a tag
+void *MemoryDiagnosticsClass::allocate(size_t size, MemoryTag tag)
+{
+    void *ptr = malloc(size);
+
+#if defined(M1_MEMORY_TAGS)
+    if (tag < MEMORY_TAG_COUNT)
+    {
+        if (ptr)
+        {
+            _account(tag, _getBlockSize(ptr));
+            _tags[tag].allocations++;
+        }
+        else
+        {
+            _tags[tag].failures++;
+        }
+    }
+#else
+    (void)tag; // Parameter not used
+#endif
+
+    sample();
+    return ptr;
+}
+
+// free() counted for a tag
+void MemoryDiagnosticsClass::release(void *ptr, MemoryTag tag)
+{
+    if (!ptr)
+        return;
+
+#if defined(M1_MEMORY_TAGS)
+    if (tag < MEMORY_TAG_COUNT)
+        _account(tag, -(int32_t)_getBlockSize(ptr));
+#else
+    (void)tag; // Parameter not used
+#endif
+
+    free(ptr);
+}
+
+// Count memory allocated with new, which does not go through allocate()
+void MemoryDiagnosticsClass::track(MemoryTag tag, size_t size)
+{
+#if defined(M1_MEMORY_TAGS)
+    if (tag < MEMORY_TAG_COUNT)
+    {
+        _account(tag, size);
+        _tags[tag].allocations++;
+    }
+#else
+    (void)tag;  // Parameter not used
+    (void)size; // Parameter not used
+#endif
+
+    sample();
+}
+
+// Count memory freed with delete
+void MemoryDiagnosticsClass::untrack(MemoryTag tag, size_t size)
+{
+#if defined(M1_MEMORY_TAGS)
+    if (tag < MEMORY_TAG_COUNT)
+        _account(tag, -(int32_t)size);
+#else
+    (void)tag;  // Parameter not used
+    (void)size; // Parameter not used
+#endif
+}
+
+// Usable size of a block returned by malloc(), as free() will see it
+size_t MemoryDiagnosticsClass::_getBlockSize(void *ptr)
+{
+#if defined(M1_HOST) && defined(__APPLE__)
+    return malloc_size(ptr);
+#elif defined(M1_HOST)
+    return malloc_usable_size(ptr);
+#else
+    return ((size_t *)ptr)[-1]; // avr-libc stores the size in front of the block
+#endif
+}
+
+// Add (positive size) or remove (negative size) bytes of a tag
+void MemoryDiagnosticsClass::_account(MemoryTag tag, int32_t size)
+{
+#if defined(M1_MEMORY_TAGS)
+    MemoryTagStatistics &statistics = _tags[tag];
+    int32_t current = (int32_t)statistics.current + size;
+    if (current < 0)
+        current = 0; // Released more than counted, e.g. after allocations before a tag was used
+    statistics.current = current > 0xFFFF ? 0xFFFF : (uint16_t)current;
+    if (statistics.current > statistics.peak)
+        statistics.peak = statistics.current;
+#else
+    (void)tag;  // Parameter not used
+    (void)size; // Parameter not used
+#endif
+}
+
+// Statistics of a tag
+bool MemoryDiagnosticsClass::getTagStatistics(MemoryTag tag, MemoryTagStatistics &statistics)
+{
+#if defined(M1_MEMORY_TAGS)
+    if (tag >= MEMORY_TAG_COUNT)
+        return false;
+
+    statistics = _tags[tag];
+    return true;
+#else
+    (void)tag;        // Parameter not used
+    (void)statistics; // Parameter not used
+    return false;
+#endif
+}
+
+// Name of a tag (PROGMEM)
+const char *MemoryDiagnosticsClass::getTagName(MemoryTag tag)
+{
+    if (tag >= MEMORY_TAG_COUNT)
+        return nullptr;
+    return (const char *)pgm_read_ptr(&tagNames[tag]);
+}
+
+// ----------------------------------------
+// ---------- Output
+// ----------------------------------------
+
+// Log to the logger set with setLogger()
+void MemoryDiagnosticsClass::dump()
+{
+    if (_logger)
+        dump(*_logger);
+}
+
+// Log stack, heap and all tags in bytes
+void MemoryDiagnosticsClass::dump(ILogger &logger)
+{
+#if !defined(M1_HOST)
+    StackStatistics stack = getStackStatistics();
+    HeapStatistics heap = getHeapStatistics();
+
+    if (_painted)
+        logger.infoF(F("Stack: %u now, %u peak, %u never used"), stack.current, stack.peak, stack.unused);
+    else
+        logger.infoF(F("Stack: %u now (begin() not called, no peak)"), stack.current);
+
+    logger.infoF(F("Heap: %u now, %u peak, %u free, %u largest block, %u fragment(s), %u%% fragmented"),
+                 heap.size, heap.peak, heap.free, heap.largestFree, heap.fragments, heap.fragmentation);
+#endif
+
+#if defined(M1_MEMORY_TAGS)
+    for (uint8_t i = 0; i < MEMORY_TAG_COUNT; i++)
+    {
+        const MemoryTagStatistics &tag = _tags[i];
+        if (tag.allocations == 0 && tag.failures == 0)
+            continue;
+
+        char name[12];
+        strncpy_P(name, getTagName((MemoryTag)i), sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+
+        logger.infoF(F("%s: %u now, %u peak, %u allocation(s), %u failure(s)"),
+                     name, tag.current, tag.peak, tag.allocations, tag.failures);
+    }
+#endif
+}
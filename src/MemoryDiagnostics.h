@@ -0,0 +1,122 @@
+/*
+ * MemoryDiagnostics.h - Class for measuring SRAM use of stack and heap
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * MemoryDiagnostics reports how the 8 KB of SRAM are used, so buffer sizes
+ * can be tuned from measurements:
+ *
+ * - Stack: begin() paints the free memory between heap and stack with a
+ *   canary byte. The deepest byte that was overwritten is the high-water mark.
+ * - Heap: size, peak, free memory, largest free block and fragmentation, from
+ *   the avr-libc free list.
+ * - Tags: allocations made through allocate()/release() are counted per
+ *   subsystem (current, peak, calls, failures). Tag accounting is compiled in
+ *   when the library is built with M1_MEMORY_TAGS; otherwise allocate() and
+ *   release() are plain malloc() and free().
+ *
+ * On the host build (extras/host) only the tags are measured.
+ */
+
+#ifndef MEMORYDIAGNOSTICS_H
+#define MEMORYDIAGNOSTICS_H
+
+#include <Arduino.h>
+#include "ILogger.h"
+
+// Byte painted into unused stack memory
+#define MEMORY_CANARY 0xC5
+
+// Subsystems allocations are counted for
+enum MemoryTag : uint8_t
+{
+    MEMORY_TAG_SCREEN, // Screen titles and button labels
+    MEMORY_TAG_MENU,   // MenuScreen items
+    MEMORY_TAG_LOGGER, // LoggerScreen buffer and messages
+    MEMORY_TAG_FILES,  // FileBrowser listings
+    MEMORY_TAG_VIEWER, // BinaryFileViewer page buffer
+    MEMORY_TAG_MODEL1, // Model1 refresh monitor
+    MEMORY_TAG_TRACE,  // BusTrace events
+    MEMORY_TAG_VIDEO,  // Video shadow buffer and VideoMirrorScreen
+    MEMORY_TAG_SHADOW, // ShadowMemory copy and line bitmaps
+    MEMORY_TAG_SKETCH, // Free for use by the sketch
+    MEMORY_TAG_COUNT
+};
+
+// Stack use in bytes
+struct StackStatistics
+{
+    uint16_t current; // In use now
+    uint16_t peak;    // High-water mark since begin() or resetPeaks()
+    uint16_t unused;  // Never touched by heap or stack since painting
+};
+
+// Heap use in bytes
+struct HeapStatistics
+{
+    uint16_t size;         // From heap start to the break, including free blocks
+    uint16_t peak;         // Largest size seen
+    uint16_t free;         // Free list plus the gap between break and stack
+    uint16_t largestFree;  // Largest block malloc() can return now
+    uint8_t fragments;     // Blocks on the free list
+    uint8_t fragmentation; // Percent of free memory outside the largest block
+};
+
+// Allocations of one tag in bytes
+struct MemoryTagStatistics
+{
+    uint16_t current;     // Allocated now
+    uint16_t peak;        // Most allocated at once
+    uint16_t allocations; // Successful allocations
+    uint16_t failures;    // Allocations that failed
+};
+
+class MemoryDiagnosticsClass
+{
+private:
+    ILogger *_logger; // Logger instance for debugging output
+
+    bool _painted;        // Stack was painted by begin()
+    uintptr_t _heapPeak;  // Highest heap break seen
+    uintptr_t _paintFrom; // Lowest painted address
+
+#if defined(M1_MEMORY_TAGS)
+    MemoryTagStatistics _tags[MEMORY_TAG_COUNT]; // Statistics per tag
+#endif
+
+    void _paint();                              // Paint the memory between heap and stack
+    uintptr_t _getHeapStart();                  // First heap address
+    uintptr_t _getHeapEnd();                    // Current heap break
+    uintptr_t _getStackPointer();               // Current stack pointer
+    size_t _getBlockSize(void *ptr);            // Usable size of an allocated block
+    void _account(MemoryTag tag, int32_t size); // Add or remove bytes of a tag
+
+public:
+    MemoryDiagnosticsClass(); // Constructor
+
+    void setLogger(ILogger &logger); // Set logger for debugging output
+
+    void begin();      // Paint the stack; call early in setup()
+    void sample();     // Update the heap peak
+    void resetPeaks(); // Repaint the stack and restart all peaks
+
+    StackStatistics getStackStatistics(); // Stack use and high-water mark
+    HeapStatistics getHeapStatistics();   // Heap use, free memory and fragmentation
+
+    void *allocate(size_t size, MemoryTag tag); // malloc() counted for a tag
+    void release(void *ptr, MemoryTag tag);     // free() counted for a tag
+    void track(MemoryTag tag, size_t size);     // Count memory allocated with new
+    void untrack(MemoryTag tag, size_t size);   // Count memory freed with delete
+
+    bool getTagStatistics(MemoryTag tag, MemoryTagStatistics &statistics); // Statistics of a tag, false without M1_MEMORY_TAGS
+    static const char *getTagName(MemoryTag tag);                          // Name of a tag (PROGMEM)
+
+    void dump(ILogger &logger); // Log stack, heap and tags
+    void dump();                // Log to the logger set with setLogger()
+};
+
+extern MemoryDiagnosticsClass MemoryDiagnostics;
+
+#endif // MEMORYDIAGNOSTICS_H
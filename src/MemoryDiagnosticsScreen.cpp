@@ -0,0 +1,174 @@
+/*
+ * MemoryDiagnosticsScreen.cpp - ContentScreen showing stack, heap and tag use live
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "MemoryDiagnosticsScreen.h"
+#include "M1Shield.h"
+#include "MemoryDiagnostics.h"
+
+#define MEMORY_SCREEN_LINE_HEIGHT 8  // Text size 1
+#define MEMORY_SCREEN_STATIC_LINES 9 // Stack, heap and the tag header
+#define MEMORY_SCREEN_MAX_CHARS 32   // Longest table line
+
+// Constructor
+MemoryDiagnosticsScreen::MemoryDiagnosticsScreen()
+{
+    _firstLine = 0;
+    _lastUpdate = 0;
+
+    setTitleF(F("Memory"));
+
+    const char *buttons[] = {"Up/Dn:Scroll", "Sel:Reset"};
+    setButtonItems(buttons, 2);
+}
+
+// Start with the first line
+bool MemoryDiagnosticsScreen::open()
+{
+    _firstLine = 0;
+    _lastUpdate = millis();
+    return ContentScreen::open();
+}
+
+// Update the table periodically
+void MemoryDiagnosticsScreen::loop()
+{
+    ContentScreen::loop();
+
+    if (isActive() && millis() - _lastUpdate >= MEMORY_DIAGNOSTICS_SCREEN_UPDATE_MS)
+    {
+        _lastUpdate = millis();
+        clearContentArea();
+        _drawContent();
+        M1Shield.display();
+    }
+}
+
+// Number of lines fitting the content area
+uint8_t MemoryDiagnosticsScreen::_getVisibleLines()
+{
+    return _getContentHeight() / MEMORY_SCREEN_LINE_HEIGHT;
+}
+
+// Stack and heap lines, the tag header and one line per tag
+uint8_t MemoryDiagnosticsScreen::_getLineCount()
+{
+#if defined(M1_MEMORY_TAGS)
+    return MEMORY_SCREEN_STATIC_LINES + MEMORY_TAG_COUNT;
+#else
+    return MEMORY_SCREEN_STATIC_LINES;
+#endif
+}
+
+// Draw the memory table; short lines so it fits the narrowest displays
+void MemoryDiagnosticsScreen::_drawContent()
+{
+    StackStatistics stack = MemoryDiagnostics.getStackStatistics();
+    HeapStatistics heap = MemoryDiagnostics.getHeapStatistics();
+
+    uint8_t visible = _getVisibleLines();
+    uint8_t count = _getLineCount();
+    char line[MEMORY_SCREEN_MAX_CHARS];
+
+    for (uint8_t row = 0; row < visible && _firstLine + row < count; row++)
+    {
+        uint8_t index = _firstLine + row;
+        uint16_t color = 0xFFFF;
+
+        switch (index)
+        {
+        case 0:
+            snprintf(line, sizeof(line), "Stack now  %6u", stack.current);
+            break;
+        case 1:
+            snprintf(line, sizeof(line), "Stack peak %6u", stack.peak);
+            break;
+        case 2:
+            snprintf(line, sizeof(line), "Never used %6u", stack.unused);
+            break;
+        case 3:
+            snprintf(line, sizeof(line), "Heap now   %6u", heap.size);
+            break;
+        case 4:
+            snprintf(line, sizeof(line), "Heap peak  %6u", heap.peak);
+            break;
+        case 5:
+            snprintf(line, sizeof(line), "Free       %6u", heap.free);
+            break;
+        case 6:
+            snprintf(line, sizeof(line), "Largest    %6u", heap.largestFree);
+            break;
+        case 7:
+            snprintf(line, sizeof(line), "Fragments %3u %3u%%", heap.fragments, heap.fragmentation);
+            break;
+        case 8:
+#if defined(M1_MEMORY_TAGS)
+            snprintf(line, sizeof(line), "Tag         Now  Peak");
+#else
+            snprintf(line, sizeof(line), "Tags: M1_MEMORY_TAGS");
+#endif
+            color = 0xFFE0;
+            break;
+        default:
+        {
+            MemoryTag tag = (MemoryTag)(index - MEMORY_SCREEN_STATIC_LINES);
+            MemoryTagStatistics statistics;
+            if (!MemoryDiagnostics.getTagStatistics(tag, statistics))
+                continue;
+
+            char name[9];
+            strncpy_P(name, MemoryDiagnostics.getTagName(tag), sizeof(name) - 1);
+            name[sizeof(name) - 1] = '\0';
+
+            snprintf(line, sizeof(line), "%-8s %6u%6u", name, statistics.current, statistics.peak);
+            if (statistics.failures)
+                color = 0xF800; // Red when an allocation failed
+            break;
+        }
+        }
+
+        drawText(0, row * MEMORY_SCREEN_LINE_HEIGHT, line, color, 1);
+    }
+}
+
+// Scroll with up/down, reset the peaks with select
+Screen *MemoryDiagnosticsScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY)
+{
+    (void)offsetX; // Parameter not used
+    (void)offsetY; // Parameter not used
+
+    if (!isActive())
+        return nullptr;
+
+    if (action & UP_ANY)
+    {
+        if (_firstLine > 0)
+        {
+            _firstLine--;
+            refresh();
+        }
+        return nullptr;
+    }
+
+    if (action & DOWN_ANY)
+    {
+        if (_firstLine + _getVisibleLines() < _getLineCount())
+        {
+            _firstLine++;
+            refresh();
+        }
+        return nullptr;
+    }
+
+    if (action & (BUTTON_SELECT | BUTTON_JOYSTICK))
+    {
+        MemoryDiagnostics.resetPeaks();
+        refresh();
+        notifyF(F("Peaks reset"));
+        return nullptr;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,39 @@
+/*
+ * MemoryDiagnosticsScreen.h - ContentScreen showing stack, heap and tag use live
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef MEMORYDIAGNOSTICSSCREEN_H
+#define MEMORYDIAGNOSTICSSCREEN_H
+
+#include <Arduino.h>
+#include "ContentScreen.h"
+
+// Interval between updates of the memory table
+#ifndef MEMORY_DIAGNOSTICS_SCREEN_UPDATE_MS
+#define MEMORY_DIAGNOSTICS_SCREEN_UPDATE_MS 500
+#endif
+
+// Table of stack and heap use and of the allocations per tag
+class MemoryDiagnosticsScreen : public ContentScreen
+{
+private:
+    uint8_t _firstLine;        // First line shown (scroll position)
+    unsigned long _lastUpdate; // Time of the last table update
+
+    uint8_t _getVisibleLines(); // Number of lines fitting the content area
+    uint8_t _getLineCount();    // Number of lines in the table
+
+public:
+    MemoryDiagnosticsScreen(); // Constructor, sets title and button items
+
+    bool open() override; // Start with the first line
+    void loop() override; // Update the table periodically
+    Screen *actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY) override;
+
+protected:
+    void _drawContent() override; // Draw the memory table
+};
+
+#endif /* MEMORYDIAGNOSTICSSCREEN_H */
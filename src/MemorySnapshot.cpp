@@ -0,0 +1,456 @@
+/*
+ * MemorySnapshot.cpp - Class for saving and restoring TRS-80 Model 1 memory state
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "MemorySnapshot.h"
+#include "Model1.h"
+#include "M1Shield.h"
+#include "Profiler.h"
+#include "utils.h"
+
+// File signature
+const uint8_t SNAPSHOT_MAGIC[4] = {'M', '1', 'S', 'N'};
+
+// PackBits limits: runs shorter than this are stored as literals
+#define PACKBITS_MAX_COUNT 128
+#define PACKBITS_MIN_RUN 3
+
+// PackBits encoder state, kept on the stack while saving
+struct PackBitsEncoder
+{
+    File *file;                           // Output file
+    uint8_t literals[PACKBITS_MAX_COUNT]; // Pending literal bytes
+    uint8_t literalCount;                 // Number of pending literal bytes
+    uint8_t runValue;                     // Value of the pending run
+    uint8_t runCount;                     // Length of the pending run
+    uint32_t written;                     // Compressed bytes written
+    bool failed;                          // Set when the file could not be written
+};
+
+// Write encoded bytes to the output file
+static void packBitsOutput(PackBitsEncoder &encoder, const uint8_t *data, uint16_t length)
+{
+    if (encoder.file->write(data, length) != length)
+        encoder.failed = true;
+    encoder.written += length;
+}
+
+// Emit pending literal bytes as one literal record
+static void packBitsFlushLiterals(PackBitsEncoder &encoder)
+{
+    if (encoder.literalCount == 0)
+        return;
+
+    uint8_t control = encoder.literalCount - 1;
+    packBitsOutput(encoder, &control, 1);
+    packBitsOutput(encoder, encoder.literals, encoder.literalCount);
+    encoder.literalCount = 0;
+}
+
+// Emit the pending run, or move it to the literals if it is too short
+static void packBitsFlushRun(PackBitsEncoder &encoder)
+{
+    if (encoder.runCount >= PACKBITS_MIN_RUN)
+    {
+        packBitsFlushLiterals(encoder);
+        uint8_t record[2] = {(uint8_t)(257 - encoder.runCount), encoder.runValue};
+        packBitsOutput(encoder, record, 2);
+    }
+    else
+    {
+        for (uint8_t i = 0; i < encoder.runCount; i++)
+        {
+            encoder.literals[encoder.literalCount++] = encoder.runValue;
+            if (encoder.literalCount == PACKBITS_MAX_COUNT)
+                packBitsFlushLiterals(encoder);
+        }
+    }
+    encoder.runCount = 0;
+}
+
+// Add one byte to the compressed stream
+static void packBitsPush(PackBitsEncoder &encoder, uint8_t data)
+{
+    if (encoder.runCount > 0 && data == encoder.runValue && encoder.runCount < PACKBITS_MAX_COUNT)
+    {
+        encoder.runCount++;
+        return;
+    }
+
+    packBitsFlushRun(encoder);
+    encoder.runValue = data;
+    encoder.runCount = 1;
+}
+
+// Store a 16-bit value little-endian
+static void putUInt16(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = value >> 8;
+}
+
+// Store a 32-bit value little-endian
+static void putUInt32(uint8_t *buffer, uint32_t value)
+{
+    putUInt16(buffer, value & 0xFFFF);
+    putUInt16(buffer + 2, value >> 16);
+}
+
+// Load a 16-bit little-endian value
+static uint16_t getUInt16(const uint8_t *buffer)
+{
+    return buffer[0] | ((uint16_t)buffer[1] << 8);
+}
+
+// Load a 32-bit little-endian value
+static uint32_t getUInt32(const uint8_t *buffer)
+{
+    return getUInt16(buffer) | ((uint32_t)getUInt16(buffer + 2) << 16);
+}
+
+// Constructor
+MemorySnapshot::MemorySnapshot()
+{
+    _logger = nullptr;
+    _cassette = nullptr;
+    _compressedLength = 0;
+    _expectedCRC = 0;
+}
+
+// Set logger for debugging output
+void MemorySnapshot::setLogger(ILogger &logger)
+{
+    _logger = &logger;
+}
+
+// Use an existing cassette interface, so its remote and output state is captured and kept in sync
+void MemorySnapshot::setCassette(Cassette &cassette)
+{
+    _cassette = &cassette;
+}
+
+// Initialize the SD card
+bool MemorySnapshot::_openSD()
+{
+    if (!SD.begin(M1Shield.getSDCardSelectPin()))
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Failed to initialize SD card");
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------
+// ---------- Save
+// ----------------------------------------
+
+// Save a memory range and the port 0xFF latch into a compressed snapshot file
+bool MemorySnapshot::save(const char *filename, uint16_t start, uint32_t length)
+{
+    M1_PROFILE("MemorySnapshot::save");
+
+    if (!filename)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: save() called with null filename");
+        return false;
+    }
+    if (length == 0 || start + length > 0x10000UL)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Invalid range 0x%04X, length %lu", start, length);
+        return false;
+    }
+    if (!_openSD())
+        return false;
+
+    // FILE_WRITE appends, so start from an empty file
+    if (SD.exists(filename))
+        SD.remove(filename);
+
+    File file = SD.open(filename, FILE_WRITE);
+    if (!file)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Failed to open file %s for writing", filename);
+        return false;
+    }
+
+    // Capture the IO state before memory, the latch write-back on restore happens last
+    Cassette localCassette;
+    Cassette &cassette = _cassette ? *_cassette : localCassette;
+    uint8_t ioState = cassette.getState();
+
+    uint8_t header[SNAPSHOT_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header[4] = SNAPSHOT_VERSION;
+    header[5] = SNAPSHOT_FLAG_IO_STATE;
+    header[6] = ioState;
+    putUInt16(header + 8, start);
+    putUInt32(header + 10, length);
+
+    if (file.write(header, sizeof(header)) != sizeof(header))
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Failed to write header to %s", filename);
+        file.close();
+        return false;
+    }
+
+    PackBitsEncoder encoder;
+    encoder.file = &file;
+    encoder.literalCount = 0;
+    encoder.runValue = 0;
+    encoder.runCount = 0;
+    encoder.written = 0;
+    encoder.failed = false;
+
+    uint8_t buffer[SNAPSHOT_BUFFER_SIZE];
+    uint32_t crc = 0xFFFFFFFFUL;
+
+    for (uint32_t offset = 0; offset < length && !encoder.failed; offset += SNAPSHOT_BUFFER_SIZE)
+    {
+        uint16_t chunkSize = (length - offset < SNAPSHOT_BUFFER_SIZE) ? (length - offset) : SNAPSHOT_BUFFER_SIZE;
+        if (!Model1.readMemoryInto(start + offset, buffer, chunkSize))
+        {
+            M1_LOG_ERR(_logger, "MemorySnapshot: Failed to read memory at 0x%04X", (uint16_t)(start + offset));
+            file.close();
+            return false;
+        }
+
+        for (uint16_t i = 0; i < chunkSize; i++)
+        {
+            crc = crc32Update(crc, buffer[i]);
+            packBitsPush(encoder, buffer[i]);
+        }
+    }
+    packBitsFlushRun(encoder);
+    packBitsFlushLiterals(encoder);
+
+    // Footer is written last, as appending files cannot seek back to the header
+    uint8_t footer[SNAPSHOT_FOOTER_SIZE];
+    putUInt32(footer, encoder.written);
+    putUInt32(footer + 4, crc ^ 0xFFFFFFFFUL);
+    bool success = !encoder.failed && file.write(footer, sizeof(footer)) == sizeof(footer);
+    file.close();
+
+    if (!success)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Failed to write %s", filename);
+        return false;
+    }
+
+    _compressedLength = encoder.written;
+    M1_LOG_INFO(_logger, "MemorySnapshot: Saved 0x%04X-0x%04X to %s (%lu of %lu bytes)", start, (uint16_t)(start + length - 1), filename, _compressedLength, length);
+    return true;
+}
+
+// ----------------------------------------
+// ---------- Restore
+// ----------------------------------------
+
+// Read the header and footer of a snapshot and check their consistency
+bool MemorySnapshot::_readHeader(File &file, uint8_t &flags, uint8_t &ioState, uint16_t &start, uint32_t &length)
+{
+    uint32_t fileSize = file.size();
+    if (fileSize < SNAPSHOT_HEADER_SIZE + SNAPSHOT_FOOTER_SIZE)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: File too small for a snapshot");
+        return false;
+    }
+
+    uint8_t header[SNAPSHOT_HEADER_SIZE];
+    if (!file.seek(0) || file.read(header, sizeof(header)) != (int)sizeof(header) || memcmp(header, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Not a snapshot file");
+        return false;
+    }
+    if (header[4] != SNAPSHOT_VERSION)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Unsupported snapshot version %u", header[4]);
+        return false;
+    }
+
+    flags = header[5];
+    ioState = header[6];
+    start = getUInt16(header + 8);
+    length = getUInt32(header + 10);
+
+    uint8_t footer[SNAPSHOT_FOOTER_SIZE];
+    if (!file.seek(fileSize - SNAPSHOT_FOOTER_SIZE) || file.read(footer, sizeof(footer)) != (int)sizeof(footer))
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Failed to read footer");
+        return false;
+    }
+    _compressedLength = getUInt32(footer);
+    _expectedCRC = getUInt32(footer + 4);
+
+    if (length == 0 || start + length > 0x10000UL || _compressedLength != fileSize - SNAPSHOT_HEADER_SIZE - SNAPSHOT_FOOTER_SIZE)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Corrupt snapshot header");
+        return false;
+    }
+
+    return file.seek(SNAPSHOT_HEADER_SIZE);
+}
+
+// Decompress the data section; checks the CRC, or writes the memory back through the block write path
+bool MemorySnapshot::_decode(File &file, uint16_t start, uint32_t length, bool write)
+{
+    uint8_t buffer[SNAPSHOT_BUFFER_SIZE];
+    uint32_t crc = 0xFFFFFFFFUL;
+    uint32_t remaining = length;
+    uint32_t consumed = 0;
+    uint16_t address = start;
+
+    while (remaining > 0)
+    {
+        int control = (consumed < _compressedLength) ? file.read() : -1;
+        consumed++;
+        if (control < 0)
+            break;
+        if (control == 128) // No-op
+            continue;
+
+        if (control < 128)
+        {
+            // Literal record: control + 1 bytes follow
+            uint16_t count = control + 1;
+            if (count > remaining || consumed + count > _compressedLength)
+                break;
+
+            while (count > 0)
+            {
+                uint16_t chunkSize = (count < SNAPSHOT_BUFFER_SIZE) ? count : SNAPSHOT_BUFFER_SIZE;
+                if (file.read(buffer, chunkSize) != (int)chunkSize)
+                    return false;
+                consumed += chunkSize;
+
+                for (uint16_t i = 0; i < chunkSize; i++)
+                    crc = crc32Update(crc, buffer[i]);
+                if (write && !Model1.writeMemoryFrom(address, buffer, chunkSize))
+                    return false;
+
+                address += chunkSize;
+                count -= chunkSize;
+                remaining -= chunkSize;
+            }
+        }
+        else
+        {
+            // Run record: one byte repeated 257 - control times
+            uint16_t count = 257 - control;
+            int value = (consumed < _compressedLength) ? file.read() : -1;
+            consumed++;
+            if (value < 0 || count > remaining)
+                break;
+
+            for (uint16_t i = 0; i < count; i++)
+                crc = crc32Update(crc, value);
+            if (write)
+                Model1.fillMemory((uint8_t)value, address, count);
+
+            address += count;
+            remaining -= count;
+        }
+    }
+
+    if (remaining > 0 || consumed != _compressedLength)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Compressed data is corrupt");
+        return false;
+    }
+    if ((crc ^ 0xFFFFFFFFUL) != _expectedCRC)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: CRC mismatch (expected 0x%08lX, got 0x%08lX)", _expectedCRC, crc ^ 0xFFFFFFFFUL);
+        return false;
+    }
+    return true;
+}
+
+// Check a snapshot file without touching memory
+bool MemorySnapshot::verify(const char *filename)
+{
+    if (!filename)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: verify() called with null filename");
+        return false;
+    }
+    if (!_openSD())
+        return false;
+
+    File file = SD.open(filename, FILE_READ);
+    if (!file)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Failed to open file %s", filename);
+        return false;
+    }
+
+    uint8_t flags, ioState;
+    uint16_t start;
+    uint32_t length;
+    bool success = _readHeader(file, flags, ioState, start, length) && _decode(file, start, length, false);
+    file.close();
+    return success;
+}
+
+// Verify a snapshot, then write memory and the port 0xFF latch back
+bool MemorySnapshot::restore(const char *filename, bool restoreIO)
+{
+    M1_PROFILE("MemorySnapshot::restore");
+
+    if (!filename)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: restore() called with null filename");
+        return false;
+    }
+    if (!Model1.hasActiveTestSignal())
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Test signal must be active to restore");
+        return false;
+    }
+    if (!_openSD())
+        return false;
+
+    File file = SD.open(filename, FILE_READ);
+    if (!file)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Failed to open file %s", filename);
+        return false;
+    }
+
+    uint8_t flags, ioState;
+    uint16_t start;
+    uint32_t length;
+
+    // Check the whole file first, so a damaged snapshot never reaches memory
+    if (!_readHeader(file, flags, ioState, start, length) || !_decode(file, start, length, false))
+    {
+        file.close();
+        return false;
+    }
+
+    bool success = file.seek(SNAPSHOT_HEADER_SIZE) && _decode(file, start, length, true);
+    file.close();
+
+    if (!success)
+    {
+        M1_LOG_ERR(_logger, "MemorySnapshot: Restoring %s failed, memory is partially written", filename);
+        return false;
+    }
+
+    if (restoreIO && (flags & SNAPSHOT_FLAG_IO_STATE))
+    {
+        Cassette localCassette;
+        Cassette &cassette = _cassette ? *_cassette : localCassette;
+        cassette.setState(ioState);
+    }
+
+    M1_LOG_INFO(_logger, "MemorySnapshot: Restored 0x%04X-0x%04X from %s", start, (uint16_t)(start + length - 1), filename);
+    return true;
+}
+
+// Compressed size of the last saved or restored snapshot
+uint32_t MemorySnapshot::getCompressedLength()
+{
+    return _compressedLength;
+}
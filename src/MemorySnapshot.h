@@ -0,0 +1,57 @@
+/*
+ * MemorySnapshot.h - Class for saving and restoring TRS-80 Model 1 memory state
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef MEMORYSNAPSHOT_H
+#define MEMORYSNAPSHOT_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "ILogger.h"
+#include "Cassette.h"
+
+// Default range: video RAM followed by all of RAM (0x3C00-0xFFFF)
+#define SNAPSHOT_DEFAULT_START 0x3C00
+#define SNAPSHOT_DEFAULT_LENGTH 0xC400UL
+
+// Container layout
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 16 // Magic, version, flags, IO state, start, length
+#define SNAPSHOT_FOOTER_SIZE 8  // Compressed length, CRC-32 of the uncompressed data
+
+// Header flags
+#define SNAPSHOT_FLAG_IO_STATE 0x01 // Port 0xFF latch is stored
+
+// Bytes moved per bus transfer while saving and restoring
+#ifndef SNAPSHOT_BUFFER_SIZE
+#define SNAPSHOT_BUFFER_SIZE 64
+#endif
+
+class MemorySnapshot
+{
+private:
+    ILogger *_logger;           // Logger instance for debugging output
+    Cassette *_cassette;        // Cassette interface used for the port 0xFF latch
+    uint32_t _compressedLength; // Compressed size of the last saved or restored snapshot
+    uint32_t _expectedCRC;      // CRC-32 from the footer of the file being read
+
+    bool _openSD();                                                                                     // Initialize the SD card
+    bool _readHeader(File &file, uint8_t &flags, uint8_t &ioState, uint16_t &start, uint32_t &length); // Read and check header and footer
+    bool _decode(File &file, uint16_t start, uint32_t length, bool write);                              // Decompress, checking the CRC or writing to memory
+
+public:
+    MemorySnapshot(); // Constructor
+
+    void setLogger(ILogger &logger);      // Set logger for debugging output
+    void setCassette(Cassette &cassette); // Use an existing cassette interface for the port 0xFF latch
+
+    bool save(const char *filename, uint16_t start = SNAPSHOT_DEFAULT_START, uint32_t length = SNAPSHOT_DEFAULT_LENGTH); // Save memory and IO state (bus must be active)
+    bool verify(const char *filename);                                                                                   // Check a snapshot file without touching memory
+    bool restore(const char *filename, bool restoreIO = true);                                                           // Verify, then write a snapshot back (bus must be active)
+
+    uint32_t getCompressedLength(); // Compressed size of the last saved or restored snapshot
+};
+
+#endif // MEMORYSNAPSHOT_H
@@ -6,6 +6,7 @@
 
 #include "MenuScreen.h"
 #include "M1Shield.h"
+#include "MemoryDiagnostics.h"
 #include <Adafruit_GFX.h>
 
 // Display Configuration Constants
@@ -118,7 +119,7 @@ Screen *MenuScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t offse
         uint8_t selectedIndex = _getSelectedMenuItemIndex();
         if (_isMenuItemEnabled(selectedIndex))
         {
-            if (getLogger())
+            if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && getLogger())
             {
                 if (selectedIndex < _menuItemCount && _menuItems[selectedIndex])
                 {
@@ -132,20 +133,14 @@ Screen *MenuScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t offse
             return _getSelectedMenuItemScreen(selectedIndex);
         }
         // If current item is disabled, don't activate it
-        if (getLogger())
-        {
-            getLogger()->warnF(F("MenuScreen: Attempted to select disabled menu item %d"), selectedIndex);
-        }
+        M1_LOG_WARN(getLogger(), "MenuScreen: Attempted to select disabled menu item %d", selectedIndex);
         return nullptr;
     }
 
     // Exit menu - return to previous screen
     if (action & BUTTON_MENU)
     {
-        if (getLogger())
-        {
-            getLogger()->infoF(F("MenuScreen: Exiting menu via menu button"));
-        }
+        M1_LOG_INFO(getLogger(), "MenuScreen: Exiting menu via menu button");
         return _getSelectedMenuItemScreen(-1);
     }
 
@@ -291,7 +286,7 @@ void MenuScreen::_drawContent()
                     strcpy_P(tempConfigBuffer, (const char *)configValueF);
                     configValue = tempConfigBuffer;
                 }
-                else if (getLogger())
+                else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
                 {
                     const char *currentTitle = getTitle();
                     getLogger()->errF(F("MenuScreen[%s]: Failed to allocate memory for config value display"),
@@ -434,7 +429,7 @@ void MenuScreen::setMenuItemsF(const __FlashStringHelper **menuItems, uint8_t me
     const char **tempItems = (const char **)malloc(menuItemCount * sizeof(const char *));
     if (tempItems == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("MenuScreen[%s]: Failed to allocate memory for flash menu items array"),
@@ -466,7 +461,7 @@ void MenuScreen::setMenuItemsF(const __FlashStringHelper **menuItems, uint8_t me
                     buffer[len] = '\0'; // Ensure null termination
                     tempItems[i] = buffer;
                 }
-                else if (getLogger())
+                else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
                 {
                     const char *currentTitle = getTitle();
                     getLogger()->errF(F("MenuScreen[%s]: Failed to allocate memory for flash menu item %d"),
@@ -502,10 +497,10 @@ void MenuScreen::setMenuItems(const char **menuItems, uint8_t menuItemCount)
     }
 
     // Allocate array of string pointers
-    _menuItems = (char **)malloc(menuItemCount * sizeof(char *));
+    _menuItems = (char **)MemoryDiagnostics.allocate(menuItemCount * sizeof(char *), MEMORY_TAG_MENU);
     if (_menuItems == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("MenuScreen[%s]: Failed to allocate memory for menu items array"),
@@ -527,14 +522,14 @@ void MenuScreen::setMenuItems(const char **menuItems, uint8_t menuItemCount)
         if (menuItems[i] != nullptr)
         {
             size_t len = strlen(menuItems[i]);
-            char *itemCopy = (char *)malloc(len + 1);
+            char *itemCopy = (char *)MemoryDiagnostics.allocate(len + 1, MEMORY_TAG_MENU);
             if (itemCopy != nullptr)
             {
                 strcpy(itemCopy, menuItems[i]);
                 _menuItems[i] = itemCopy;
                 successCount++;
             }
-            else if (getLogger())
+            else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
             {
                 const char *currentTitle = getTitle();
                 getLogger()->errF(F("MenuScreen[%s]: Failed to allocate memory for menu item %d"),
@@ -576,7 +571,7 @@ void MenuScreen::setMenuItems(String *menuItems, uint8_t menuItemCount)
     }
 
     // Allocate array of string pointers
-    _menuItems = (char **)malloc(menuItemCount * sizeof(char *));
+    _menuItems = (char **)MemoryDiagnostics.allocate(menuItemCount * sizeof(char *), MEMORY_TAG_MENU);
     if (_menuItems == nullptr)
     {
         return; // Allocation failed
@@ -596,14 +591,14 @@ void MenuScreen::setMenuItems(String *menuItems, uint8_t menuItemCount)
         if (cstr != nullptr)
         {
             size_t len = strlen(cstr);
-            char *itemCopy = (char *)malloc(len + 1);
+            char *itemCopy = (char *)MemoryDiagnostics.allocate(len + 1, MEMORY_TAG_MENU);
             if (itemCopy != nullptr)
             {
                 strcpy(itemCopy, cstr);
                 _menuItems[i] = itemCopy;
                 successCount++;
             }
-            else if (getLogger())
+            else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
             {
                 const char *currentTitle = getTitle();
                 getLogger()->errF(F("MenuScreen[%s]: Failed to allocate memory for menu item %d"),
@@ -676,12 +671,12 @@ void MenuScreen::clearMenuItems()
         {
             if (_menuItems[i] != nullptr)
             {
-                free(_menuItems[i]);
+                MemoryDiagnostics.release(_menuItems[i], MEMORY_TAG_MENU);
             }
         }
 
         // Free the array of pointers
-        free(_menuItems);
+        MemoryDiagnostics.release(_menuItems, MEMORY_TAG_MENU);
     }
 
     // Reset state
@@ -8,6 +8,11 @@
 #include "utils.h"
 #include <SD.h>
 #include "Model1LowLevel.h"
+#include "bus_timing.h"
+#include "Video.h"
+#include "ShadowMemory.h"
+#include "MemoryDiagnostics.h"
+#include "Profiler.h"
 
 // Refresh trigger
 //
@@ -24,6 +29,43 @@
 //   (124+1) x 62.5ns = 7.8125us -> 7.8125us * 128 rows => 1.0ms
 #define CTC_TRIGGER 89
 
+// Burst transfers
+//
+// Bus cycles executed with interrupts disabled before a burst briefly restores
+// them, so millis() and the serial port get serviced. 16 cycles keep that
+// latency around 50us.
+//
+// The refresh timer ISR is paused during a burst. The burst polls the timer's
+// compare flag between bus cycles instead and refreshes the due row inline, so
+// refresh keeps its cadence without paying for ISR entry and exit.
+#define BURST_CHUNK_SIZE 16
+
+// Size of the stack buffer used when copying memory through the Arduino
+#define BURST_BUFFER_SIZE 32
+
+// DRAM page mode
+//
+// The 4116 DRAMs start at 0x4000. Their row is taken from A0-A6 (the same
+// bits the refresh cycles through), so addresses 128 bytes apart share a row.
+// While RAS stays low, only new columns are strobed with CAS.
+//
+// tRAS of the 4116 is 10us at most. A page-mode column cycle takes about
+// 1.2us, so 4 columns per row stay well within the limit.
+#define DRAM_START 0x4000
+#define DRAM_ROWS 128
+#define PAGE_MODE_MAX_COLUMNS 4
+
+// Shorter DRAM blocks have at most one column per row, so page mode would
+// only add the row grouping to a full RAS cycle per byte
+#define PAGE_MODE_MIN_LENGTH (2 * DRAM_ROWS)
+
+// Memory search
+//
+// Longest pattern accepted by searchMemory() and the size of the window it
+// reads the memory through. The window has to hold at least one pattern.
+#define SEARCH_MAX_PATTERN 32
+#define SEARCH_WINDOW_SIZE 64
+
 // Version constants
 #define M1_VERSION_MAJOR 1
 #define M1_VERSION_MINOR 4
@@ -37,10 +79,21 @@ Model1Class::Model1Class()
 {
     _logger = nullptr;
     _timer = -1; // Set to default off
+    _refreshPaused = false;
+    _shadow = nullptr;
+
+    // Refresh monitor is opt-in
+    _refreshTimes = nullptr;
+    _refreshMonitorShift = 0;
+    _refreshReportedViolations = 0;
+    memset(&_refreshStatistics, 0, sizeof(_refreshStatistics));
 
     // Defines the mutability of the bus systems and signals (e.g. activate TEST signal)
     _mutability = false;
 
+    // Page mode is opt-in
+    _pageMode = false;
+
     // Initializes memory refresh to default values
     deactivateMemoryRefresh();
 }
@@ -51,8 +104,7 @@ void Model1Class::begin(int refreshTimer)
     // Validate refresh timer parameter
     if (refreshTimer != -1 && refreshTimer != 1 && refreshTimer != 2)
     {
-        if (_logger)
-            _logger->warnF(F("Model1: Invalid refresh timer %d. Valid values are -1 (disabled), 1, or 2. Using disabled."), refreshTimer);
+        M1_LOG_WARN(_logger, "Model1: Invalid refresh timer %d. Valid values are -1 (disabled), 1, or 2. Using disabled.", refreshTimer);
         refreshTimer = -1;
     }
 
@@ -94,6 +146,7 @@ void Model1Class::end()
     _deactivateBusAccessSignals();
 
     deactivateMemoryRefresh();
+    deactivateRefreshMonitor();
 }
 
 // Set the logger for debugging output
@@ -190,8 +243,7 @@ bool Model1Class::_checkMutability()
     bool mutability = _isMutable();
     if (!_isMutable())
     {
-        if (_logger)
-            _logger->errF(F("System is not mutable, but a request to access the system was made."));
+        M1_LOG_ERR(_logger, "System is not mutable, but a request to access the system was made.");
     }
     return mutability;
 }
@@ -243,6 +295,9 @@ void Model1Class::_setupMemoryRefreshTimer2()
 // Activate memory refresh
 void Model1Class::activateMemoryRefresh()
 {
+    // The Z80 refreshed the rows up to now
+    _primeRefreshMonitor();
+
     _activeRefresh = true;
     if (_timer == 1)
     {
@@ -270,9 +325,262 @@ void Model1Class::deactivateMemoryRefresh()
     _activeRefresh = false;
 }
 
+// Pause the refresh timer ISR, leaving the timer running to mark due rows
+void Model1Class::_pauseRefresh()
+{
+    if (!_activeRefresh)
+        return;
+
+    if (_timer == 1)
+    {
+        TIMSK1 &= ~(1 << OCIE1A); // Disable timer compare interrupt
+    }
+    else if (_timer == 2)
+    {
+        TIMSK2 &= ~(1 << OCIE2A); // Disable timer compare interrupt
+    }
+    else
+    {
+        return;
+    }
+    _refreshPaused = true;
+}
+
+// Resume the refresh timer ISR; a row that became due in the meantime is refreshed right away
+void Model1Class::_resumeRefresh()
+{
+    if (!_refreshPaused)
+        return;
+    _refreshPaused = false;
+
+    if (_timer == 1)
+    {
+        TIMSK1 |= (1 << OCIE1A); // Enable timer compare interrupt
+    }
+    else if (_timer == 2)
+    {
+        TIMSK2 |= (1 << OCIE2A); // Enable timer compare interrupt
+    }
+}
+
+// Refresh the next row if the paused timer marked it as due
+// Returns true when the address bus was changed by a refresh
+bool Model1Class::_serviceRefresh()
+{
+    if (!_refreshPaused)
+        return false;
+
+    if (_timer == 1)
+    {
+        if (!(TIFR1 & (1 << OCF1A)))
+            return false;
+        TIFR1 = (1 << OCF1A); // Clear flag by writing a one
+    }
+    else
+    {
+        if (!(TIFR2 & (1 << OCF2A)))
+            return false;
+        TIFR2 = (1 << OCF2A); // Clear flag by writing a one
+    }
+
+    _refreshNextMemoryRow();
+    return true;
+}
+
+// ----------------------------------------
+// ---------- Refresh Monitor
+// ----------------------------------------
+
+// Track the refresh gaps of every rowStride-th row; the stride keeps the work per refresh interrupt small
+bool Model1Class::activateRefreshMonitor(uint8_t rowStride)
+{
+    if (rowStride == 0 || (rowStride & (rowStride - 1)))
+    {
+        M1_LOG_ERR(_logger, "Model1: Refresh monitor stride %u is not a power of two", rowStride);
+        return false;
+    }
+
+    uint8_t shift = 0;
+    while ((1 << shift) < rowStride)
+        shift++;
+
+    deactivateRefreshMonitor();
+
+    uint32_t *times = (uint32_t *)MemoryDiagnostics.allocate((128 >> shift) * sizeof(uint32_t), MEMORY_TAG_MODEL1);
+    if (!times)
+    {
+        M1_LOG_ERR(_logger, "Model1: Not enough memory for the refresh monitor");
+        return false;
+    }
+
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    _refreshMonitorShift = shift;
+    _refreshTimes = times;
+    SREG = oldSREG;
+
+    resetRefreshStatistics();
+    _primeRefreshMonitor();
+    return true;
+}
+
+// Stop tracking and free the timestamps
+void Model1Class::deactivateRefreshMonitor()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    uint32_t *times = _refreshTimes;
+    _refreshTimes = nullptr;
+    SREG = oldSREG;
+
+    MemoryDiagnostics.release(times, MEMORY_TAG_MODEL1);
+}
+
+// Check if the refresh monitor is active
+bool Model1Class::hasActiveRefreshMonitor()
+{
+    return _refreshTimes != nullptr;
+}
+
+// Copy the statistics with interrupts disabled, so a refresh cannot update them halfway
+RefreshStatistics Model1Class::getRefreshStatistics()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    RefreshStatistics statistics = _refreshStatistics;
+    SREG = oldSREG;
+
+    return statistics;
+}
+
+// Clear the statistics
+void Model1Class::resetRefreshStatistics()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    memset(&_refreshStatistics, 0, sizeof(_refreshStatistics));
+    _refreshReportedViolations = 0;
+    SREG = oldSREG;
+}
+
+// Log gaps over the retention time since the last check; false if any occurred since the last reset
+bool Model1Class::checkRefreshHealth()
+{
+    RefreshStatistics statistics = getRefreshStatistics();
+
+    if (statistics.violations != _refreshReportedViolations)
+    {
+        M1_LOG_WARN(_logger, "Model1: %lu refresh gap(s) over %u us, longest %lu us at row %u",
+                    (unsigned long)(statistics.violations - _refreshReportedViolations),
+                    M1_DRAM_RETENTION_US,
+                    (unsigned long)statistics.maxGap,
+                    statistics.maxGapRow);
+        _refreshReportedViolations = statistics.violations;
+    }
+
+    return statistics.violations == 0;
+}
+
+// Record the refresh of a monitored row; called from the refresh ISR
+void Model1Class::_monitorRefresh(uint8_t row)
+{
+    uint32_t now = micros();
+    uint8_t index = row >> _refreshMonitorShift;
+    uint32_t gap = now - _refreshTimes[index];
+    _refreshTimes[index] = now;
+
+    if (row == 0)
+        _refreshStatistics.rounds++;
+
+    if (gap > _refreshStatistics.maxGap)
+    {
+        _refreshStatistics.maxGap = gap;
+        _refreshStatistics.maxGapRow = row;
+    }
+
+    if (gap > M1_DRAM_RETENTION_US)
+        _refreshStatistics.violations++;
+}
+
+// Restart the gaps of all monitored rows, e.g. when refresh is taken over from the Z80
+void Model1Class::_primeRefreshMonitor()
+{
+    if (!_refreshTimes)
+        return;
+
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < (128 >> _refreshMonitorShift); i++)
+        _refreshTimes[i] = now;
+    SREG = oldSREG;
+}
+
+// ----------------------------------------
+// ---------- Shadow Memory
+// ----------------------------------------
+
+// Serve cached ranges from a shadow copy while the bus is held
+void Model1Class::setShadowMemory(ShadowMemory &shadow)
+{
+    removeShadowMemory();
+    shadow.invalidate();
+    _shadow = &shadow;
+}
+
+// Check if a shadow copy is attached
+bool Model1Class::hasShadowMemory()
+{
+    return _shadow != nullptr;
+}
+
+// Write back pending changes and detach the shadow copy
+void Model1Class::removeShadowMemory()
+{
+    if (!_shadow)
+        return;
+
+    if (_shadow->isDirty())
+    {
+        if (_isMutable())
+            _shadow->flush();
+        else
+            M1_LOG_WARN(_logger, "Model1: Shadow memory removed with unflushed writes");
+    }
+    _shadow->invalidate();
+    _shadow = nullptr;
+}
+
+// Activate DRAM page mode for block transfers
+void Model1Class::activatePageMode()
+{
+    _pageMode = true;
+}
+
+// Deactivate DRAM page mode for block transfers
+void Model1Class::deactivatePageMode()
+{
+    _pageMode = false;
+}
+
+// Check if DRAM page mode is active
+bool Model1Class::hasActivePageMode()
+{
+    return _pageMode;
+}
+
 // Refresh the next memory row
 void Model1Class::nextUpdate()
 {
+#if defined(M1_PROFILING)
+    // Only every 64th refresh is measured; measuring each one would take longer than the refresh period
+    if ((_nextMemoryRefreshRow & 0x3F) == 0)
+    {
+        M1_PROFILE("Model1::refresh");
+        _refreshNextMemoryRow();
+        return;
+    }
+#endif
     _refreshNextMemoryRow();
 }
 
@@ -290,12 +598,14 @@ void Model1Class::_refreshNextMemoryRow()
 
     // Timing of various signals
     Model1LowLevel::writeRAS(LOW); // 45ns (62.5ns, but when the pulse is down)
-    asmNoop();                     // 125ns
-    asmNoop();                     // 125ns
-    asmNoop();                     // 125ns
+    busDelay<M1_DRAM_T_RAS_NS>();
 
     // Reset, leaving address as-is
     Model1LowLevel::writeRAS(HIGH); // 45ns (62.5ns, but when the pulse is down)
+
+    // Covers refreshes from the ISR as well as inline ones during bursts
+    if (_refreshTimes && !(currentRefreshRow & ((1 << _refreshMonitorShift) - 1)))
+        _monitorRefresh(currentRefreshRow);
 }
 
 // ----------------------------------------
@@ -305,10 +615,19 @@ void Model1Class::_refreshNextMemoryRow()
 // Read memory with single byte
 uint8_t Model1Class::readMemory(uint16_t address)
 {
+    M1_PROFILE("Model1::readMemory");
+
     // Verification of access
     if (!_checkMutability())
         return 0;
 
+    if (_shadow && _shadow->covers(address))
+    {
+        uint8_t data;
+        _shadow->read(address, &data, 1);
+        return data;
+    }
+
     uint8_t oldSREG = SREG;
     noInterrupts();
 
@@ -320,7 +639,7 @@ uint8_t Model1Class::readMemory(uint16_t address)
     Model1LowLevel::writeRD(LOW);
     Model1LowLevel::writeMUX(HIGH);
     Model1LowLevel::writeCAS(LOW);
-    asmWait(3); // 772 ns
+    busDelay<M1_READ_ACCESS_NS>();
 
     // Read data
     uint8_t data = _dataBus.readData();
@@ -339,10 +658,18 @@ uint8_t Model1Class::readMemory(uint16_t address)
 // Write memory with single byte
 void Model1Class::writeMemory(uint16_t address, uint8_t data)
 {
+    M1_PROFILE("Model1::writeMemory");
+
     // Verification of access
     if (!_checkMutability())
         return;
 
+    if (_shadow && _shadow->covers(address))
+    {
+        _shadow->write(address, &data, 1, 1);
+        return;
+    }
+
     uint8_t oldSREG = SREG;
     noInterrupts();
 
@@ -355,13 +682,11 @@ void Model1Class::writeMemory(uint16_t address, uint8_t data)
 
     // Timing of various signals
     Model1LowLevel::writeRAS(LOW);
-    asmNoop();
-    asmNoop();
-    asmNoop();
+    busDelay<M1_WRITE_ROW_SETUP_NS>();
     Model1LowLevel::writeWR(LOW);
     Model1LowLevel::writeMUX(HIGH);
     Model1LowLevel::writeCAS(LOW);
-    asmWait(1); // 252 ns
+    busDelay<M1_WRITE_PULSE_NS>();
 
     // Reset, leaving address as-is, removing data
     Model1LowLevel::writeWR(HIGH);
@@ -373,6 +698,45 @@ void Model1Class::writeMemory(uint16_t address, uint8_t data)
     SREG = oldSREG;
 }
 
+// Read memory block into a caller-owned buffer
+bool Model1Class::readMemoryInto(uint16_t address, uint8_t *buffer, uint16_t length)
+{
+    if (!buffer)
+    {
+        M1_LOG_ERR(_logger, "Model1: readMemoryInto called with null buffer pointer");
+        return false;
+    }
+    if (length == 0)
+        return true;
+
+    if (!_checkBurstAccess())
+    {
+        memset(buffer, 0, length);
+        return false;
+    }
+
+    _readMemoryBurst(address, buffer, length);
+    return true;
+}
+
+// Write memory block from a caller-owned buffer
+bool Model1Class::writeMemoryFrom(uint16_t address, const uint8_t *buffer, uint16_t length)
+{
+    if (!buffer)
+    {
+        M1_LOG_ERR(_logger, "Model1: writeMemoryFrom called with null buffer pointer");
+        return false;
+    }
+    if (length == 0)
+        return true;
+
+    if (!_checkBurstAccess())
+        return false;
+
+    _writeMemoryBurst(address, buffer, length, length);
+    return true;
+}
+
 // Read memory with length
 uint8_t *Model1Class::readMemory(uint16_t address, uint16_t length)
 {
@@ -382,17 +746,11 @@ uint8_t *Model1Class::readMemory(uint16_t address, uint16_t length)
     uint8_t *buffer = (uint8_t *)malloc(length * sizeof(uint8_t));
     if (!buffer)
     {
-        if (_logger)
-        {
-            _logger->errF(F("Model1: Failed to allocate memory buffer for readMemory (%u bytes)"), length);
-        }
+        M1_LOG_ERR(_logger, "Model1: Failed to allocate memory buffer for readMemory (%u bytes)", length);
         return nullptr;
     }
 
-    for (uint16_t i = 0; i < length; i++)
-    {
-        buffer[i] = readMemory(address + i);
-    }
+    readMemoryInto(address, buffer, length);
 
     return buffer;
 }
@@ -402,8 +760,7 @@ void Model1Class::writeMemory(uint16_t address, uint8_t *data, uint16_t length)
 {
     if (!data)
     {
-        if (_logger)
-            _logger->errF(F("Model1: writeMemory called with null data pointer"));
+        M1_LOG_ERR(_logger, "Model1: writeMemory called with null data pointer");
         return;
     }
     writeMemory(address, data, length, 0);
@@ -414,20 +771,15 @@ void Model1Class::writeMemory(uint16_t address, uint8_t *data, uint16_t length,
 {
     if (!data)
     {
-        if (_logger)
-            _logger->errF(F("Model1: writeMemory called with null data pointer"));
+        M1_LOG_ERR(_logger, "Model1: writeMemory called with null data pointer");
         return;
     }
     if (length == 0)
     {
-        if (_logger)
-            _logger->warnF(F("Model1: writeMemory called with length 0"));
+        M1_LOG_WARN(_logger, "Model1: writeMemory called with length 0");
         return;
     }
-    for (uint16_t i = 0; i < length; i++)
-    {
-        writeMemory(address + i, data[offset + i]);
-    }
+    writeMemoryFrom(address, data + offset, length);
 }
 
 // Copy memory from one location to another
@@ -435,38 +787,43 @@ void Model1Class::copyMemory(uint16_t src_address, uint16_t dst_address, uint16_
 {
     if (length == 0)
     {
-        if (_logger)
-            _logger->warnF(F("Model1: Copy memory called with length 0 - no action taken"));
+        M1_LOG_WARN(_logger, "Model1: Copy memory called with length 0 - no action taken");
         return;
     }
     if (dst_address == src_address)
     {
-        if (_logger)
-            _logger->warnF(F("Model1: Copy memory called with same src and dst address 0x%04X - no action taken"), src_address);
+        M1_LOG_WARN(_logger, "Model1: Copy memory called with same src and dst address 0x%04X - no action taken", src_address);
         return;
     }
+    if (!_checkBurstAccess())
+        return;
 
-    // Check for potential dangerous address overlap
-    if ((src_address < dst_address && src_address + length > dst_address) ||
-        (dst_address < src_address && dst_address + length > src_address))
-    {
-        if (_logger)
-            _logger->warnF(F("Model1: Memory copy addresses overlap - src:0x%04X dst:0x%04X len:%d may cause data corruption"), src_address, dst_address, length);
-    }
+    // Copy from the end when the destination overlaps the tail of the source
+    bool backwards = (src_address < dst_address) && ((uint32_t)src_address + length > dst_address);
 
-    for (uint16_t i = 0; i < length; i++)
+    uint8_t buffer[BURST_BUFFER_SIZE];
+    uint16_t remaining = length;
+    while (remaining > 0)
     {
-        writeMemory(dst_address + i, readMemory(src_address + i));
+        uint16_t chunkSize = (remaining < BURST_BUFFER_SIZE) ? remaining : BURST_BUFFER_SIZE;
+        uint16_t offset = backwards ? (remaining - chunkSize) : (length - remaining);
+
+        _readMemoryBurst(src_address + offset, buffer, chunkSize);
+        _writeMemoryBurst(dst_address + offset, buffer, chunkSize, chunkSize);
+
+        remaining -= chunkSize;
     }
 }
 
 // Fill memory with a single value
 void Model1Class::fillMemory(uint8_t fill_data, uint16_t address, uint16_t length)
 {
-    for (uint16_t i = 0; i < length; i++)
-    {
-        writeMemory(address + i, fill_data);
-    }
+    if (length == 0)
+        return;
+    if (!_checkBurstAccess())
+        return;
+
+    _writeMemoryBurst(address, &fill_data, 1, length);
 }
 
 // Fill memory with data from a buffer
@@ -474,33 +831,668 @@ void Model1Class::fillMemory(uint8_t *fill_data, uint16_t length, uint16_t addre
 {
     if (!fill_data)
     {
-        if (_logger)
-            _logger->errF(F("Model1: fillMemory called with null fill_data pointer"));
+        M1_LOG_ERR(_logger, "Model1: fillMemory called with null fill_data pointer");
         return;
     }
     if (length == 0)
     {
-        if (_logger)
-            _logger->warnF(F("Model1: fillMemory called with length 0"));
+        M1_LOG_WARN(_logger, "Model1: fillMemory called with length 0");
         return;
     }
     if (address_length == 0)
     {
-        if (_logger)
-            _logger->warnF(F("Model1: fillMemory called with address_length 0"));
+        M1_LOG_WARN(_logger, "Model1: fillMemory called with address_length 0");
         return;
     }
-    for (uint16_t i = 0; i < address_length; i += length)
+    if (!_checkBurstAccess())
+        return;
+
+    _writeMemoryBurst(address, fill_data, length, address_length);
+}
+
+// ----------------------------------------
+// ---------- Verify
+// ----------------------------------------
+
+// Stream a block of memory through the requested checksums without keeping it
+bool Model1Class::_checksumMemory(uint16_t address, uint16_t length, uint16_t *sum, uint16_t *crc16, uint32_t *crc32)
+{
+    if (sum)
+        *sum = 0;
+    if (crc16)
+        *crc16 = 0xFFFF;
+    if (crc32)
+        *crc32 = 0xFFFFFFFFUL;
+
+    if (length > 0 && !_checkBurstAccess())
+        return false;
+
+    uint8_t buffer[BURST_BUFFER_SIZE];
+    for (uint32_t offset = 0; offset < length; offset += BURST_BUFFER_SIZE)
     {
-        for (uint16_t j = 0; j < length; j++)
+        uint16_t chunkSize = (length - offset < BURST_BUFFER_SIZE) ? (length - offset) : BURST_BUFFER_SIZE;
+        _readMemoryBurst(address + offset, buffer, chunkSize);
+
+        for (uint16_t i = 0; i < chunkSize; i++)
         {
-            writeMemory(address + i + j, fill_data[j]);
+            if (sum)
+                *sum += buffer[i];
+            if (crc16)
+                *crc16 = crc16Update(*crc16, buffer[i]);
+            if (crc32)
+                *crc32 = crc32Update(*crc32, buffer[i]);
+        }
+    }
+
+    if (crc32)
+        *crc32 ^= 0xFFFFFFFFUL;
+
+    return true;
+}
 
-            // Check if we reached the end address
-            if (i + j >= address_length)
-                return;
+// Get the 16-bit sum of a memory block
+uint16_t Model1Class::getMemoryChecksum(uint16_t address, uint16_t length)
+{
+    uint16_t sum;
+    if (!_checksumMemory(address, length, &sum, nullptr, nullptr))
+        return 0;
+    return sum;
+}
+
+// Get the CRC-16/CCITT-FALSE of a memory block
+uint16_t Model1Class::getMemoryCRC16(uint16_t address, uint16_t length)
+{
+    uint16_t crc;
+    if (!_checksumMemory(address, length, nullptr, &crc, nullptr))
+        return 0;
+    return crc;
+}
+
+// Get the CRC-32 of a memory block
+uint32_t Model1Class::getMemoryCRC32(uint16_t address, uint16_t length)
+{
+    uint32_t crc;
+    if (!_checksumMemory(address, length, nullptr, nullptr, &crc))
+        return 0;
+    return crc;
+}
+
+// Compare a memory block against a buffer, returning the number of differing bytes or -1 on error
+int32_t Model1Class::compareMemory(uint16_t address, const uint8_t *expected, uint16_t length, uint16_t *firstMismatch)
+{
+    if (!expected)
+    {
+        M1_LOG_ERR(_logger, "Model1: compareMemory called with null buffer pointer");
+        return -1;
+    }
+    if (length > 0 && !_checkBurstAccess())
+        return -1;
+
+    int32_t mismatches = 0;
+    uint8_t buffer[BURST_BUFFER_SIZE];
+    for (uint32_t offset = 0; offset < length; offset += BURST_BUFFER_SIZE)
+    {
+        uint16_t chunkSize = (length - offset < BURST_BUFFER_SIZE) ? (length - offset) : BURST_BUFFER_SIZE;
+        _readMemoryBurst(address + offset, buffer, chunkSize);
+
+        for (uint16_t i = 0; i < chunkSize; i++)
+        {
+            if (buffer[i] != expected[offset + i])
+            {
+                if (mismatches == 0 && firstMismatch)
+                    *firstMismatch = address + offset + i;
+                mismatches++;
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+// Compare memory against the contents of an SD card file, returning the number of differing bytes or -1 on error
+int32_t Model1Class::compareMemoryToSD(uint16_t address, const char *filename, uint16_t *firstMismatch)
+{
+    if (!filename)
+    {
+        M1_LOG_ERR(_logger, "Model1: compareMemoryToSD() called with null filename");
+        return -1;
+    }
+
+    // Initialize SD card if not already done
+    if (!SD.begin(M1Shield.getSDCardSelectPin()))
+    {
+        M1_LOG_ERR(_logger, "Model1: Failed to initialize SD card");
+        return -1;
+    }
+
+    File file = SD.open(filename, FILE_READ);
+    if (!file)
+    {
+        M1_LOG_ERR(_logger, "Model1: Failed to open file %s for reading", filename);
+        return -1;
+    }
+
+    // Compare no further than the end of the address space
+    uint32_t length = file.size();
+    if (length > 0x10000UL - address)
+    {
+        M1_LOG_WARN(_logger, "Model1: File %s is larger than the memory after 0x%04X, comparing %lu bytes", filename, address, 0x10000UL - address);
+        length = 0x10000UL - address;
+    }
+
+    if (length > 0 && !_checkBurstAccess())
+    {
+        file.close();
+        return -1;
+    }
+
+    int32_t mismatches = 0;
+    uint8_t buffer[BURST_BUFFER_SIZE];
+    uint8_t expected[BURST_BUFFER_SIZE];
+    for (uint32_t offset = 0; offset < length; offset += BURST_BUFFER_SIZE)
+    {
+        uint16_t chunkSize = (length - offset < BURST_BUFFER_SIZE) ? (length - offset) : BURST_BUFFER_SIZE;
+        if (file.read(expected, chunkSize) != chunkSize)
+        {
+            M1_LOG_ERR(_logger, "Model1: Failed to read file %s at offset %lu", filename, offset);
+            file.close();
+            return -1;
+        }
+        _readMemoryBurst(address + offset, buffer, chunkSize);
+
+        for (uint16_t i = 0; i < chunkSize; i++)
+        {
+            if (buffer[i] != expected[i])
+            {
+                if (mismatches == 0 && firstMismatch)
+                    *firstMismatch = address + offset + i;
+                mismatches++;
+            }
+        }
+    }
+
+    file.close();
+    return mismatches;
+}
+
+// Read, check and write each cell before moving on to the next, in ascending or descending address order
+// Returns the number of cells that differed from expected, or -1 on error
+int32_t Model1Class::verifyAndWriteMemory(uint16_t address, uint16_t length, const uint8_t *expected, const uint8_t *data, bool down, uint8_t *actual)
+{
+    M1_PROFILE("Model1::verifyAndWriteMemory");
+
+    if (!expected || !data)
+    {
+        M1_LOG_ERR(_logger, "Model1: verifyAndWriteMemory called with null buffer pointer");
+        return -1;
+    }
+    if (length == 0)
+        return 0;
+    if (!_checkBurstAccess())
+        return -1;
+
+    // The cells have to be visited on the bus; a cached copy would be tested instead and left stale
+    if (_shadow)
+    {
+        M1_LOG_ERR(_logger, "Model1: verifyAndWriteMemory() cannot be used while a shadow memory is attached");
+        return -1;
+    }
+
+    _pauseRefresh();
+
+    int32_t mismatches = 0;
+    uint16_t done = 0;
+    while (done < length)
+    {
+        uint16_t chunkEnd = (length - done > BURST_CHUNK_SIZE) ? (done + BURST_CHUNK_SIZE) : length;
+
+        uint8_t oldSREG = SREG;
+        noInterrupts();
+
+        for (; done < chunkEnd; done++)
+        {
+            _serviceRefresh();
+
+            uint16_t index = down ? (length - 1 - done) : done;
+            Model1LowLevel::writeAddressBus(address + index);
+
+            // Read cycle
+            Model1LowLevel::writeRAS(LOW);
+            Model1LowLevel::writeRD(LOW);
+            Model1LowLevel::writeMUX(HIGH);
+            Model1LowLevel::writeCAS(LOW);
+            busDelay<M1_READ_ACCESS_NS>();
+
+            uint8_t value = Model1LowLevel::readDataBus();
+
+            Model1LowLevel::writeCAS(HIGH);
+            Model1LowLevel::writeRD(HIGH);
+            Model1LowLevel::writeRAS(HIGH);
+            Model1LowLevel::writeMUX(LOW);
+
+            // Write cycle to the same cell
+            _dataBus.setAsWritable();
+            Model1LowLevel::writeDataBus(data[index]);
+
+            Model1LowLevel::writeRAS(LOW);
+            busDelay<M1_WRITE_ROW_SETUP_NS>();
+            Model1LowLevel::writeWR(LOW);
+            Model1LowLevel::writeMUX(HIGH);
+            Model1LowLevel::writeCAS(LOW);
+            busDelay<M1_WRITE_PULSE_NS>();
+
+            Model1LowLevel::writeWR(HIGH);
+            Model1LowLevel::writeCAS(HIGH);
+            Model1LowLevel::writeRAS(HIGH);
+            Model1LowLevel::writeMUX(LOW);
+            _dataBus.setAsReadable();
+
+            if (value != expected[index])
+                mismatches++;
+            if (actual)
+                actual[index] = value;
+        }
+
+        SREG = oldSREG;
+    }
+
+    _resumeRefresh();
+
+    return mismatches;
+}
+
+// ----------------------------------------
+// ---------- Search
+// ----------------------------------------
+
+// Find all occurrences of a byte pattern, reporting each to the callback
+// Bits cleared in mask are ignored (mask may be null); returns the number of matches or -1 on error
+int32_t Model1Class::searchMemory(uint16_t address, uint16_t length, const uint8_t *pattern, const uint8_t *mask, uint8_t patternLength, MemoryMatchCallback callback)
+{
+    if (!pattern)
+    {
+        M1_LOG_ERR(_logger, "Model1: searchMemory called with null pattern pointer");
+        return -1;
+    }
+    if (patternLength == 0 || patternLength > SEARCH_MAX_PATTERN)
+    {
+        M1_LOG_ERR(_logger, "Model1: searchMemory pattern length %u not within 1-%u", patternLength, SEARCH_MAX_PATTERN);
+        return -1;
+    }
+    if (length < patternLength)
+        return 0;
+    if (!_checkBurstAccess())
+        return -1;
+
+    // Horspool skip table; a byte matching a pattern position (under its mask) limits the shift to that position
+    uint8_t skip[256];
+    memset(skip, patternLength, sizeof(skip));
+    for (uint8_t j = 0; j < patternLength - 1; j++)
+    {
+        uint8_t m = mask ? mask[j] : 0xFF;
+        uint8_t p = pattern[j] & m;
+        for (uint16_t c = 0; c < 256; c++)
+        {
+            if ((c & m) == p)
+                skip[c] = patternLength - 1 - j;
+        }
+    }
+
+    uint8_t window[SEARCH_WINDOW_SIZE];
+    uint32_t windowOffset = 0; // Offset of window[0] from address
+    uint16_t windowFill = 0;   // Valid bytes in window
+    uint32_t position = 0;     // Offset of the current alignment from address
+    int32_t matches = 0;
+
+    while (position + patternLength <= length)
+    {
+        // Slide the window when the alignment runs past its end, keeping the bytes still needed
+        if (position + patternLength > windowOffset + windowFill)
+        {
+            uint16_t keep = (position < windowOffset + windowFill) ? (windowOffset + windowFill - position) : 0;
+            memmove(window, window + windowFill - keep, keep);
+            windowOffset = position;
+
+            uint32_t remaining = length - (position + keep);
+            uint16_t readSize = (remaining < (uint32_t)(SEARCH_WINDOW_SIZE - keep)) ? remaining : (SEARCH_WINDOW_SIZE - keep);
+            _readMemoryBurst(address + position + keep, window + keep, readSize);
+            windowFill = keep + readSize;
+        }
+
+        // Compare from the end, as the skip table is keyed on the last byte
+        const uint8_t *candidate = window + (position - windowOffset);
+        int16_t i = patternLength - 1;
+        while (i >= 0 && ((candidate[i] ^ pattern[i]) & (mask ? mask[i] : 0xFF)) == 0)
+            i--;
+
+        if (i < 0)
+        {
+            matches++;
+            if (callback && !callback(address + position))
+                break;
+        }
+
+        position += skip[candidate[patternLength - 1]];
+    }
+
+    return matches;
+}
+
+// Find all occurrences of a string, reporting each to the callback
+// With model1Charset the string is matched as the Model I stores it in video RAM; returns the number of matches or -1 on error
+int32_t Model1Class::searchMemory(uint16_t address, uint16_t length, const char *str, MemoryMatchCallback callback, bool model1Charset, bool hasLowerCaseMod)
+{
+    if (!str)
+    {
+        M1_LOG_ERR(_logger, "Model1: searchMemory called with null string pointer");
+        return -1;
+    }
+
+    size_t strLength = strlen(str);
+    if (strLength == 0 || strLength > SEARCH_MAX_PATTERN)
+    {
+        M1_LOG_ERR(_logger, "Model1: searchMemory string length %u not within 1-%u", strLength, SEARCH_MAX_PATTERN);
+        return -1;
+    }
+
+    uint8_t pattern[SEARCH_MAX_PATTERN];
+    uint8_t mask[SEARCH_MAX_PATTERN];
+    for (size_t i = 0; i < strLength; i++)
+    {
+        if (model1Charset)
+        {
+            pattern[i] = Video::convertLocalCharacterToModel1(str[i], hasLowerCaseMod);
+
+            // Without the lowercase mod, bit 6 of upper-case letters is not stored; the high bit selects graphics
+            mask[i] = (!hasLowerCaseMod && pattern[i] >= 64 && pattern[i] < 96) ? 0x3F : 0x7F;
+        }
+        else
+        {
+            pattern[i] = str[i];
+            mask[i] = 0xFF;
         }
     }
+
+    return searchMemory(address, length, pattern, mask, strLength, callback);
+}
+
+// ----------------------------------------
+// ---------- Burst
+// ----------------------------------------
+
+// Check once for a whole burst what every single access would check
+bool Model1Class::_checkBurstAccess()
+{
+    if (!_checkMutability())
+        return false;
+
+    if (!_addressBus.isWritable())
+    {
+        M1_LOG_ERR(_logger, "Address bus is not writable.");
+        return false;
+    }
+
+    return true;
+}
+
+// Read a block of memory, serving cached ranges from the shadow memory
+void Model1Class::_readMemoryBurst(uint16_t address, uint8_t *buffer, uint16_t length)
+{
+    M1_PROFILE("Model1::readBlock");
+
+    if (_shadow)
+        _shadow->read(address, buffer, length);
+    else
+        _readMemoryBus(address, buffer, length);
+}
+
+// Write a block of memory, repeating data every dataLength bytes, keeping cached ranges in the shadow memory
+void Model1Class::_writeMemoryBurst(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length)
+{
+    M1_PROFILE("Model1::writeBlock");
+
+    if (_shadow)
+        _shadow->write(address, data, dataLength, length);
+    else
+        _writeMemoryBus(address, data, dataLength, length);
+}
+
+// Read a block of memory, holding the bus for a chunk of bytes at a time
+void Model1Class::_readMemoryBus(uint16_t address, uint8_t *buffer, uint16_t length)
+{
+    _pauseRefresh();
+
+    // Hand the DRAM part of a long enough block to page mode; the remainder below it is read normally
+    uint32_t end = (uint32_t)address + length;
+    uint16_t plainLength = (address < DRAM_START) ? (DRAM_START - address) : 0;
+    if (_pageMode && end <= 0x10000 && end >= (uint32_t)address + plainLength + PAGE_MODE_MIN_LENGTH)
+    {
+        _readMemoryPaged(address + plainLength, buffer + plainLength, length - plainLength);
+        length = plainLength;
+    }
+
+    uint16_t index = 0;
+    while (index < length)
+    {
+        uint16_t chunkEnd = (length - index > BURST_CHUNK_SIZE) ? (index + BURST_CHUNK_SIZE) : length;
+
+        uint8_t oldSREG = SREG;
+        noInterrupts();
+
+        // A refresh may have changed the bus in between, so start with the full address
+        uint8_t addressHigh = address >> 8;
+        Model1LowLevel::writeAddressBus(address);
+
+        for (; index < chunkEnd; index++)
+        {
+            // A refresh only leaves the row on the address bus
+            if (_serviceRefresh())
+                Model1LowLevel::writeAddressBusHigh(addressHigh);
+
+            // Only update the high byte of the address when it changes
+            if ((address >> 8) != addressHigh)
+            {
+                addressHigh = address >> 8;
+                Model1LowLevel::writeAddressBusHigh(addressHigh);
+            }
+            Model1LowLevel::writeAddressBusLow(address & 0xff);
+
+            // Timing of various signals
+            Model1LowLevel::writeRAS(LOW);
+            Model1LowLevel::writeRD(LOW);
+            Model1LowLevel::writeMUX(HIGH);
+            Model1LowLevel::writeCAS(LOW);
+            busDelay<M1_READ_ACCESS_NS>();
+
+            // Read data
+            buffer[index] = Model1LowLevel::readDataBus();
+
+            // Reset, leaving address as-is
+            Model1LowLevel::writeCAS(HIGH);
+            Model1LowLevel::writeRD(HIGH);
+            Model1LowLevel::writeRAS(HIGH);
+            Model1LowLevel::writeMUX(LOW);
+
+            address++;
+        }
+
+        SREG = oldSREG;
+    }
+
+    _resumeRefresh();
+}
+
+// Write a block of memory, repeating data every dataLength bytes, holding the bus for a chunk of bytes at a time
+void Model1Class::_writeMemoryBus(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length)
+{
+    _pauseRefresh();
+
+    // Hand the DRAM part of a long enough block to page mode; only plain blocks and single byte fills are reordered
+    uint32_t end = (uint32_t)address + length;
+    uint16_t plainLength = (address < DRAM_START) ? (DRAM_START - address) : 0;
+    if (_pageMode && end <= 0x10000 && end >= (uint32_t)address + plainLength + PAGE_MODE_MIN_LENGTH && (dataLength == 1 || dataLength == length))
+    {
+        const uint8_t *pagedData = (dataLength == 1) ? data : (data + plainLength);
+        _writeMemoryPaged(address + plainLength, pagedData, (dataLength == 1) ? 1 : (length - plainLength), length - plainLength);
+        if (plainLength == 0)
+        {
+            _resumeRefresh();
+            return;
+        }
+        length = plainLength;
+        if (dataLength != 1)
+            dataLength = plainLength;
+    }
+
+    // Configure bus once for the whole transfer
+    _dataBus.setAsWritable();
+
+    uint16_t dataIndex = 0;
+    uint16_t index = 0;
+    while (index < length)
+    {
+        uint16_t chunkEnd = (length - index > BURST_CHUNK_SIZE) ? (index + BURST_CHUNK_SIZE) : length;
+
+        uint8_t oldSREG = SREG;
+        noInterrupts();
+
+        // A refresh may have changed the bus in between, so start with the full address
+        uint8_t addressHigh = address >> 8;
+        Model1LowLevel::writeAddressBus(address);
+
+        for (; index < chunkEnd; index++)
+        {
+            // A refresh only leaves the row on the address bus
+            if (_serviceRefresh())
+                Model1LowLevel::writeAddressBusHigh(addressHigh);
+
+            // Only update the high byte of the address when it changes
+            if ((address >> 8) != addressHigh)
+            {
+                addressHigh = address >> 8;
+                Model1LowLevel::writeAddressBusHigh(addressHigh);
+            }
+            Model1LowLevel::writeAddressBusLow(address & 0xff);
+            Model1LowLevel::writeDataBus(data[dataIndex]);
+
+            // Timing of various signals
+            Model1LowLevel::writeRAS(LOW);
+            busDelay<M1_WRITE_ROW_SETUP_NS>();
+            Model1LowLevel::writeWR(LOW);
+            Model1LowLevel::writeMUX(HIGH);
+            Model1LowLevel::writeCAS(LOW);
+            busDelay<M1_WRITE_PULSE_NS>();
+
+            // Reset, leaving address and data as-is
+            Model1LowLevel::writeWR(HIGH);
+            Model1LowLevel::writeCAS(HIGH);
+            Model1LowLevel::writeRAS(HIGH);
+            Model1LowLevel::writeMUX(LOW);
+
+            address++;
+            if (++dataIndex >= dataLength)
+                dataIndex = 0;
+        }
+
+        SREG = oldSREG;
+    }
+
+    _dataBus.setAsReadable();
+
+    _resumeRefresh();
+}
+
+// Read a DRAM block in page mode, visiting all addresses of a row while RAS is held
+void Model1Class::_readMemoryPaged(uint16_t address, uint8_t *buffer, uint16_t length)
+{
+    uint16_t rows = (length < DRAM_ROWS) ? length : DRAM_ROWS;
+    for (uint16_t row = 0; row < rows; row++)
+    {
+        for (uint32_t offset = row; offset < length; offset += (uint32_t)DRAM_ROWS * PAGE_MODE_MAX_COLUMNS)
+        {
+            uint8_t oldSREG = SREG;
+            noInterrupts();
+
+            // Refresh between groups, never while RAS is held
+            _serviceRefresh();
+
+            // Latch the row
+            Model1LowLevel::writeAddressBus(address + offset);
+            Model1LowLevel::writeRAS(LOW);
+            Model1LowLevel::writeRD(LOW);
+            Model1LowLevel::writeMUX(HIGH);
+
+            // Strobe each column of the row
+            uint32_t column = offset;
+            for (uint8_t i = 0; i < PAGE_MODE_MAX_COLUMNS && column < length; i++)
+            {
+                Model1LowLevel::writeAddressBus(address + column);
+                Model1LowLevel::writeCAS(LOW);
+                busDelay<M1_READ_ACCESS_NS>();
+
+                buffer[column] = Model1LowLevel::readDataBus();
+
+                Model1LowLevel::writeCAS(HIGH);
+                column += DRAM_ROWS;
+            }
+
+            // Reset, leaving address as-is
+            Model1LowLevel::writeRD(HIGH);
+            Model1LowLevel::writeRAS(HIGH);
+            Model1LowLevel::writeMUX(LOW);
+
+            SREG = oldSREG;
+        }
+    }
+}
+
+// Write a DRAM block in page mode, visiting all addresses of a row while RAS is held
+// A dataLength of 1 fills the block with data[0], otherwise data must hold length bytes
+void Model1Class::_writeMemoryPaged(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length)
+{
+    _dataBus.setAsWritable();
+
+    uint16_t rows = (length < DRAM_ROWS) ? length : DRAM_ROWS;
+    for (uint16_t row = 0; row < rows; row++)
+    {
+        for (uint32_t offset = row; offset < length; offset += (uint32_t)DRAM_ROWS * PAGE_MODE_MAX_COLUMNS)
+        {
+            uint8_t oldSREG = SREG;
+            noInterrupts();
+
+            // Refresh between groups, never while RAS is held
+            _serviceRefresh();
+
+            // Latch the row
+            Model1LowLevel::writeAddressBus(address + offset);
+            Model1LowLevel::writeRAS(LOW);
+            busDelay<M1_WRITE_ROW_SETUP_NS>();
+            Model1LowLevel::writeMUX(HIGH);
+
+            // Strobe each column of the row (early write)
+            uint32_t column = offset;
+            for (uint8_t i = 0; i < PAGE_MODE_MAX_COLUMNS && column < length; i++)
+            {
+                Model1LowLevel::writeAddressBus(address + column);
+                Model1LowLevel::writeDataBus((dataLength == 1) ? data[0] : data[column]);
+                Model1LowLevel::writeWR(LOW);
+                Model1LowLevel::writeCAS(LOW);
+                busDelay<M1_WRITE_PULSE_NS>();
+
+                Model1LowLevel::writeWR(HIGH);
+                Model1LowLevel::writeCAS(HIGH);
+                column += DRAM_ROWS;
+            }
+
+            // Reset, leaving address and data as-is
+            Model1LowLevel::writeRAS(HIGH);
+            Model1LowLevel::writeMUX(LOW);
+
+            SREG = oldSREG;
+        }
+    }
+
+    _dataBus.setAsReadable();
 }
 
 // ----------------------------------------
@@ -510,6 +1502,8 @@ void Model1Class::fillMemory(uint8_t *fill_data, uint16_t length, uint16_t addre
 // Read from I/O port
 uint8_t Model1Class::readIO(uint8_t address)
 {
+    M1_PROFILE("Model1::readIO");
+
     // Verification of access
     if (!_checkMutability())
         return 0;
@@ -541,6 +1535,8 @@ uint8_t Model1Class::readIO(uint8_t address)
 // Write to I/O port
 void Model1Class::writeIO(uint8_t address, uint8_t data)
 {
+    M1_PROFILE("Model1::writeIO");
+
     // Verification of access
     if (!_checkMutability())
         return;
@@ -559,7 +1555,7 @@ void Model1Class::writeIO(uint8_t address, uint8_t data)
     Model1LowLevel::writeOUT(LOW);
     Model1LowLevel::writeMUX(HIGH);
     Model1LowLevel::writeCAS(LOW);
-    asmWait(1); // 252 ns
+    busDelay<M1_IO_WRITE_PULSE_NS>();
 
     // Reset, leving address as-is, removing data
     Model1LowLevel::writeCAS(HIGH);
@@ -697,9 +1693,9 @@ bool Model1Class::triggerInterrupt(uint8_t interrupt, uint16_t timeout)
             _dataBus.setAsWritable();
             _dataBus.writeData(interrupt);
 
-            asmWait(3);
+            busDelay<M1_INTERRUPT_VECTOR_HOLD_NS>();
             deactivateInterruptRequestSignal();
-            asmWait(3);
+            busDelay<M1_INTERRUPT_VECTOR_HOLD_NS>();
 
             _dataBus.setAsReadable();
 
@@ -710,8 +1706,7 @@ bool Model1Class::triggerInterrupt(uint8_t interrupt, uint16_t timeout)
 
     deactivateInterruptRequestSignal();
 
-    if (_logger)
-        _logger->errF(F("Model1: Interrupt trigger timeout - CPU did not respond within %d cycles"), timeout);
+    M1_LOG_ERR(_logger, "Model1: Interrupt trigger timeout - CPU did not respond within %d cycles", timeout);
     return false; // CPU did not respond within timeout
 }
 
@@ -720,8 +1715,7 @@ void Model1Class::activateInterruptRequestSignal()
 {
     if (Model1LowLevel::readINT() == LOW)
     {
-        if (_logger)
-            _logger->warnF(F("INT* signal already active."));
+        M1_LOG_WARN(_logger, "INT* signal already active.");
         return;
     }
 
@@ -733,8 +1727,7 @@ void Model1Class::deactivateInterruptRequestSignal()
 {
     if (Model1LowLevel::readINT() == HIGH)
     {
-        if (_logger)
-            _logger->warnF(F("INT* signal already deactivated."));
+        M1_LOG_WARN(_logger, "INT* signal already deactivated.");
         return;
     }
 
@@ -760,8 +1753,7 @@ void Model1Class::activateTestSignal()
 {
     if (Model1LowLevel::readTEST() == LOW)
     {
-        if (_logger)
-            _logger->warnF(F("TEST* signal already active."));
+        M1_LOG_WARN(_logger, "TEST* signal already active.");
         return;
     }
 
@@ -769,7 +1761,7 @@ void Model1Class::activateTestSignal()
     _setTestSignal(true);
 
     // Wait to avoid contention
-    asmWait(16); // Wait 4us. Only need 3 (value 12) for 5T, but this is to be safe
+    busDelay<M1_TEST_SETTLE_NS>();
 
     // Set the signals as active from external system
     _addressBus.setAsWritable();
@@ -792,17 +1784,27 @@ void Model1Class::deactivateTestSignal()
 {
     if (Model1LowLevel::readTEST() == HIGH)
     {
-        if (_logger)
-            _logger->warnF(F("TEST* signal already deactivated."));
+        M1_LOG_WARN(_logger, "TEST* signal already deactivated.");
         return;
     }
 
+    // Write back the shadow copy; the Z80 may change memory once it runs again
+    if (_shadow)
+    {
+        _shadow->flush();
+        _shadow->invalidate();
+    }
+
     // Deactivate background services
     if (_timer != -1)
     {
         deactivateMemoryRefresh();
     }
 
+    // Report refresh gaps of this session
+    if (_refreshTimes)
+        checkRefreshHealth();
+
     // Set bus as immutable, blocking write requests from this code
     _setImmutable();
 
@@ -816,7 +1818,7 @@ void Model1Class::deactivateTestSignal()
     _setTestSignal(false);
 
     // Wait to avoid contention
-    asmWait(16); // Wait 4us. Only need 3 (value 12) for 5T, but this is to be safe
+    busDelay<M1_TEST_SETTLE_NS>();
 }
 
 // ---------- Wait Signal
@@ -832,8 +1834,7 @@ void Model1Class::activateWaitSignal()
 {
     if (Model1LowLevel::readWAIT() == LOW)
     {
-        if (_logger)
-            _logger->warnF(F("WAIT* signal already active."));
+        M1_LOG_WARN(_logger, "WAIT* signal already active.");
         return;
     }
 
@@ -845,8 +1846,7 @@ void Model1Class::deactivateWaitSignal()
 {
     if (Model1LowLevel::readWAIT() == HIGH)
     {
-        if (_logger)
-            _logger->warnF(F("WAIT* signal already deactivated."));
+        M1_LOG_WARN(_logger, "WAIT* signal already deactivated.");
         return;
     }
 
@@ -865,10 +1865,7 @@ char *Model1Class::getState()
     char *buffer = (char *)malloc(LEN * sizeof(char));
     if (!buffer)
     {
-        if (_logger)
-        {
-            _logger->errF(F("Model1: Failed to allocate memory for state string"));
-        }
+        M1_LOG_ERR(_logger, "Model1: Failed to allocate memory for state string");
         free(addrStatus);
         free(dataStatus);
         return nullptr;
@@ -877,10 +1874,7 @@ char *Model1Class::getState()
     // Handle null returns from bus getState methods
     if (!addrStatus || !dataStatus)
     {
-        if (_logger)
-        {
-            _logger->errF(F("Model1: Failed to get bus state information"));
-        }
+        M1_LOG_ERR(_logger, "Model1: Failed to get bus state information");
         free(buffer);
         free(addrStatus);
         free(dataStatus);
@@ -936,7 +1930,7 @@ uint64_t Model1Class::getStateConfigData()
 // Get current state as a string
 void Model1Class::logState()
 {
-    if (_logger)
+    if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && _logger)
     {
         char *state = getState();
         _logger->infoF(F("State: %s"), state);
@@ -971,10 +1965,7 @@ char *Model1Class::getVersion()
     char *buffer = (char *)malloc(LEN * sizeof(char));
     if (!buffer)
     {
-        if (_logger)
-        {
-            _logger->errF(F("Model1: Failed to allocate memory for version string"));
-        }
+        M1_LOG_ERR(_logger, "Model1: Failed to allocate memory for version string");
         return nullptr;
     }
 
@@ -1000,20 +1991,14 @@ void Model1Class::printMemoryContents(uint16_t start, uint16_t length, PRINT_STY
 // Print memory contents with specified formatting options
 void Model1Class::printMemoryContents(Print &output, uint16_t start, uint16_t length, PRINT_STYLE style, bool relative, uint16_t bytesPerLine)
 {
-    if (bytesPerLine == 0 || bytesPerLine > 60)
+    const uint16_t MAX_BYTES_PER_LINE = 60;
+    if (bytesPerLine == 0 || bytesPerLine > MAX_BYTES_PER_LINE)
     {
-        if (_logger)
-            _logger->errF(F("Unsupported value for bytesPerLine with %d."), bytesPerLine);
+        M1_LOG_ERR(_logger, "Unsupported value for bytesPerLine with %d.", bytesPerLine);
         return;
     }
 
-    uint8_t *buffer = (uint8_t *)malloc(bytesPerLine);
-    if (!buffer)
-    {
-        if (_logger)
-            _logger->errF(F("Cannot allocate byte buffer."));
-        return;
-    }
+    uint8_t buffer[MAX_BYTES_PER_LINE];
 
     uint16_t lineLength = 6; // "0000: "
     if (style == HEXADECIMAL || style == BOTH)
@@ -1027,9 +2012,7 @@ void Model1Class::printMemoryContents(Print &output, uint16_t start, uint16_t le
     char *lineBuffer = (char *)malloc(lineLength);
     if (!lineBuffer)
     {
-        if (_logger)
-            _logger->errF(F("Cannot allocate line buffer."));
-        free(buffer);
+        M1_LOG_ERR(_logger, "Cannot allocate line buffer.");
         return;
     }
 
@@ -1039,11 +2022,8 @@ void Model1Class::printMemoryContents(Print &output, uint16_t start, uint16_t le
                                         ? bytesPerLine
                                         : (length - offset);
 
-        // Load from ROM
-        for (uint16_t i = 0; i < lineLengthActual; ++i)
-        {
-            buffer[i] = readMemory(start + offset + i);
-        }
+        // Load from memory
+        readMemoryInto(start + offset, buffer, lineLengthActual);
 
         // Build the line string
         char *p = lineBuffer;
@@ -1101,32 +2081,30 @@ void Model1Class::printMemoryContents(Print &output, uint16_t start, uint16_t le
         output.println(lineBuffer);
     }
 
-    free(buffer);
     free(lineBuffer);
 }
 
 // Dump memory region to SD card file as binary
 bool Model1Class::dumpMemoryToSD(uint16_t address, uint16_t length, const char *filename)
 {
+    M1_PROFILE("Model1::dumpToSD");
+
     if (!filename)
     {
-        if (_logger)
-            _logger->errF(F("Model1: dumpMemoryToSD() called with null filename"));
+        M1_LOG_ERR(_logger, "Model1: dumpMemoryToSD() called with null filename");
         return false;
     }
 
     if (length == 0)
     {
-        if (_logger)
-            _logger->errF(F("Model1: dumpMemoryToSD() called with zero length"));
+        M1_LOG_ERR(_logger, "Model1: dumpMemoryToSD() called with zero length");
         return false;
     }
 
     // Initialize SD card if not already done
     if (!SD.begin(M1Shield.getSDCardSelectPin()))
     {
-        if (_logger)
-            _logger->errF(F("Model1: Failed to initialize SD card"));
+        M1_LOG_ERR(_logger, "Model1: Failed to initialize SD card");
         return false;
     }
 
@@ -1134,29 +2112,26 @@ bool Model1Class::dumpMemoryToSD(uint16_t address, uint16_t length, const char *
     File memoryFile = SD.open(filename, FILE_WRITE);
     if (!memoryFile)
     {
-        if (_logger)
-            _logger->errF(F("Model1: Failed to open file %s for writing"), filename);
+        M1_LOG_ERR(_logger, "Model1: Failed to open file %s for writing", filename);
         return false;
     }
 
-    if (_logger)
-        _logger->infoF(F("Model1: Dumping memory from address 0x%04X, length %u bytes to %s"), address, length, filename);
+    M1_LOG_INFO(_logger, "Model1: Dumping memory from address 0x%04X, length %u bytes to %s", address, length, filename);
 
     // Read and write memory in chunks to manage memory usage
     const uint16_t CHUNK_SIZE = 64; // Read in 64-byte chunks
+    uint8_t chunk[CHUNK_SIZE];
     uint16_t bytesWritten = 0;
 
-    for (uint16_t offset = 0; offset < length; offset += CHUNK_SIZE)
+    for (uint32_t offset = 0; offset < length; offset += CHUNK_SIZE)
     {
         uint16_t chunkSize = (offset + CHUNK_SIZE <= length) ? CHUNK_SIZE : (length - offset);
         uint16_t currentAddress = address + offset;
 
         // Read chunk from memory
-        uint8_t *chunk = readMemory(currentAddress, chunkSize);
-        if (!chunk)
+        if (!readMemoryInto(currentAddress, chunk, chunkSize))
         {
-            if (_logger)
-                _logger->errF(F("Model1: Failed to read memory at address 0x%04X"), currentAddress);
+            M1_LOG_ERR(_logger, "Model1: Failed to read memory at address 0x%04X", currentAddress);
             memoryFile.close();
             return false;
         }
@@ -1165,27 +2140,23 @@ bool Model1Class::dumpMemoryToSD(uint16_t address, uint16_t length, const char *
         size_t written = memoryFile.write(chunk, chunkSize);
         if (written != chunkSize)
         {
-            if (_logger)
-                _logger->errF(F("Model1: Failed to write chunk to file (wrote %u of %u bytes)"), written, chunkSize);
-            free(chunk);
+            M1_LOG_ERR(_logger, "Model1: Failed to write chunk to file (wrote %u of %u bytes)", written, chunkSize);
             memoryFile.close();
             return false;
         }
 
         bytesWritten += written;
-        free(chunk); // Free the allocated buffer
 
         // Optional progress logging for large dumps
-        if (_logger && length > 1024 && (offset % 256 == 0))
+        if (length > 1024 && (offset % 256 == 0))
         {
-            _logger->infoF(F("Model1: Progress: %u / %u bytes written"), bytesWritten, length);
+            M1_LOG_INFO(_logger, "Model1: Progress: %u / %u bytes written", bytesWritten, length);
         }
     }
 
     memoryFile.close();
 
-    if (_logger)
-        _logger->infoF(F("Model1: Successfully dumped %u bytes to %s"), bytesWritten, filename);
+    M1_LOG_INFO(_logger, "Model1: Successfully dumped %u bytes to %s", bytesWritten, filename);
 
     return true;
 }
\ No newline at end of file
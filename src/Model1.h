@@ -13,6 +13,8 @@
 #include "DataBus.h"
 #include "M1Shield.h"
 
+class ShadowMemory;
+
 // Print style enumeration for memory output formatting
 enum PRINT_STYLE
 {
@@ -21,8 +23,22 @@ enum PRINT_STYLE
     BOTH         // Display both ASCII and hexadecimal formats
 };
 
+// Callback for memory search matches; return false to stop the search
+typedef bool (*MemoryMatchCallback)(uint16_t address);
+
+// Statistics of the refresh monitor
+struct RefreshStatistics
+{
+    uint32_t rounds;     // Passes over all 128 rows
+    uint32_t maxGap;     // Longest time a monitored row went without refresh (us)
+    uint8_t maxGapRow;   // Row of the longest gap
+    uint32_t violations; // Gaps longer than M1_DRAM_RETENTION_US
+};
+
 class Model1Class
 {
+    friend class ShadowMemory; // Accesses the bus directly to fill and flush its lines
+
 private:
     ILogger *_logger;       // Logger instance for debugging output
     AddressBus _addressBus; // Address bus controller
@@ -31,7 +47,15 @@ private:
     volatile bool _mutability;     // Flag indicating if bus modification is allowed
     uint8_t _nextMemoryRefreshRow; // Next memory row to refresh
     volatile bool _activeRefresh;  // Flag indicating if memory refresh is active
+    bool _refreshPaused;           // Flag indicating if the refresh timer ISR is paused for a transfer
+    bool _pageMode;                // Flag indicating if DRAM page mode is used for block transfers
     int _timer;                    // Timer selection for memory refresh
+    ShadowMemory *_shadow;         // Shadow copy serving cached ranges, if any
+
+    uint32_t *_refreshTimes;              // Last refresh time (us) of each monitored row, nullptr while the monitor is off
+    uint8_t _refreshMonitorShift;         // Every (1 << shift)-th row is monitored
+    RefreshStatistics _refreshStatistics; // Collected by the refresh monitor
+    uint32_t _refreshReportedViolations;  // Violations already logged by checkRefreshHealth()
 
     void _setMutable();              // Enable bus modification
     void _setImmutable();            // Disable bus modification
@@ -39,7 +63,22 @@ private:
     bool _isMutable();               // Check if bus modification is enabled
     bool _checkMutability();         // Validate bus modification state
 
-    void _refreshNextMemoryRow(); // Refresh next memory row in sequence
+    void _refreshNextMemoryRow();      // Refresh next memory row in sequence
+    void _pauseRefresh();              // Take refresh over from the timer ISR during a transfer
+    void _resumeRefresh();             // Hand refresh back to the timer ISR
+    bool _serviceRefresh();            // Refresh inline when the timer marks a row as due
+    void _monitorRefresh(uint8_t row); // Record the refresh of a monitored row
+    void _primeRefreshMonitor();       // Restart the gaps of all monitored rows now
+
+    bool _checkBurstAccess();                                                                            // Validate bus state once before a burst transfer
+    void _readMemoryBurst(uint16_t address, uint8_t *buffer, uint16_t length);                           // Read block through the shadow memory or the bus
+    void _writeMemoryBurst(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length); // Write (repeating) data through the shadow memory or the bus
+    void _readMemoryBus(uint16_t address, uint8_t *buffer, uint16_t length);                             // Read block while holding the bus per chunk
+    void _writeMemoryBus(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length);   // Write (repeating) data while holding the bus per chunk
+    void _readMemoryPaged(uint16_t address, uint8_t *buffer, uint16_t length);                           // Read DRAM block holding RAS per row
+    void _writeMemoryPaged(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length); // Write DRAM block holding RAS per row
+
+    bool _checksumMemory(uint16_t address, uint16_t length, uint16_t *sum, uint16_t *crc16, uint32_t *crc32); // Stream a block through the requested checksums
 
     void _initSystemControlSignals();   // Initialize system control signal pins
     void _initExternalControlSignals(); // Initialize external control signal pins
@@ -70,6 +109,18 @@ public:
     void activateMemoryRefresh();   // Enable memory refresh cycles
     void deactivateMemoryRefresh(); // Disable memory refresh cycles
 
+    // ---------- Refresh Monitor
+    bool activateRefreshMonitor(uint8_t rowStride = 8); // Track refresh gaps of every rowStride-th row (1, 2, 4, ... 128)
+    void deactivateRefreshMonitor();                    // Stop tracking and free the timestamps
+    bool hasActiveRefreshMonitor();                     // Check if the refresh monitor is active
+    RefreshStatistics getRefreshStatistics();           // Consistent copy of the statistics
+    void resetRefreshStatistics();                      // Clear the statistics
+    bool checkRefreshHealth();                          // Log new gaps over the retention time; false if any occurred
+
+    void activatePageMode();   // Enable DRAM page mode for block transfers
+    void deactivatePageMode(); // Disable DRAM page mode for block transfers
+    bool hasActivePageMode();  // Check if DRAM page mode is enabled
+
     // ---------- Address Space
     bool isROMAddress(uint16_t address);            // Check if address is in ROM space
     bool isUnusedAddress(uint16_t address);         // Check if address is unused
@@ -80,12 +131,19 @@ public:
     bool isLowerMemoryAddress(uint16_t address);    // Check if address is lower memory
     bool isHigherMemoryAddress(uint16_t address);   // Check if address is higher memory
 
+    // ---------- Shadow Memory
+    void setShadowMemory(ShadowMemory &shadow); // Serve cached ranges from a shadow copy while the bus is held
+    void removeShadowMemory();                  // Flush and detach the shadow copy
+    bool hasShadowMemory();                     // Check if a shadow copy is attached
+
     // ---------- Update
     void nextUpdate(); // Process next update cycle
 
     // ---------- Memory
     uint8_t readMemory(uint16_t address);             // Read byte from memory
     void writeMemory(uint16_t address, uint8_t data); // Write byte to memory
+    bool readMemoryInto(uint16_t address, uint8_t *buffer, uint16_t length);        // Read memory block into caller-owned buffer
+    bool writeMemoryFrom(uint16_t address, const uint8_t *buffer, uint16_t length); // Write memory block from caller-owned buffer
     // Returns a newly allocated buffer; caller must free() the result
     uint8_t *readMemory(uint16_t address, uint16_t length);                                             // Read memory block
     void writeMemory(uint16_t address, uint8_t *data, uint16_t length);                                 // Write memory block
@@ -94,6 +152,18 @@ public:
     void fillMemory(uint8_t fill_data, uint16_t address, uint16_t length);                              // Fill memory with byte value
     void fillMemory(uint8_t *fill_data, uint16_t length, uint16_t start_address, uint16_t end_address); // Fill memory with pattern
 
+    // ---------- Verify
+    uint16_t getMemoryChecksum(uint16_t address, uint16_t length);                                           // 16-bit sum of a memory block
+    uint16_t getMemoryCRC16(uint16_t address, uint16_t length);                                              // CRC-16/CCITT-FALSE of a memory block
+    uint32_t getMemoryCRC32(uint16_t address, uint16_t length);                                              // CRC-32 of a memory block
+    int32_t compareMemory(uint16_t address, const uint8_t *expected, uint16_t length, uint16_t *firstMismatch = nullptr); // Count bytes differing from a buffer, -1 on error
+    int32_t compareMemoryToSD(uint16_t address, const char *filename, uint16_t *firstMismatch = nullptr);                 // Count bytes differing from an SD card file, -1 on error
+    int32_t verifyAndWriteMemory(uint16_t address, uint16_t length, const uint8_t *expected, const uint8_t *data, bool down = false, uint8_t *actual = nullptr); // Read, check and write cell by cell, -1 on error
+
+    // ---------- Search
+    int32_t searchMemory(uint16_t address, uint16_t length, const uint8_t *pattern, const uint8_t *mask, uint8_t patternLength, MemoryMatchCallback callback); // Find (masked) byte pattern, -1 on error
+    int32_t searchMemory(uint16_t address, uint16_t length, const char *str, MemoryMatchCallback callback, bool model1Charset = false, bool hasLowerCaseMod = false); // Find string, -1 on error
+
     // ---------- IO
     uint8_t readIO(uint8_t address);             // Read from I/O port
     void writeIO(uint8_t address, uint8_t data); // Write to I/O port
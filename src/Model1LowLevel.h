@@ -15,6 +15,7 @@
  * - Signal reading (current HIGH/LOW state)
  * - Complete address and data bus control
  * - Static inline functions for maximum performance (zero call overhead)
+ * - Optional tracing of every bus transition (M1_BUS_TRACE, see BusTrace.h)
  *
  * Control Signals Available:
  * - RAS (Row Address Strobe)
@@ -58,6 +59,7 @@
 #include <Arduino.h>
 #include "port_config.h"
 #include "port_macros.h"
+#include "BusTrace.h"
 
 class Model1LowLevel
 {
@@ -173,6 +175,7 @@ public:
             pinWrite(RAS, HIGH);
         else
             pinWrite(RAS, LOW);
+        M1_TRACE(BUS_TRACE_RAS, value == HIGH ? HIGH : LOW);
     }
 
     static inline void writeCAS(uint8_t value)
@@ -181,6 +184,7 @@ public:
             pinWrite(CAS, HIGH);
         else
             pinWrite(CAS, LOW);
+        M1_TRACE(BUS_TRACE_CAS, value == HIGH ? HIGH : LOW);
     }
 
     static inline void writeMUX(uint8_t value)
@@ -189,6 +193,7 @@ public:
             pinWrite(MUX, HIGH);
         else
             pinWrite(MUX, LOW);
+        M1_TRACE(BUS_TRACE_MUX, value == HIGH ? HIGH : LOW);
     }
 
     static inline void writeRD(uint8_t value)
@@ -197,6 +202,7 @@ public:
             pinWrite(RD, HIGH);
         else
             pinWrite(RD, LOW);
+        M1_TRACE(BUS_TRACE_RD, value == HIGH ? HIGH : LOW);
     }
 
     static inline void writeWR(uint8_t value)
@@ -205,6 +211,7 @@ public:
             pinWrite(WR, HIGH);
         else
             pinWrite(WR, LOW);
+        M1_TRACE(BUS_TRACE_WR, value == HIGH ? HIGH : LOW);
     }
 
     static inline void writeIN(uint8_t value)
@@ -213,6 +220,7 @@ public:
             pinWrite(IN, HIGH);
         else
             pinWrite(IN, LOW);
+        M1_TRACE(BUS_TRACE_IN, value == HIGH ? HIGH : LOW);
     }
 
     static inline void writeOUT(uint8_t value)
@@ -221,6 +229,7 @@ public:
             pinWrite(OUT, HIGH);
         else
             pinWrite(OUT, LOW);
+        M1_TRACE(BUS_TRACE_OUT, value == HIGH ? HIGH : LOW);
     }
 
     static inline void writeINT(uint8_t value)
@@ -305,7 +314,21 @@ public:
     static inline void writeAddressBus(uint16_t address)
     {
         busWrite(ADDR_LOW, address & 0xff);
+        M1_TRACE(BUS_TRACE_ADDRESS_LOW, address & 0xff);
         busWrite(ADDR_HIGH, (address & 0xff00) >> 8);
+        M1_TRACE(BUS_TRACE_ADDRESS_HIGH, (address & 0xff00) >> 8);
+    }
+
+    static inline void writeAddressBusLow(uint8_t address)
+    {
+        busWrite(ADDR_LOW, address);
+        M1_TRACE(BUS_TRACE_ADDRESS_LOW, address);
+    }
+
+    static inline void writeAddressBusHigh(uint8_t address)
+    {
+        busWrite(ADDR_HIGH, address);
+        M1_TRACE(BUS_TRACE_ADDRESS_HIGH, address);
     }
 
     static inline uint16_t readAddressBus()
@@ -322,11 +345,18 @@ public:
     static inline void writeDataBus(uint8_t data)
     {
         busWrite(DATA, data);
+        M1_TRACE(BUS_TRACE_DATA_OUT, data);
     }
 
     static inline uint8_t readDataBus()
     {
+#if defined(M1_BUS_TRACE)
+        uint8_t data = busRead(DATA);
+        M1_TRACE(BUS_TRACE_DATA_IN, data);
+        return data;
+#else
         return busRead(DATA);
+#endif
     }
 
     static inline void configWriteDataBus(uint8_t outputMode)
@@ -0,0 +1,321 @@
+/*
+ * Profiler.cpp - Class for measuring time spent in named code zones
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "Profiler.h"
+
+// Longest zone name shown by dump()
+#define PROFILER_NAME_LENGTH 24
+
+static const char bucket0[] PROGMEM = "<1us";
+static const char bucket1[] PROGMEM = "<4us";
+static const char bucket2[] PROGMEM = "<16us";
+static const char bucket3[] PROGMEM = "<64us";
+static const char bucket4[] PROGMEM = "<256us";
+static const char bucket5[] PROGMEM = "<1ms";
+static const char bucket6[] PROGMEM = "<4ms";
+static const char bucket7[] PROGMEM = ">=4ms";
+
+static const char *const bucketNames[PROFILER_BUCKETS] PROGMEM = {
+    bucket0, bucket1, bucket2, bucket3, bucket4, bucket5, bucket6, bucket7};
+
+ProfilerClass Profiler;
+
+// Constructor
+ProfilerClass::ProfilerClass()
+{
+    _logger = nullptr;
+    _active = false;
+    _started = false;
+    _zoneCount = 0;
+    _zonesFull = false;
+    _overhead = 0;
+}
+
+// Set the logger for debugging output
+void ProfilerClass::setLogger(ILogger &logger)
+{
+    _logger = &logger;
+}
+
+// Start the cycle counter and measuring
+bool ProfilerClass::begin()
+{
+#if !defined(M1_PROFILING)
+    M1_LOG_ERR(_logger, "Profiler: Library compiled without M1_PROFILING");
+    return false;
+#else
+    end();
+
+    cycleCounterBegin();
+    _started = true;
+
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    _calibrate();
+    SREG = oldSREG;
+
+    reset();
+    _active = true;
+    return true;
+#endif
+}
+
+// Stop measuring and release the cycle counter
+void ProfilerClass::end()
+{
+    _active = false;
+
+    if (_started)
+    {
+        cycleCounterEnd();
+        _started = false;
+    }
+}
+
+// Measure how many cycles reading the counter adds to a measurement
+void ProfilerClass::_calibrate()
+{
+    uint32_t start = cycleCounterRead();
+    uint32_t stop = cycleCounterRead();
+
+    _overhead = stop - start;
+}
+
+// ----------------------------------------
+// ---------- Measuring
+// ----------------------------------------
+
+// Resume measuring
+void ProfilerClass::start()
+{
+    if (!_started)
+    {
+        M1_LOG_ERR(_logger, "Profiler: start() called before begin()");
+        return;
+    }
+    _active = true;
+}
+
+// Pause measuring; running measurements are discarded
+void ProfilerClass::stop()
+{
+    _active = false;
+}
+
+// Clear the statistics of all zones; zones stay registered
+void ProfilerClass::reset()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+
+    for (uint8_t i = 0; i < _zoneCount; i++)
+        _clearZone(i);
+
+    SREG = oldSREG;
+}
+
+// Check if measuring
+bool ProfilerClass::isActive()
+{
+    return _active;
+}
+
+// Add a measurement; also called from interrupts
+void ProfilerClass::record(ProfilerSite &site, uint32_t cycles)
+{
+#if defined(M1_PROFILING)
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+
+    if (!_active)
+    {
+        SREG = oldSREG;
+        return;
+    }
+
+    if (site.zone == PROFILER_NO_ZONE)
+        site.zone = _findZone(site.name);
+
+    if (site.zone == PROFILER_ZONE_FULL)
+    {
+        SREG = oldSREG;
+        return;
+    }
+
+    cycles = (cycles > _overhead) ? cycles - _overhead : 0;
+
+    ProfilerZone &zone = _zones[site.zone];
+    zone.count++;
+    zone.totalCycles += cycles;
+    if (cycles < zone.minCycles)
+        zone.minCycles = cycles;
+    if (cycles > zone.maxCycles)
+        zone.maxCycles = cycles;
+
+    // Bucket n holds durations below 16 * 4^n cycles
+    uint8_t bucket = 0;
+    uint32_t scaled = cycles >> 4;
+    while (scaled && bucket < PROFILER_BUCKETS - 1)
+    {
+        scaled >>= 2;
+        bucket++;
+    }
+    if (zone.buckets[bucket] != 0xFFFF)
+        zone.buckets[bucket]++;
+
+    SREG = oldSREG;
+#endif
+}
+
+// Find the zone with the same name or add a new one; expects interrupts disabled
+uint8_t ProfilerClass::_findZone(const char *name)
+{
+#if defined(M1_PROFILING)
+    for (uint8_t i = 0; i < _zoneCount; i++)
+    {
+        const char *other = _zones[i].name;
+        if (other == name)
+            return i;
+
+        // Names are in PROGMEM; the same name may be used at several sites
+        uint8_t index = 0;
+        char ch;
+        do
+        {
+            ch = pgm_read_byte(name + index);
+            if (ch != (char)pgm_read_byte(other + index))
+                break;
+            index++;
+        } while (ch != '\0');
+
+        if (ch == '\0')
+            return i;
+    }
+
+    if (_zoneCount >= PROFILER_MAX_ZONES)
+    {
+        _zonesFull = true;
+        return PROFILER_ZONE_FULL;
+    }
+
+    _zones[_zoneCount].name = name;
+    _clearZone(_zoneCount);
+    return _zoneCount++;
+#else
+    return PROFILER_ZONE_FULL;
+#endif
+}
+
+// Reset the statistics of a zone
+void ProfilerClass::_clearZone(uint8_t index)
+{
+#if defined(M1_PROFILING)
+    ProfilerZone &zone = _zones[index];
+    zone.count = 0;
+    zone.minCycles = 0xFFFFFFFF;
+    zone.maxCycles = 0;
+    zone.totalCycles = 0;
+    for (uint8_t i = 0; i < PROFILER_BUCKETS; i++)
+        zone.buckets[i] = 0;
+#endif
+}
+
+// ----------------------------------------
+// ---------- Results
+// ----------------------------------------
+
+// Number of registered zones
+uint8_t ProfilerClass::getZoneCount()
+{
+    return _zoneCount;
+}
+
+// Copy a zone with interrupts disabled, so an interrupt cannot update it halfway
+bool ProfilerClass::getZone(uint8_t index, ProfilerZone &zone)
+{
+#if defined(M1_PROFILING)
+    if (index >= _zoneCount)
+        return false;
+
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+    zone = _zones[index];
+    SREG = oldSREG;
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Upper bound of a bucket in cycles
+uint32_t ProfilerClass::getBucketLimit(uint8_t bucket)
+{
+    if (bucket >= PROFILER_BUCKETS - 1)
+        return 0xFFFFFFFF;
+    return 16UL << (2 * bucket);
+}
+
+// Label of a bucket (PROGMEM)
+const char *ProfilerClass::getBucketName(uint8_t bucket)
+{
+    if (bucket >= PROFILER_BUCKETS)
+        return nullptr;
+    return (const char *)pgm_read_ptr(&bucketNames[bucket]);
+}
+
+// Convert CPU cycles to nanoseconds
+uint32_t ProfilerClass::toNanoseconds(uint32_t cycles)
+{
+    return (uint32_t)(((uint64_t)cycles * 1000000000ULL) / F_CPU);
+}
+
+// Log all zones to the logger set with setLogger()
+void ProfilerClass::dump()
+{
+    if (_logger)
+        dump(*_logger);
+}
+
+// Log all zones: count, min/mean/max in microseconds and the histogram
+void ProfilerClass::dump(ILogger &logger)
+{
+    logger.infoF(F("Profiler: %u zone(s), times in us"), _zoneCount);
+    logger.infoF(F("Histogram: <1us <4us <16us <64us <256us <1ms <4ms >=4ms"));
+
+    ProfilerZone zone;
+    for (uint8_t i = 0; i < _zoneCount; i++)
+    {
+        if (!getZone(i, zone))
+            break;
+
+        char name[PROFILER_NAME_LENGTH + 1];
+        strncpy_P(name, zone.name, PROFILER_NAME_LENGTH);
+        name[PROFILER_NAME_LENGTH] = '\0';
+
+        if (zone.count == 0)
+        {
+            logger.infoF(F("%s: no calls"), name);
+            continue;
+        }
+
+        // Tenths of microseconds
+        uint32_t minimum = toNanoseconds(zone.minCycles) / 100;
+        uint32_t mean = toNanoseconds((uint32_t)(zone.totalCycles / zone.count)) / 100;
+        uint32_t maximum = toNanoseconds(zone.maxCycles) / 100;
+
+        logger.infoF(F("%s: n=%lu min=%lu.%lu mean=%lu.%lu max=%lu.%lu"), name,
+                     (unsigned long)zone.count,
+                     (unsigned long)(minimum / 10), (unsigned long)(minimum % 10),
+                     (unsigned long)(mean / 10), (unsigned long)(mean % 10),
+                     (unsigned long)(maximum / 10), (unsigned long)(maximum % 10));
+        logger.infoF(F("  %u %u %u %u %u %u %u %u"),
+                     zone.buckets[0], zone.buckets[1], zone.buckets[2], zone.buckets[3],
+                     zone.buckets[4], zone.buckets[5], zone.buckets[6], zone.buckets[7]);
+    }
+
+    if (_zonesFull)
+        logger.warnF(F("Profiler: More than %u zones, some were not measured"), PROFILER_MAX_ZONES);
+}
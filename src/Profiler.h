@@ -0,0 +1,147 @@
+/*
+ * Profiler.h - Class for measuring time spent in named code zones
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * Profiler measures how long code takes with the shared timer 5 cycle
+ * counter (62.5 ns resolution at 16 MHz). Code is marked with M1_PROFILE(),
+ * which measures the rest of the enclosing block:
+ *
+ *     void draw()
+ *     {
+ *         M1_PROFILE("draw");
+ *         ...
+ *     }
+ *
+ * Every name becomes a zone with count, minimum, maximum, mean and a
+ * histogram of durations. Zones can be dumped to a logger or shown live on
+ * a ProfilerScreen.
+ *
+ * M1_PROFILE() is only compiled in when the library is built with
+ * M1_PROFILING defined (e.g. build_flags = -DM1_PROFILING); otherwise it
+ * costs nothing and begin() fails.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "ILogger.h"
+#include "cycle_counter.h"
+
+// Maximum number of zones (38 bytes of RAM each when profiling is compiled in)
+#ifndef PROFILER_MAX_ZONES
+#define PROFILER_MAX_ZONES 16
+#endif
+
+// Number of histogram buckets; bucket n counts durations below 16 * 4^n cycles
+#define PROFILER_BUCKETS 8
+
+// Zone index of a site that was not registered yet
+#define PROFILER_NO_ZONE 0xFF
+
+// Zone index of a site that did not fit into the zone table
+#define PROFILER_ZONE_FULL 0xFE
+
+// Statistics of one zone
+struct ProfilerZone
+{
+    const char *name;                   // Zone name (PROGMEM)
+    uint32_t count;                     // Number of measurements
+    uint32_t minCycles;                 // Shortest duration
+    uint32_t maxCycles;                 // Longest duration
+    uint64_t totalCycles;               // Sum of all durations
+    uint16_t buckets[PROFILER_BUCKETS]; // Histogram, saturating at 0xFFFF
+};
+
+// Place in the code measured by M1_PROFILE(); resolved to a zone on first use
+struct ProfilerSite
+{
+    const char *name; // Zone name (PROGMEM)
+    uint8_t zone;     // Zone index or PROFILER_NO_ZONE
+};
+
+class ProfilerClass
+{
+private:
+    ILogger *_logger; // Logger instance for debugging output
+
+    volatile bool _active; // Set while measuring
+    bool _started;         // Cycle counter claimed by begin()
+    uint8_t _zoneCount;    // Number of registered zones
+    bool _zonesFull;       // A site did not fit into the zone table
+    uint16_t _overhead;    // Cycles a measurement adds to the measured code
+
+#if defined(M1_PROFILING)
+    ProfilerZone _zones[PROFILER_MAX_ZONES]; // Zone table
+#endif
+
+    uint8_t _findZone(const char *name); // Find or add the zone of a name
+    void _clearZone(uint8_t index);      // Reset the statistics of a zone
+    void _calibrate();                   // Measure the cost of a measurement
+
+public:
+    ProfilerClass(); // Constructor
+
+    void setLogger(ILogger &logger); // Set logger for debugging output
+
+    bool begin(); // Start the cycle counter and measuring
+    void end();   // Stop measuring and release the cycle counter
+
+    void start();    // Resume measuring
+    void stop();     // Pause measuring
+    void reset();    // Clear the statistics of all zones
+    bool isActive(); // Check if measuring
+
+    void record(ProfilerSite &site, uint32_t cycles); // Add a measurement, called by M1_PROFILE()
+
+    uint8_t getZoneCount();                           // Number of registered zones
+    bool getZone(uint8_t index, ProfilerZone &zone);  // Consistent copy of a zone
+    static uint32_t getBucketLimit(uint8_t bucket);   // Upper bound of a bucket in cycles, 0xFFFFFFFF for the last one
+    static const char *getBucketName(uint8_t bucket); // Label of a bucket, e.g. "<16us"
+    static uint32_t toNanoseconds(uint32_t cycles);   // Convert cycles to nanoseconds
+
+    void dump(ILogger &logger); // Log all zones
+    void dump();                // Log all zones to the logger set with setLogger()
+};
+
+extern ProfilerClass Profiler;
+
+// Measures from construction to the end of the enclosing block
+class ProfilerScope
+{
+private:
+    ProfilerSite &_site; // Measured site
+    uint32_t _start;     // Cycle counter at construction
+    bool _running;       // Profiler was active at construction
+
+public:
+    inline ProfilerScope(ProfilerSite &site) : _site(site), _start(0)
+    {
+        _running = Profiler.isActive();
+        if (_running)
+            _start = cycleCounterRead();
+    }
+
+    inline ~ProfilerScope()
+    {
+        if (_running)
+            Profiler.record(_site, cycleCounterRead() - _start);
+    }
+};
+
+// Hook measuring the rest of the enclosing block as zone "name"
+#if defined(M1_PROFILING)
+#define M1_PROFILE_JOIN2(a, b) a##b
+#define M1_PROFILE_JOIN(a, b) M1_PROFILE_JOIN2(a, b)
+#define M1_PROFILE(name)                                                                                                       \
+    static const char M1_PROFILE_JOIN(_profileName, __LINE__)[] PROGMEM = name;                                                \
+    static ProfilerSite M1_PROFILE_JOIN(_profileSite, __LINE__) = {M1_PROFILE_JOIN(_profileName, __LINE__), PROFILER_NO_ZONE}; \
+    ProfilerScope M1_PROFILE_JOIN(_profileScope, __LINE__)(M1_PROFILE_JOIN(_profileSite, __LINE__))
+#else
+#define M1_PROFILE(name)
+#endif
+
+#endif // PROFILER_H
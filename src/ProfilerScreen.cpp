@@ -0,0 +1,155 @@
+/*
+ * ProfilerScreen.cpp - ContentScreen showing the Profiler zones live
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "ProfilerScreen.h"
+#include "M1Shield.h"
+#include "Profiler.h"
+
+#define PROFILER_SCREEN_LINE_HEIGHT 8 // Text size 1
+#define PROFILER_SCREEN_CHAR_WIDTH 6  // Text size 1
+#define PROFILER_SCREEN_MAX_CHARS 80  // Longest table line
+
+// Constructor
+ProfilerScreen::ProfilerScreen()
+{
+    _firstZone = 0;
+    _lastUpdate = 0;
+
+    setTitleF(F("Profiler"));
+
+    const char *buttons[] = {"Up/Dn:Scroll", "Sel:Reset"};
+    setButtonItems(buttons, 2);
+}
+
+// Start with the first zone
+bool ProfilerScreen::open()
+{
+    _firstZone = 0;
+    _lastUpdate = millis();
+    return ContentScreen::open();
+}
+
+// Update the table periodically
+void ProfilerScreen::loop()
+{
+    ContentScreen::loop();
+
+    if (isActive() && millis() - _lastUpdate >= PROFILER_SCREEN_UPDATE_MS)
+    {
+        _lastUpdate = millis();
+        clearContentArea();
+        _drawContent();
+        M1Shield.display();
+    }
+}
+
+// Number of zone rows fitting the content area below the column header
+uint8_t ProfilerScreen::_getVisibleZones()
+{
+    uint16_t rows = _getContentHeight() / PROFILER_SCREEN_LINE_HEIGHT;
+    return rows > 1 ? rows - 1 : 0;
+}
+
+// Draw the zone table; narrow displays only show the mean time
+void ProfilerScreen::_drawContent()
+{
+    uint8_t zoneCount = Profiler.getZoneCount();
+    if (zoneCount == 0)
+    {
+        if (Profiler.isActive())
+            drawTextF(0, 0, F("No zones measured yet"), 0xFFFF, 1);
+        else
+            drawTextF(0, 0, F("Profiler not running"), 0xFFFF, 1);
+        return;
+    }
+
+    uint16_t columns = _getContentWidth() / PROFILER_SCREEN_CHAR_WIDTH;
+    if (columns > PROFILER_SCREEN_MAX_CHARS)
+        columns = PROFILER_SCREEN_MAX_CHARS;
+    bool wide = columns >= 40;
+    int nameWidth = (int)columns - (wide ? 27 : 10);
+    if (nameWidth < 4)
+        nameWidth = 4;
+
+    char line[PROFILER_SCREEN_MAX_CHARS + 16]; // Room for numbers wider than their column
+    if (wide)
+        snprintf(line, sizeof(line), "%-*s   Calls  Mean us   Max us", nameWidth, "Zone");
+    else
+        snprintf(line, sizeof(line), "%-*s   Mean us", nameWidth, "Zone");
+    drawText(0, 0, line, 0xFFE0, 1);
+
+    uint8_t visible = _getVisibleZones();
+    ProfilerZone zone;
+    for (uint8_t row = 0; row < visible; row++)
+    {
+        if (!Profiler.getZone(_firstZone + row, zone))
+            break;
+
+        // Zone name padded to the column width
+        char name[PROFILER_SCREEN_MAX_CHARS - 26];
+        uint8_t length = 0;
+        while (length < nameWidth && (name[length] = pgm_read_byte(zone.name + length)) != '\0')
+            length++;
+        while (length < nameWidth)
+            name[length++] = ' ';
+        name[length] = '\0';
+
+        // Tenths of microseconds
+        uint32_t mean = zone.count ? Profiler.toNanoseconds((uint32_t)(zone.totalCycles / zone.count)) / 100 : 0;
+        uint32_t maximum = Profiler.toNanoseconds(zone.maxCycles) / 100;
+
+        if (wide)
+            snprintf(line, sizeof(line), "%s %7lu %6lu.%lu %6lu.%lu", name,
+                     (unsigned long)zone.count,
+                     (unsigned long)(mean / 10), (unsigned long)(mean % 10),
+                     (unsigned long)(maximum / 10), (unsigned long)(maximum % 10));
+        else
+            snprintf(line, sizeof(line), "%s %7lu.%lu", name,
+                     (unsigned long)(mean / 10), (unsigned long)(mean % 10));
+
+        drawText(0, (row + 1) * PROFILER_SCREEN_LINE_HEIGHT, line, 0xFFFF, 1);
+    }
+}
+
+// Scroll with up/down, reset the statistics with select
+Screen *ProfilerScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY)
+{
+    (void)offsetX; // Parameter not used
+    (void)offsetY; // Parameter not used
+
+    if (!isActive())
+        return nullptr;
+
+    if (action & UP_ANY)
+    {
+        if (_firstZone > 0)
+        {
+            _firstZone--;
+            refresh();
+        }
+        return nullptr;
+    }
+
+    if (action & DOWN_ANY)
+    {
+        if (_firstZone + _getVisibleZones() < Profiler.getZoneCount())
+        {
+            _firstZone++;
+            refresh();
+        }
+        return nullptr;
+    }
+
+    if (action & (BUTTON_SELECT | BUTTON_JOYSTICK))
+    {
+        Profiler.reset();
+        refresh();
+        notifyF(F("Profiler reset"));
+        return nullptr;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,38 @@
+/*
+ * ProfilerScreen.h - ContentScreen showing the Profiler zones live
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef PROFILERSCREEN_H
+#define PROFILERSCREEN_H
+
+#include <Arduino.h>
+#include "ContentScreen.h"
+
+// Interval between updates of the zone table
+#ifndef PROFILER_SCREEN_UPDATE_MS
+#define PROFILER_SCREEN_UPDATE_MS 500
+#endif
+
+// Table of all Profiler zones: calls, mean and maximum time
+class ProfilerScreen : public ContentScreen
+{
+private:
+    uint8_t _firstZone;        // First zone shown (scroll position)
+    unsigned long _lastUpdate; // Time of the last table update
+
+    uint8_t _getVisibleZones(); // Number of zone rows fitting the content area
+
+public:
+    ProfilerScreen(); // Constructor, sets title and button items
+
+    bool open() override; // Start with the first zone
+    void loop() override; // Update the table periodically
+    Screen *actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY) override;
+
+protected:
+    void _drawContent() override; // Draw the zone table
+};
+
+#endif /* PROFILERSCREEN_H */
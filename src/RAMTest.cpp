@@ -0,0 +1,604 @@
+/*
+ * RAMTest.cpp - Class for testing the TRS-80 Model 1 RAM
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "RAMTest.h"
+#include "Model1.h"
+
+// Bytes verified/written per bus transfer
+#define RAM_TEST_CHUNK_SIZE 32
+
+// Bytes processed per call to step(), keeping loop() responsive
+#define RAM_TEST_STEP_SIZE 256
+
+// Patterns a pass can verify or write
+enum RAMTestPattern
+{
+  PATTERN_NONE,        // Nothing to verify/write
+  PATTERN_ZERO,        // 0x00 everywhere
+  PATTERN_ONE,         // 0xFF everywhere
+  PATTERN_CHECKER,     // 0x00/0xFF alternating by DRAM row and column
+  PATTERN_CHECKER_INV, // Inverse of PATTERN_CHECKER
+  PATTERN_ADDRESS,     // Low byte XOR high byte of the address
+  PATTERN_ADDRESS_INV, // Inverse of PATTERN_ADDRESS
+  PATTERN_WALK_0,      // Single bit set, PATTERN_WALK_0 + bit
+  PATTERN_WALK_END = PATTERN_WALK_0 + 8
+};
+
+// 4116 positions of data bits D0-D7 in the keyboard unit (lower 16K)
+const char CHIP_Z17[] PROGMEM = "Z17";
+const char CHIP_Z16[] PROGMEM = "Z16";
+const char CHIP_Z18[] PROGMEM = "Z18";
+const char CHIP_Z15[] PROGMEM = "Z15";
+const char CHIP_Z19[] PROGMEM = "Z19";
+const char CHIP_Z14[] PROGMEM = "Z14";
+const char CHIP_Z20[] PROGMEM = "Z20";
+const char CHIP_Z13[] PROGMEM = "Z13";
+
+const char *const lowerChips[8] PROGMEM = {
+    CHIP_Z17, CHIP_Z16, CHIP_Z18, CHIP_Z15, CHIP_Z19, CHIP_Z14, CHIP_Z20, CHIP_Z13};
+
+// Constructor - initialize RAM test
+RAMTest::RAMTest()
+{
+  _logger = nullptr;
+
+  _start = 0;
+  _length = 0;
+  _tests = 0;
+  _currentTest = 0;
+  _pass = 0;
+  _offset = 0;
+  _passesDone = 0;
+  _passesTotal = 0;
+  _aborted = false;
+
+  _errors = 0;
+  memset(_bitErrors, 0, sizeof(_bitErrors));
+  memset(_failedBits, 0, sizeof(_failedBits));
+  _failedBitsOther = 0;
+  _firstErrorAddress = 0;
+  _firstErrorExpected = 0;
+  _firstErrorActual = 0;
+}
+
+// Set logger for debugging output
+void RAMTest::setLogger(ILogger &logger)
+{
+  _logger = &logger;
+}
+
+// ----------------------------------------
+// ---------- Test Definitions
+// ----------------------------------------
+
+// Describe a pass of a test; a read pattern is verified before the write pattern is written
+// Returns false when the test has no such pass
+bool RAMTest::_getPass(uint8_t test, uint8_t pass, uint8_t &readPattern, uint8_t &writePattern, bool &down)
+{
+  down = false;
+
+  switch (test)
+  {
+  case RAM_TEST_MARCH_C_MINUS:
+  {
+    // up(w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); up(r0)
+    static const uint8_t march[6][2] = {
+        {PATTERN_NONE, PATTERN_ZERO},
+        {PATTERN_ZERO, PATTERN_ONE},
+        {PATTERN_ONE, PATTERN_ZERO},
+        {PATTERN_ZERO, PATTERN_ONE},
+        {PATTERN_ONE, PATTERN_ZERO},
+        {PATTERN_ZERO, PATTERN_NONE}};
+    if (pass >= 6)
+      return false;
+    readPattern = march[pass][0];
+    writePattern = march[pass][1];
+    down = (pass == 3 || pass == 4);
+    return true;
+  }
+
+  case RAM_TEST_CHECKERBOARD:
+  case RAM_TEST_ADDRESS:
+  {
+    // w(p); r(p),w(~p); r(~p)
+    uint8_t pattern = (test == RAM_TEST_CHECKERBOARD) ? PATTERN_CHECKER : PATTERN_ADDRESS;
+    if (pass >= 3)
+      return false;
+    readPattern = (pass == 0) ? PATTERN_NONE : (pattern + pass - 1);
+    writePattern = (pass == 2) ? PATTERN_NONE : (pattern + pass);
+    return true;
+  }
+
+  case RAM_TEST_WALKING_ONES:
+    // w(bit0); r(bit0),w(bit1); ... r(bit7)
+    if (pass >= 9)
+      return false;
+    readPattern = (pass == 0) ? PATTERN_NONE : (PATTERN_WALK_0 + pass - 1);
+    writePattern = (pass == 8) ? PATTERN_NONE : (PATTERN_WALK_0 + pass);
+    return true;
+  }
+
+  return false;
+}
+
+// Value a pattern expects at an address
+uint8_t RAMTest::_getPatternValue(uint8_t pattern, uint16_t address)
+{
+  switch (pattern)
+  {
+  case PATTERN_ZERO:
+    return 0x00;
+
+  case PATTERN_ONE:
+    return 0xFF;
+
+  case PATTERN_CHECKER:
+  case PATTERN_CHECKER_INV:
+  {
+    // Row is A0-A6, column A7-A13; neighbouring cells of each chip get opposite values
+    uint8_t row = address & 0x7F;
+    uint8_t column = (address >> 7) & 0x7F;
+    uint8_t value = ((row ^ column) & 1) ? 0xFF : 0x00;
+    return (pattern == PATTERN_CHECKER) ? value : ~value;
+  }
+
+  case PATTERN_ADDRESS:
+    return (address & 0xFF) ^ (address >> 8);
+
+  case PATTERN_ADDRESS_INV:
+    return ~((address & 0xFF) ^ (address >> 8));
+
+  default:
+    if (pattern >= PATTERN_WALK_0 && pattern < PATTERN_WALK_END)
+      return 1 << (pattern - PATTERN_WALK_0);
+    return 0x00;
+  }
+}
+
+// Number of passes of a test
+uint8_t RAMTest::_countPasses(uint8_t test)
+{
+  uint8_t readPattern, writePattern;
+  bool down;
+  uint8_t passes = 0;
+  while (_getPass(test, passes, readPattern, writePattern, down))
+    passes++;
+  return passes;
+}
+
+// Get the name of a single test
+const __FlashStringHelper *RAMTest::getTestName(uint8_t test)
+{
+  switch (test)
+  {
+  case RAM_TEST_MARCH_C_MINUS:
+    return F("March C-");
+  case RAM_TEST_CHECKERBOARD:
+    return F("Checkerboard");
+  case RAM_TEST_WALKING_ONES:
+    return F("Walking 1s");
+  case RAM_TEST_ADDRESS:
+    return F("Address-in-address");
+  }
+  return F("None");
+}
+
+// ----------------------------------------
+// ---------- Execution
+// ----------------------------------------
+
+// Start testing a range; the bus has to be active (Model1.activateTestSignal())
+bool RAMTest::begin(uint16_t start, uint16_t length, uint8_t tests)
+{
+  if (length == 0)
+  {
+    M1_LOG_ERR(_logger, "RAMTest: begin() called with length 0");
+    return false;
+  }
+  if ((uint32_t)start + length > 0x10000UL)
+  {
+    M1_LOG_ERR(_logger, "RAMTest: Range 0x%04X + %u exceeds the address space", start, length);
+    return false;
+  }
+  if ((tests & RAM_TEST_ALL) == 0)
+  {
+    M1_LOG_ERR(_logger, "RAMTest: begin() called without any test selected");
+    return false;
+  }
+  if (Model1.hasShadowMemory())
+  {
+    M1_LOG_ERR(_logger, "RAMTest: Remove the shadow memory first, it would be tested instead of the RAM");
+    return false;
+  }
+
+  _start = start;
+  _length = length;
+  _tests = tests & RAM_TEST_ALL;
+  _aborted = false;
+
+  _errors = 0;
+  memset(_bitErrors, 0, sizeof(_bitErrors));
+  memset(_failedBits, 0, sizeof(_failedBits));
+  _failedBitsOther = 0;
+
+  _passesDone = 0;
+  _passesTotal = 0;
+  for (uint8_t test = RAM_TEST_MARCH_C_MINUS; test <= RAM_TEST_ADDRESS; test <<= 1)
+  {
+    if (_tests & test)
+      _passesTotal += _countPasses(test);
+  }
+
+  M1_LOG_INFO(_logger, "RAMTest: Testing 0x%04X-0x%04X", start, (uint16_t)(start + length - 1));
+
+  _currentTest = 0;
+  return _nextTest();
+}
+
+// Advance to the next selected test; returns false when all are done
+bool RAMTest::_nextTest()
+{
+  uint8_t test = (_currentTest == 0) ? RAM_TEST_MARCH_C_MINUS : (_currentTest << 1);
+  while (test <= RAM_TEST_ADDRESS && !(_tests & test))
+    test <<= 1;
+
+  _pass = 0;
+  _offset = 0;
+
+  if (test > RAM_TEST_ADDRESS)
+  {
+    _currentTest = 0;
+    if (_errors == 0)
+      M1_LOG_INFO(_logger, "RAMTest: Passed");
+    else
+      M1_LOG_WARN(_logger, "RAMTest: Failed with %lu errors", _errors);
+    return false;
+  }
+
+  _currentTest = test;
+  if (M1_LOG_ENABLED(M1_LOG_LEVEL_INFO) && _logger)
+  {
+    char name[24];
+    strncpy_P(name, (const char *)getTestName(test), sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    _logger->infoF(F("RAMTest: Running %s"), name);
+  }
+  return true;
+}
+
+// Run the next slice of the test; returns false when done (or aborted)
+bool RAMTest::step()
+{
+  if (_currentTest == 0)
+    return false;
+
+  uint8_t readPattern, writePattern;
+  bool down;
+  _getPass(_currentTest, _pass, readPattern, writePattern, down);
+
+  uint16_t budget = RAM_TEST_STEP_SIZE;
+  while (budget > 0 && _offset < _length)
+  {
+    uint16_t chunkSize = _length - _offset;
+    if (chunkSize > RAM_TEST_CHUNK_SIZE)
+      chunkSize = RAM_TEST_CHUNK_SIZE;
+    if (chunkSize > budget)
+      chunkSize = budget;
+
+    // Descending passes walk the range from its end
+    uint16_t chunkOffset = down ? (_length - _offset - chunkSize) : _offset;
+    _processChunk(chunkOffset, chunkSize, readPattern, writePattern, down);
+    if (_aborted)
+    {
+      _currentTest = 0;
+      return false;
+    }
+
+    _offset += chunkSize;
+    budget -= chunkSize;
+  }
+
+  if (_offset >= _length)
+  {
+    _passesDone++;
+    _pass++;
+    _offset = 0;
+    if (!_getPass(_currentTest, _pass, readPattern, writePattern, down))
+      return _nextTest();
+  }
+
+  return true;
+}
+
+// Apply a pass to part of the range
+// A pass that verifies and writes does both on each cell before moving to the next, in the pass's direction,
+// so a write that disturbs a cell not yet visited is caught; passes that only verify or only write use one burst
+void RAMTest::_processChunk(uint16_t offset, uint16_t length, uint8_t readPattern, uint8_t writePattern, bool down)
+{
+  uint8_t buffer[RAM_TEST_CHUNK_SIZE];
+  uint16_t address = _start + offset;
+
+  if (Model1.hasShadowMemory())
+  {
+    M1_LOG_ERR(_logger, "RAMTest: Shadow memory attached, test aborted");
+    _aborted = true;
+    return;
+  }
+
+  if (readPattern != PATTERN_NONE && writePattern != PATTERN_NONE)
+  {
+    uint8_t expected[RAM_TEST_CHUNK_SIZE];
+    uint8_t actual[RAM_TEST_CHUNK_SIZE];
+    for (uint16_t i = 0; i < length; i++)
+    {
+      expected[i] = _getPatternValue(readPattern, address + i);
+      buffer[i] = _getPatternValue(writePattern, address + i);
+    }
+
+    int32_t mismatches = Model1.verifyAndWriteMemory(address, length, expected, buffer, down, actual);
+    if (mismatches < 0)
+    {
+      M1_LOG_ERR(_logger, "RAMTest: Bus not accessible, test aborted");
+      _aborted = true;
+      return;
+    }
+
+    // Record in the order the cells were visited
+    for (uint16_t i = 0; mismatches > 0 && i < length; i++)
+    {
+      uint16_t index = down ? (length - 1 - i) : i;
+      if (actual[index] != expected[index])
+      {
+        _recordError(address + index, expected[index], actual[index]);
+        mismatches--;
+      }
+    }
+    return;
+  }
+
+  if (readPattern != PATTERN_NONE)
+  {
+    if (!Model1.readMemoryInto(address, buffer, length))
+    {
+      M1_LOG_ERR(_logger, "RAMTest: Bus not accessible, test aborted");
+      _aborted = true;
+      return;
+    }
+    for (uint16_t i = 0; i < length; i++)
+    {
+      uint8_t expected = _getPatternValue(readPattern, address + i);
+      if (buffer[i] != expected)
+        _recordError(address + i, expected, buffer[i]);
+    }
+  }
+
+  if (writePattern != PATTERN_NONE)
+  {
+    for (uint16_t i = 0; i < length; i++)
+      buffer[i] = _getPatternValue(writePattern, address + i);
+    if (!Model1.writeMemoryFrom(address, buffer, length))
+    {
+      M1_LOG_ERR(_logger, "RAMTest: Bus not accessible, test aborted");
+      _aborted = true;
+    }
+  }
+}
+
+// Record a failing read
+void RAMTest::_recordError(uint16_t address, uint8_t expected, uint8_t actual)
+{
+  if (_errors == 0)
+  {
+    _firstErrorAddress = address;
+    _firstErrorExpected = expected;
+    _firstErrorActual = actual;
+  }
+  _errors++;
+
+  uint8_t bits = expected ^ actual;
+  for (uint8_t bit = 0; bit < 8; bit++)
+  {
+    if (bits & (1 << bit))
+      _bitErrors[bit]++;
+  }
+
+  RAMBank bank = getBank(address);
+  if (bank == RAM_BANK_NONE)
+    _failedBitsOther |= bits;
+  else
+    _failedBits[bank] |= bits;
+}
+
+// Run all selected tests to completion
+bool RAMTest::run()
+{
+  while (step())
+  {
+  }
+  return hasPassed();
+}
+
+// Stop the running test
+void RAMTest::abort()
+{
+  if (_currentTest != 0)
+    M1_LOG_WARN(_logger, "RAMTest: Aborted");
+
+  _currentTest = 0;
+  _aborted = true;
+}
+
+// ----------------------------------------
+// ---------- Status
+// ----------------------------------------
+
+// Check if a test is in progress
+bool RAMTest::isRunning()
+{
+  return _currentTest != 0;
+}
+
+// Get progress over all selected tests (0-100)
+uint8_t RAMTest::getProgress()
+{
+  if (_passesTotal == 0)
+    return 0;
+
+  uint32_t total = (uint32_t)_passesTotal * _length;
+  uint32_t done = (uint32_t)_passesDone * _length + _offset;
+  return (done * 100) / total;
+}
+
+// Get the name of the test currently running
+const __FlashStringHelper *RAMTest::getCurrentTestName()
+{
+  return getTestName(_currentTest);
+}
+
+// Check if all selected tests finished without errors
+bool RAMTest::hasPassed()
+{
+  return !_aborted && _currentTest == 0 && _passesTotal > 0 && _passesDone == _passesTotal && _errors == 0;
+}
+
+// Get the number of failing reads
+uint32_t RAMTest::getErrorCount()
+{
+  return _errors;
+}
+
+// Get the number of failing reads of a data bit
+uint32_t RAMTest::getBitErrorCount(uint8_t bit)
+{
+  if (bit > 7)
+    return 0;
+  return _bitErrors[bit];
+}
+
+// Get the failing data bits of a bank; RAM_BANK_NONE covers everything outside the DRAM banks
+uint8_t RAMTest::getFailedBits(RAMBank bank)
+{
+  if (bank == RAM_BANK_NONE)
+    return _failedBitsOther;
+  if (bank >= RAM_BANK_COUNT)
+    return 0;
+  return _failedBits[bank];
+}
+
+// Get the details of the first failing read
+bool RAMTest::getFirstError(uint16_t &address, uint8_t &expected, uint8_t &actual)
+{
+  if (_errors == 0)
+    return false;
+
+  address = _firstErrorAddress;
+  expected = _firstErrorExpected;
+  actual = _firstErrorActual;
+  return true;
+}
+
+// ----------------------------------------
+// ---------- Chip Mapping
+// ----------------------------------------
+
+// Get the bank an address belongs to
+RAMBank RAMTest::getBank(uint16_t address)
+{
+  if (address >= 0xC000)
+    return RAM_BANK_EXPANSION_2;
+  if (address >= 0x8000)
+    return RAM_BANK_EXPANSION_1;
+  if (address >= 0x4000)
+    return RAM_BANK_LOWER_16K;
+  return RAM_BANK_NONE;
+}
+
+// Get the chip position holding a data bit of a bank
+char *RAMTest::getChipLabel(RAMBank bank, uint8_t bit, char *buffer)
+{
+  if (!buffer)
+    return nullptr;
+
+  bit &= 0x07;
+  switch (bank)
+  {
+  case RAM_BANK_LOWER_16K:
+    strcpy_P(buffer, (const char *)pgm_read_ptr(&lowerChips[bit]));
+    break;
+
+  case RAM_BANK_EXPANSION_1:
+  case RAM_BANK_EXPANSION_2:
+    // Expansion interface boards differ; name the bank and bit instead
+    snprintf_P(buffer, 16, PSTR("EI bank %u D%u"), (bank == RAM_BANK_EXPANSION_1) ? 1 : 2, bit);
+    break;
+
+  default:
+    snprintf_P(buffer, 16, PSTR("D%u"), bit);
+    break;
+  }
+
+  return buffer;
+}
+
+// Print a summary including the failing chips
+void RAMTest::printResults(Print &output)
+{
+  output.print(F("RAM test 0x"));
+  output.print(_start, HEX);
+  output.print(F("-0x"));
+  output.print((uint16_t)(_start + _length - 1), HEX);
+  output.print(F(": "));
+
+  if (_aborted)
+  {
+    output.println(F("ABORTED"));
+  }
+  else if (_currentTest != 0)
+  {
+    output.print(F("RUNNING "));
+    output.print(getProgress());
+    output.println('%');
+  }
+  else if (_errors == 0)
+  {
+    output.println(F("PASS"));
+  }
+  else
+  {
+    output.print(F("FAIL, "));
+    output.print(_errors);
+    output.println(F(" errors"));
+  }
+
+  if (_errors == 0)
+    return;
+
+  output.print(F("First error at 0x"));
+  output.print(_firstErrorAddress, HEX);
+  output.print(F(": expected 0x"));
+  output.print(_firstErrorExpected, HEX);
+  output.print(F(", read 0x"));
+  output.println(_firstErrorActual, HEX);
+
+  char label[16];
+  for (int8_t bank = RAM_BANK_NONE; bank < RAM_BANK_COUNT; bank++)
+  {
+    uint8_t bits = getFailedBits((RAMBank)bank);
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      if (!(bits & (1 << bit)))
+        continue;
+
+      output.print(F("Bad: "));
+      output.print(getChipLabel((RAMBank)bank, bit, label));
+      output.print(F(" (D"));
+      output.print(bit);
+      output.print(F(", "));
+      output.print(_bitErrors[bit]);
+      output.println(F(" errors in total)"));
+    }
+  }
+}
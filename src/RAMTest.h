@@ -0,0 +1,92 @@
+/*
+ * RAMTest.h - Class for testing the TRS-80 Model 1 RAM
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef RAMTEST_H
+#define RAMTEST_H
+
+#include <Arduino.h>
+#include "ILogger.h"
+#include "Model1.h"
+
+// RAM test selection, combine with | to run several tests in sequence
+enum RAMTestType
+{
+  RAM_TEST_MARCH_C_MINUS = 0x01, // March C- (stuck-at, transition and coupling faults)
+  RAM_TEST_CHECKERBOARD = 0x02,  // Physical checkerboard and its inverse (leakage between neighbouring cells)
+  RAM_TEST_WALKING_ONES = 0x04,  // Single bit set per pass (shorted or stuck data lines)
+  RAM_TEST_ADDRESS = 0x08,       // Address-in-address and its inverse (address line faults)
+  RAM_TEST_ALL = 0x0F            // All of the above
+};
+
+// RAM banks with known chip positions
+enum RAMBank
+{
+  RAM_BANK_NONE = -1,   // Not a DRAM bank (ROM, keyboard, video RAM)
+  RAM_BANK_LOWER_16K,   // 0x4000-0x7FFF, keyboard unit
+  RAM_BANK_EXPANSION_1, // 0x8000-0xBFFF, expansion interface
+  RAM_BANK_EXPANSION_2, // 0xC000-0xFFFF, expansion interface
+  RAM_BANK_COUNT
+};
+
+class RAMTest
+{
+private:
+  ILogger *_logger; // Logger instance for debugging output
+
+  uint16_t _start;  // First address under test
+  uint16_t _length; // Number of bytes under test
+  uint8_t _tests;   // Selected tests (RAMTestType flags)
+
+  uint8_t _currentTest; // Test flag currently running, 0 when idle
+  uint8_t _pass;        // Pass of the current test
+  uint16_t _offset;     // Bytes of the current pass already processed
+  uint8_t _passesDone;  // Passes finished over all selected tests
+  uint8_t _passesTotal; // Passes of all selected tests
+  bool _aborted;        // Set when the bus could not be accessed
+
+  uint32_t _errors;                    // Number of failing reads
+  uint32_t _bitErrors[8];              // Failing reads per data bit
+  uint8_t _failedBits[RAM_BANK_COUNT]; // Failing data bits per bank
+  uint8_t _failedBitsOther;            // Failing data bits outside the known banks
+  uint16_t _firstErrorAddress;         // Address of the first failing read
+  uint8_t _firstErrorExpected;         // Expected value of the first failing read
+  uint8_t _firstErrorActual;           // Actual value of the first failing read
+
+  bool _getPass(uint8_t test, uint8_t pass, uint8_t &readPattern, uint8_t &writePattern, bool &down); // Describe a pass of a test
+  uint8_t _getPatternValue(uint8_t pattern, uint16_t address);                                         // Value a pattern expects at an address
+  uint8_t _countPasses(uint8_t test);                                                                  // Number of passes of a test
+  bool _nextTest();                                                                                    // Advance to the next selected test
+  void _processChunk(uint16_t offset, uint16_t length, uint8_t readPattern, uint8_t writePattern, bool down); // Apply a pass to part of the range
+  void _recordError(uint16_t address, uint8_t expected, uint8_t actual);                               // Record a failing read
+
+public:
+  RAMTest(); // Constructor
+
+  void setLogger(ILogger &logger); // Set logger for debugging output
+
+  bool begin(uint16_t start, uint16_t length, uint8_t tests = RAM_TEST_ALL); // Start testing a range (bus must be active)
+  bool step();                                                               // Run the next slice of the test, returns false when done
+  bool run();                                                                // Run all selected tests to completion, returns true if no errors
+  void abort();                                                              // Stop the running test
+
+  bool isRunning();                                            // Check if a test is in progress
+  uint8_t getProgress();                                       // Progress over all selected tests (0-100)
+  const __FlashStringHelper *getCurrentTestName();             // Name of the test currently running
+  static const __FlashStringHelper *getTestName(uint8_t test); // Name of a single test
+
+  bool hasPassed();                                                          // True if finished without errors
+  uint32_t getErrorCount();                                                  // Number of failing reads
+  uint32_t getBitErrorCount(uint8_t bit);                                    // Number of failing reads per data bit
+  uint8_t getFailedBits(RAMBank bank);                                       // Failing data bits of a bank (bit mask)
+  bool getFirstError(uint16_t &address, uint8_t &expected, uint8_t &actual); // Details of the first failing read
+
+  static RAMBank getBank(uint16_t address);                                  // Bank an address belongs to
+  static char *getChipLabel(RAMBank bank, uint8_t bit, char *buffer);        // Chip position of a data bit in a bank (buffer >= 16 chars)
+
+  void printResults(Print &output); // Print a summary including the failing chips
+};
+
+#endif // RAMTEST_H
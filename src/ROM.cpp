@@ -7,6 +7,7 @@
 #include "ROM.h"
 #include "Model1.h"
 #include "utils.h"
+#include "Profiler.h"
 
 #define ROM_START 0x00
 #define ROM_1K_LENGTH 1024
@@ -115,16 +116,7 @@ uint32_t ROM::getChecksum(uint8_t rom)
   uint16_t addr = getROMStartAddress(rom);
   uint16_t size = getROMLength(rom);
 
-  uint32_t checksum = 0;
-  for (uint16_t i = 0; i < size; i++)
-  {
-    uint8_t value = Model1.readMemory(addr + i);
-    checksum += value;
-  }
-
-  checksum &= 0xFFFF;
-
-  return checksum;
+  return Model1.getMemoryChecksum(addr, size);
 }
 
 // Identify ROM contents and return description string
@@ -158,10 +150,11 @@ const __FlashStringHelper *ROM::identifyROM()
 // Dump single ROM contents as binary to SD card file
 bool ROM::dumpROMToSD(uint8_t rom, const char *filename)
 {
+  M1_PROFILE("ROM::dumpToSD");
+
   if (!filename)
   {
-    if (_logger)
-      _logger->errF(F("ROM: dumpROMToSD() called with null filename"));
+    M1_LOG_ERR(_logger, "ROM: dumpROMToSD() called with null filename");
     return false;
   }
 
@@ -171,14 +164,13 @@ bool ROM::dumpROMToSD(uint8_t rom, const char *filename)
   uint16_t addr = getROMStartAddress(rom);
   uint16_t size = getROMLength(rom);
 
-  if (_logger)
-    _logger->infoF(F("ROM: Dumping ROM %d to %s (address: 0x%04X, size: %d bytes)"), rom, filename, addr, size);
+  M1_LOG_INFO(_logger, "ROM: Dumping ROM %d to %s (address: 0x%04X, size: %d bytes)", rom, filename, addr, size);
 
   // Use Model1's memory dump method for efficient and consistent SD card handling
   bool success = Model1.dumpMemoryToSD(addr, size, filename);
 
-  if (success && _logger)
-    _logger->infoF(F("ROM: Successfully dumped ROM %d to %s"), rom, filename);
+  if (success)
+    M1_LOG_INFO(_logger, "ROM: Successfully dumped ROM %d to %s", rom, filename);
 
   return success;
 }
@@ -188,8 +180,7 @@ bool ROM::dumpAllROMsToSD(const char *filename)
 {
   if (!filename)
   {
-    if (_logger)
-      _logger->errF(F("ROM: dumpAllROMsToSD() called with null filename"));
+    M1_LOG_ERR(_logger, "ROM: dumpAllROMsToSD() called with null filename");
     return false;
   }
 
@@ -203,14 +194,13 @@ bool ROM::dumpAllROMsToSD(const char *filename)
     totalLength += getROMLength(rom);
   }
 
-  if (_logger)
-    _logger->infoF(F("ROM: Dumping all ROMs to %s (address: 0x%04X, total length: %d bytes)"), filename, startAddr, totalLength);
+  M1_LOG_INFO(_logger, "ROM: Dumping all ROMs to %s (address: 0x%04X, total length: %d bytes)", filename, startAddr, totalLength);
 
   // Use Model1's efficient memory dump method for the entire ROM region
   bool success = Model1.dumpMemoryToSD(startAddr, totalLength, filename);
 
-  if (success && _logger)
-    _logger->infoF(F("ROM: Successfully dumped all ROMs to %s"), filename);
+  if (success)
+    M1_LOG_INFO(_logger, "ROM: Successfully dumped all ROMs to %s", filename);
 
   return success;
 }
@@ -234,8 +224,7 @@ bool ROM::_checkROMNumber(uint8_t rom) const
 {
   if (rom > 3)
   {
-    if (_logger)
-      _logger->errF(F("Invalid ROM number: %d. Valid range is 0-3."), rom);
+    M1_LOG_ERR(_logger, "Invalid ROM number: %d. Valid range is 0-3.", rom);
     return false;
   }
   return true;
@@ -6,6 +6,8 @@
 
 #include "Screen.h"
 #include "M1Shield.h"
+#include "MemoryDiagnostics.h"
+#include "Profiler.h"
 #include <Adafruit_GFX.h>
 
 // Constructor - initialize screen as inactive
@@ -49,6 +51,8 @@ bool Screen::open()
     }
 
     _active = true;
+
+    M1_PROFILE("Screen::draw");
     _drawScreen();      // Trigger initial rendering
     M1Shield.display(); // Push changes to display
 
@@ -71,6 +75,7 @@ void Screen::refresh()
 {
     if (_active)
     {
+        M1_PROFILE("Screen::draw");
         _drawScreen();      // Redraw the screen content
         M1Shield.display(); // Push changes to display
     }
@@ -91,12 +96,12 @@ void Screen::setTitle(const char *title)
     if (title != nullptr && title[0] != '\0')
     {
         size_t titleLen = strlen(title);
-        _title = (char *)malloc(titleLen + 1); // +1 for null terminator
+        _title = (char *)MemoryDiagnostics.allocate(titleLen + 1, MEMORY_TAG_SCREEN); // +1 for null terminator
         if (_title != nullptr)
         {
             strcpy(_title, title); // Safe because we allocated exact size needed
         }
-        else if (getLogger())
+        else if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("Screen[%s]: Failed to allocate memory for title"),
@@ -125,7 +130,7 @@ void Screen::setTitleF(const __FlashStringHelper *title)
     char *buffer = (char *)malloc(len + 1);
     if (buffer == nullptr)
     {
-        if (getLogger())
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_ERROR) && getLogger())
         {
             const char *currentTitle = getTitle();
             getLogger()->errF(F("Screen[%s]: Failed to allocate memory for flash title"),
@@ -150,7 +155,7 @@ void Screen::clearTitle()
 {
     if (_title != nullptr)
     {
-        free(_title);
+        MemoryDiagnostics.release(_title, MEMORY_TAG_SCREEN);
         _title = nullptr;
     }
 }
@@ -0,0 +1,452 @@
+/*
+ * ShadowMemory.cpp - Class for caching TRS-80 Model 1 memory ranges on the Arduino
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "ShadowMemory.h"
+#include "MemoryDiagnostics.h"
+
+// Memory-mapped I/O (0x37E0-0x37FF) and the keyboard (0x3800-0x3BFF) change without the Z80 running
+#define UNCACHEABLE_START 0x37E0
+#define UNCACHEABLE_END 0x3BFF
+
+// Constructor
+ShadowMemory::ShadowMemory()
+{
+    _logger = nullptr;
+    _rangeCount = 0;
+    _size = 0;
+    _storage = nullptr;
+    _hits = 0;
+    _misses = 0;
+}
+
+// Destructor, detaches from Model1 so it never uses the freed copy
+ShadowMemory::~ShadowMemory()
+{
+    // No flush here: a derived storage backend is already destroyed
+    if (Model1._shadow == this)
+    {
+        if (isDirty())
+            M1_LOG_WARN(_logger, "ShadowMemory: Destroyed with unflushed writes");
+        Model1._shadow = nullptr;
+    }
+
+    clearRanges();
+    if (_storage)
+    {
+        MemoryDiagnostics.release(_storage, MEMORY_TAG_SHADOW);
+        _storage = nullptr;
+    }
+}
+
+// Set logger for debugging output
+void ShadowMemory::setLogger(ILogger &logger)
+{
+    _logger = &logger;
+}
+
+// ----------------------------------------
+// ---------- Ranges
+// ----------------------------------------
+
+// Cache an address range
+bool ShadowMemory::addRange(uint16_t start, uint16_t length)
+{
+    if (length == 0)
+    {
+        M1_LOG_ERR(_logger, "ShadowMemory: addRange called with length 0");
+        return false;
+    }
+    uint32_t end = (uint32_t)start + length - 1;
+    if (end > 0xFFFF)
+    {
+        M1_LOG_ERR(_logger, "ShadowMemory: Range 0x%04X + %u exceeds the address space", start, length);
+        return false;
+    }
+    if (start <= UNCACHEABLE_END && end >= UNCACHEABLE_START)
+    {
+        M1_LOG_ERR(_logger, "ShadowMemory: Memory-mapped I/O and keyboard (0x37E0-0x3BFF) cannot be cached");
+        return false;
+    }
+    if (_rangeCount >= SHADOW_MAX_RANGES)
+    {
+        M1_LOG_ERR(_logger, "ShadowMemory: No more than %u ranges supported", SHADOW_MAX_RANGES);
+        return false;
+    }
+    for (uint8_t i = 0; i < _rangeCount; i++)
+    {
+        uint32_t otherEnd = (uint32_t)_ranges[i].start + _ranges[i].length - 1;
+        if (start <= otherEnd && end >= _ranges[i].start)
+        {
+            M1_LOG_ERR(_logger, "ShadowMemory: Range 0x%04X overlaps an existing range", start);
+            return false;
+        }
+    }
+
+    uint16_t lines = (length + SHADOW_LINE_SIZE - 1) / SHADOW_LINE_SIZE;
+    uint16_t bitmapSize = (lines + 7) / 8;
+    uint8_t *bitmaps = (uint8_t *)MemoryDiagnostics.allocate(bitmapSize * 2, MEMORY_TAG_SHADOW);
+    if (!bitmaps || !_resizeStorage(_size + length))
+    {
+        MemoryDiagnostics.release(bitmaps, MEMORY_TAG_SHADOW);
+        M1_LOG_ERR(_logger, "ShadowMemory: Not enough memory to cache %u bytes", length);
+        return false;
+    }
+    memset(bitmaps, 0, bitmapSize * 2);
+
+    ShadowRange &range = _ranges[_rangeCount++];
+    range.start = start;
+    range.length = length;
+    range.offset = _size;
+    range.valid = bitmaps;
+    range.dirty = bitmaps + bitmapSize;
+    _size += length;
+
+    return true;
+}
+
+// Remove all ranges, discarding unflushed writes
+void ShadowMemory::clearRanges()
+{
+    for (uint8_t i = 0; i < _rangeCount; i++)
+    {
+        MemoryDiagnostics.release(_ranges[i].valid, MEMORY_TAG_SHADOW); // Dirty bitmap shares the allocation
+    }
+    _rangeCount = 0;
+    _size = 0;
+}
+
+// Find the range holding an address
+// When there is none, distance receives the number of bytes up to the next range (0 if none follows)
+ShadowRange *ShadowMemory::_findRange(uint16_t address, uint16_t *distance)
+{
+    uint16_t nearest = 0;
+    for (uint8_t i = 0; i < _rangeCount; i++)
+    {
+        ShadowRange &range = _ranges[i];
+        if (address >= range.start && (uint32_t)address < (uint32_t)range.start + range.length)
+            return &range;
+        if (range.start > address && (nearest == 0 || range.start - address < nearest))
+            nearest = range.start - address;
+    }
+    if (distance)
+        *distance = nearest;
+    return nullptr;
+}
+
+// Get the number of uncached bytes to access before the next range or the end of the address space
+uint16_t ShadowMemory::_getUncachedRun(uint16_t address, uint16_t distance, uint16_t remaining)
+{
+    if (distance == 0)
+        distance = (uint16_t)(0x10000UL - address); // 0 for 0x0000, meaning the full address space
+    return (distance != 0 && distance < remaining) ? distance : remaining;
+}
+
+// Check if an address is cached
+bool ShadowMemory::covers(uint16_t address)
+{
+    return _findRange(address, nullptr) != nullptr;
+}
+
+// ----------------------------------------
+// ---------- Access
+// ----------------------------------------
+
+// Fill a line from the bus unless it already holds a copy
+void ShadowMemory::_loadLine(ShadowRange &range, uint16_t line)
+{
+    if (range.valid[line >> 3] & (1 << (line & 7)))
+    {
+        _hits++;
+        return;
+    }
+
+    uint16_t lineOffset = line * SHADOW_LINE_SIZE;
+    uint16_t lineLength = (range.length - lineOffset < SHADOW_LINE_SIZE) ? (range.length - lineOffset) : SHADOW_LINE_SIZE;
+
+    uint8_t buffer[SHADOW_LINE_SIZE];
+    Model1._readMemoryBus(range.start + lineOffset, buffer, lineLength);
+    _writeStorage(range.offset + lineOffset, buffer, lineLength);
+
+    range.valid[line >> 3] |= (1 << (line & 7));
+    _misses++;
+}
+
+// Read part of a range, filling missing lines first
+void ShadowMemory::_readRange(ShadowRange &range, uint16_t address, uint8_t *buffer, uint16_t length)
+{
+    uint16_t offset = address - range.start;
+    uint16_t firstLine = offset / SHADOW_LINE_SIZE;
+    uint16_t lastLine = (offset + length - 1) / SHADOW_LINE_SIZE;
+    for (uint16_t line = firstLine; line <= lastLine; line++)
+        _loadLine(range, line);
+
+    _readStorage(range.offset + offset, buffer, length);
+}
+
+// Write part of a range; partially written lines are filled first so they can be flushed whole
+void ShadowMemory::_writeRange(ShadowRange &range, uint16_t address, const uint8_t *data, uint16_t length)
+{
+    uint16_t offset = address - range.start;
+    uint16_t firstLine = offset / SHADOW_LINE_SIZE;
+    uint16_t lastLine = (offset + length - 1) / SHADOW_LINE_SIZE;
+    for (uint16_t line = firstLine; line <= lastLine; line++)
+    {
+        uint16_t lineStart = line * SHADOW_LINE_SIZE;
+        uint16_t lineEnd = (range.length - lineStart < SHADOW_LINE_SIZE) ? range.length : (lineStart + SHADOW_LINE_SIZE);
+        if (offset > lineStart || (uint32_t)offset + length < lineEnd)
+            _loadLine(range, line);
+
+        range.valid[line >> 3] |= (1 << (line & 7));
+        range.dirty[line >> 3] |= (1 << (line & 7));
+    }
+
+    _writeStorage(range.offset + offset, data, length);
+}
+
+// Write memory outside the cached ranges, continuing a repeating pattern at dataIndex
+void ShadowMemory::_writeThrough(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t dataIndex, uint16_t length)
+{
+    if (dataLength == 1)
+    {
+        Model1._writeMemoryBus(address, data, 1, length);
+        return;
+    }
+    if (dataIndex == 0)
+    {
+        Model1._writeMemoryBus(address, data, dataLength, length);
+        return;
+    }
+    if (dataIndex + length <= dataLength)
+    {
+        Model1._writeMemoryBus(address, data + dataIndex, length, length);
+        return;
+    }
+
+    // Unroll a pattern that does not start at its beginning
+    uint8_t buffer[SHADOW_LINE_SIZE];
+    for (uint16_t done = 0; done < length;)
+    {
+        uint16_t chunkSize = (length - done < SHADOW_LINE_SIZE) ? (length - done) : SHADOW_LINE_SIZE;
+        for (uint16_t i = 0; i < chunkSize; i++)
+        {
+            buffer[i] = data[dataIndex];
+            if (++dataIndex >= dataLength)
+                dataIndex = 0;
+        }
+        Model1._writeMemoryBus(address + done, buffer, chunkSize, chunkSize);
+        done += chunkSize;
+    }
+}
+
+// Read memory, serving cached ranges from the shadow copy and everything else from the bus
+void ShadowMemory::read(uint16_t address, uint8_t *buffer, uint16_t length)
+{
+    uint16_t done = 0;
+    while (done < length)
+    {
+        uint16_t current = address + done;
+        uint16_t remaining = length - done;
+        uint16_t distance;
+        ShadowRange *range = _findRange(current, &distance);
+
+        uint16_t runLength;
+        if (range)
+        {
+            uint32_t rangeLeft = (uint32_t)range->start + range->length - current;
+            runLength = (remaining < rangeLeft) ? remaining : rangeLeft;
+            _readRange(*range, current, buffer + done, runLength);
+        }
+        else
+        {
+            runLength = _getUncachedRun(current, distance, remaining);
+            Model1._readMemoryBus(current, buffer + done, runLength);
+        }
+        done += runLength;
+    }
+}
+
+// Write (repeating) data, into the shadow copy for cached ranges and to the bus for everything else
+void ShadowMemory::write(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length)
+{
+    uint8_t buffer[SHADOW_LINE_SIZE];
+    uint16_t done = 0;
+    while (done < length)
+    {
+        uint16_t current = address + done;
+        uint16_t remaining = length - done;
+        uint16_t distance;
+        ShadowRange *range = _findRange(current, &distance);
+
+        uint16_t runLength;
+        if (range)
+        {
+            uint32_t rangeLeft = (uint32_t)range->start + range->length - current;
+            runLength = (remaining < rangeLeft) ? remaining : rangeLeft;
+
+            if (dataLength == length)
+            {
+                _writeRange(*range, current, data + done, runLength);
+            }
+            else
+            {
+                // Expand the pattern one line at a time
+                for (uint16_t written = 0; written < runLength;)
+                {
+                    uint16_t chunkSize = (runLength - written < SHADOW_LINE_SIZE) ? (runLength - written) : SHADOW_LINE_SIZE;
+                    for (uint16_t i = 0; i < chunkSize; i++)
+                        buffer[i] = data[(done + written + i) % dataLength];
+                    _writeRange(*range, current + written, buffer, chunkSize);
+                    written += chunkSize;
+                }
+            }
+        }
+        else
+        {
+            runLength = _getUncachedRun(current, distance, remaining);
+            _writeThrough(current, data, dataLength, done % dataLength, runLength);
+        }
+        done += runLength;
+    }
+}
+
+// ----------------------------------------
+// ---------- Bulk Operations
+// ----------------------------------------
+
+// Fill all ranges from the bus; false if the bus is not held
+bool ShadowMemory::prefetch()
+{
+    if (!Model1._checkBurstAccess())
+        return false;
+
+    for (uint8_t i = 0; i < _rangeCount; i++)
+    {
+        ShadowRange &range = _ranges[i];
+        uint16_t lines = (range.length + SHADOW_LINE_SIZE - 1) / SHADOW_LINE_SIZE;
+        for (uint16_t line = 0; line < lines; line++)
+            _loadLine(range, line);
+    }
+    return true;
+}
+
+// Write all dirty lines back to memory; false if the bus is not held
+bool ShadowMemory::flush()
+{
+    if (!isDirty())
+        return true;
+    if (!Model1._checkBurstAccess())
+        return false;
+
+    uint8_t buffer[SHADOW_LINE_SIZE];
+    for (uint8_t i = 0; i < _rangeCount; i++)
+    {
+        ShadowRange &range = _ranges[i];
+        uint16_t lines = (range.length + SHADOW_LINE_SIZE - 1) / SHADOW_LINE_SIZE;
+        for (uint16_t line = 0; line < lines; line++)
+        {
+            if (!(range.dirty[line >> 3] & (1 << (line & 7))))
+            {
+                // Skip a whole byte of clean lines at once
+                if (range.dirty[line >> 3] == 0)
+                    line |= 7;
+                continue;
+            }
+
+            uint16_t lineOffset = line * SHADOW_LINE_SIZE;
+            uint16_t lineLength = (range.length - lineOffset < SHADOW_LINE_SIZE) ? (range.length - lineOffset) : SHADOW_LINE_SIZE;
+            _readStorage(range.offset + lineOffset, buffer, lineLength);
+            Model1._writeMemoryBus(range.start + lineOffset, buffer, lineLength, lineLength);
+
+            range.dirty[line >> 3] &= ~(1 << (line & 7));
+        }
+    }
+    return true;
+}
+
+// Drop all cached data without writing it back
+void ShadowMemory::invalidate()
+{
+    for (uint8_t i = 0; i < _rangeCount; i++)
+    {
+        ShadowRange &range = _ranges[i];
+        uint16_t bitmapSize = ((range.length + SHADOW_LINE_SIZE - 1) / SHADOW_LINE_SIZE + 7) / 8;
+        memset(range.valid, 0, bitmapSize);
+        memset(range.dirty, 0, bitmapSize);
+    }
+}
+
+// Check if any line waits to be flushed
+bool ShadowMemory::isDirty()
+{
+    for (uint8_t i = 0; i < _rangeCount; i++)
+    {
+        ShadowRange &range = _ranges[i];
+        uint16_t bitmapSize = ((range.length + SHADOW_LINE_SIZE - 1) / SHADOW_LINE_SIZE + 7) / 8;
+        for (uint16_t j = 0; j < bitmapSize; j++)
+        {
+            if (range.dirty[j])
+                return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------
+// ---------- Statistics
+// ----------------------------------------
+
+// Get the number of lines served from the cache
+uint32_t ShadowMemory::getHits()
+{
+    return _hits;
+}
+
+// Get the number of lines filled from the bus
+uint32_t ShadowMemory::getMisses()
+{
+    return _misses;
+}
+
+// Reset hit and miss counters
+void ShadowMemory::resetStatistics()
+{
+    _hits = 0;
+    _misses = 0;
+}
+
+// ----------------------------------------
+// ---------- Storage
+// ----------------------------------------
+
+// Make room for size bytes in SRAM, keeping the bytes of the existing ranges
+bool ShadowMemory::_resizeStorage(uint32_t size)
+{
+    if (size > 0xFFFF)
+        return false;
+
+    uint8_t *storage = (uint8_t *)MemoryDiagnostics.allocate(size, MEMORY_TAG_SHADOW);
+    if (!storage)
+        return false;
+    if (_storage)
+    {
+        memcpy(storage, _storage, _size);
+        MemoryDiagnostics.release(_storage, MEMORY_TAG_SHADOW);
+    }
+    _storage = storage;
+    return true;
+}
+
+// Read from SRAM storage
+void ShadowMemory::_readStorage(uint32_t offset, uint8_t *buffer, uint16_t length)
+{
+    memcpy(buffer, _storage + offset, length);
+}
+
+// Write to SRAM storage
+void ShadowMemory::_writeStorage(uint32_t offset, const uint8_t *buffer, uint16_t length)
+{
+    memcpy(_storage + offset, buffer, length);
+}
@@ -0,0 +1,87 @@
+/*
+ * ShadowMemory.h - Class for caching TRS-80 Model 1 memory ranges on the Arduino
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef SHADOWMEMORY_H
+#define SHADOWMEMORY_H
+
+#include <Arduino.h>
+#include "ILogger.h"
+#include "Model1.h"
+
+// Bytes per cache line; lines are filled and flushed as a whole
+#ifndef SHADOW_LINE_SIZE
+#define SHADOW_LINE_SIZE 32
+#endif
+
+// Maximum number of cached address ranges
+#ifndef SHADOW_MAX_RANGES
+#define SHADOW_MAX_RANGES 4
+#endif
+
+// Cached address range
+struct ShadowRange
+{
+    uint16_t start;  // First address of the range
+    uint16_t length; // Number of bytes in the range
+    uint32_t offset; // Position of the range in the storage
+    uint8_t *valid;  // Bitmap of lines holding a copy of the memory
+    uint8_t *dirty;  // Bitmap of lines written but not yet flushed
+};
+
+class ShadowMemory
+{
+    friend class Model1Class; // Only Model1 reads and writes through the copy, after validating the bus state
+
+private:
+    ILogger *_logger; // Logger instance for debugging output
+
+    ShadowRange _ranges[SHADOW_MAX_RANGES]; // Cached ranges
+    uint8_t _rangeCount;                    // Number of cached ranges
+    uint32_t _size;                         // Total bytes of all ranges
+
+    uint32_t _hits;   // Lines served from the cache
+    uint32_t _misses; // Lines filled from the bus
+
+    ShadowRange *_findRange(uint16_t address, uint16_t *distance);                                   // Find range holding an address, or distance to the next one
+    uint16_t _getUncachedRun(uint16_t address, uint16_t distance, uint16_t remaining);               // Bytes to access before the next range
+    void _loadLine(ShadowRange &range, uint16_t line);                                               // Fill a line from the bus if not valid; caller holds the bus
+    void _readRange(ShadowRange &range, uint16_t address, uint8_t *buffer, uint16_t length);         // Read part of a range
+    void _writeRange(ShadowRange &range, uint16_t address, const uint8_t *data, uint16_t length);     // Write part of a range
+    void _writeThrough(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t dataIndex, uint16_t length); // Write uncached memory
+
+    void read(uint16_t address, uint8_t *buffer, uint16_t length);                           // Read memory, from the cache where possible
+    void write(uint16_t address, const uint8_t *data, uint16_t dataLength, uint16_t length); // Write (repeating) data, into the cache where possible
+
+protected:
+    uint8_t *_storage; // SRAM storage used by the default implementation
+
+    // Storage backend; override to keep the copy elsewhere, e.g. in external SPI RAM
+    virtual bool _resizeStorage(uint32_t size);                                          // Make room for size bytes
+    virtual void _readStorage(uint32_t offset, uint8_t *buffer, uint16_t length);        // Read from storage
+    virtual void _writeStorage(uint32_t offset, const uint8_t *buffer, uint16_t length); // Write to storage
+
+public:
+    ShadowMemory();          // Constructor
+    virtual ~ShadowMemory(); // Destructor, detaches from Model1 and frees storage
+
+    void setLogger(ILogger &logger); // Set logger for debugging output
+
+    bool addRange(uint16_t start, uint16_t length); // Cache an address range
+    void clearRanges();                             // Remove all ranges, discarding unflushed writes
+
+    bool covers(uint16_t address); // Check if an address is cached
+
+    bool prefetch();   // Fill all ranges from the bus; false if the bus is not held
+    bool flush();      // Write all dirty lines back to memory; false if the bus is not held
+    void invalidate(); // Drop all cached data without writing it back
+
+    bool isDirty();         // Check if any line waits to be flushed
+    uint32_t getHits();     // Lines served from the cache
+    uint32_t getMisses();   // Lines filled from the bus
+    void resetStatistics(); // Reset hit and miss counters
+};
+
+#endif // SHADOWMEMORY_H
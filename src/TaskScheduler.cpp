@@ -0,0 +1,367 @@
+/*
+ * TaskScheduler.cpp - Cooperative scheduler for periodic tasks run from M1Shield::loop()
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "TaskScheduler.h"
+
+#if TASK_SCHEDULER_MAX_TASKS > 32
+#error "TASK_SCHEDULER_MAX_TASKS must not be larger than 32"
+#endif
+
+TaskSchedulerClass TaskScheduler;
+
+// Constructor
+TaskSchedulerClass::TaskSchedulerClass()
+{
+    _logger = nullptr;
+    _loopBudget = 0;
+    _current = -1;
+    _runStart = 0;
+
+    memset(_slots, 0, sizeof(_slots));
+}
+
+// Set the logger for debugging output
+void TaskSchedulerClass::setLogger(ILogger &logger)
+{
+    _logger = &logger;
+}
+
+// ----------------------------------------
+// ---------- Tasks
+// ----------------------------------------
+
+// Add a task object; it stays owned by the caller
+int8_t TaskSchedulerClass::addTask(const __FlashStringHelper *name, Task &task, uint32_t intervalMs, uint32_t budgetUs,
+                                   TaskPriority priority)
+{
+    return _add(name, &task, nullptr, intervalMs, budgetUs, priority);
+}
+
+// Add a callback that runs until it is removed
+int8_t TaskSchedulerClass::addTask(const __FlashStringHelper *name, TaskCallback callback, uint32_t intervalMs,
+                                   uint32_t budgetUs, TaskPriority priority)
+{
+    if (!callback)
+        return -1;
+    return _add(name, nullptr, callback, intervalMs, budgetUs, priority);
+}
+
+// Fill a free slot; the task is due right away
+int8_t TaskSchedulerClass::_add(const __FlashStringHelper *name, Task *task, TaskCallback callback,
+                                uint32_t intervalMs, uint32_t budgetUs, TaskPriority priority)
+{
+    if (priority >= TASK_PRIORITY_COUNT)
+        priority = TASK_PRIORITY_LOW;
+
+    for (int8_t i = 0; i < TASK_SCHEDULER_MAX_TASKS; i++)
+    {
+        TaskSlot &slot = _slots[i];
+        if (slot.used)
+            continue;
+
+        memset(&slot, 0, sizeof(slot));
+        slot.statistics.name = (const char *)name;
+        slot.task = task;
+        slot.callback = callback;
+        slot.interval = intervalMs * 1000UL;
+        slot.deadline = slot.interval;
+        slot.budget = budgetUs;
+        slot.nextRun = micros();
+        slot.priority = priority;
+        slot.used = true;
+        return i;
+    }
+
+    M1_LOG_ERR(_logger, "TaskScheduler: No free slot, raise TASK_SCHEDULER_MAX_TASKS");
+    return -1;
+}
+
+// Id refers to a used slot
+bool TaskSchedulerClass::_isValid(int8_t id)
+{
+    return id >= 0 && id < TASK_SCHEDULER_MAX_TASKS && _slots[id].used;
+}
+
+// Remove a task; a running task finishes its current run first
+bool TaskSchedulerClass::removeTask(int8_t id)
+{
+    if (!_isValid(id))
+        return false;
+
+    _slots[id].used = false;
+    return true;
+}
+
+// Change the time between runs; the next run stays where it is
+bool TaskSchedulerClass::setInterval(int8_t id, uint32_t intervalMs)
+{
+    if (!_isValid(id))
+        return false;
+
+    _slots[id].interval = intervalMs * 1000UL;
+    return true;
+}
+
+// Change how late a task may start before it counts as a missed deadline
+bool TaskSchedulerClass::setDeadline(int8_t id, uint32_t deadlineMs)
+{
+    if (!_isValid(id))
+        return false;
+
+    _slots[id].deadline = deadlineMs * 1000UL;
+    return true;
+}
+
+// Stop running a task until it is resumed
+bool TaskSchedulerClass::pauseTask(int8_t id)
+{
+    if (!_isValid(id))
+        return false;
+
+    _slots[id].paused = true;
+    return true;
+}
+
+// Run a paused task again, starting with the next pass
+bool TaskSchedulerClass::resumeTask(int8_t id)
+{
+    if (!_isValid(id))
+        return false;
+
+    TaskSlot &slot = _slots[id];
+    if (slot.paused)
+    {
+        slot.paused = false;
+        slot.nextRun = micros();
+    }
+    return true;
+}
+
+// Task exists and is not paused
+bool TaskSchedulerClass::isTaskActive(int8_t id)
+{
+    return _isValid(id) && !_slots[id].paused;
+}
+
+// Number of tasks, paused ones included
+uint8_t TaskSchedulerClass::getTaskCount()
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < TASK_SCHEDULER_MAX_TASKS; i++)
+    {
+        if (_slots[i].used)
+            count++;
+    }
+    return count;
+}
+
+// ----------------------------------------
+// ---------- Scheduling
+// ----------------------------------------
+
+// Time of one pass after which only high priority tasks run; 0 runs all due tasks
+void TaskSchedulerClass::setLoopBudget(uint32_t budgetUs)
+{
+    _loopBudget = budgetUs;
+}
+
+// Run every due task once, highest priority and most overdue first
+void TaskSchedulerClass::loop()
+{
+    // Tasks calling M1Shield::loop() must not run the scheduler again
+    if (_current >= 0)
+        return;
+
+    uint32_t start = micros();
+    uint32_t done = 0;
+
+    while (true)
+    {
+        uint32_t now = micros();
+        bool budgetLeft = _loopBudget == 0 || now - start < _loopBudget;
+
+        int8_t id = _nextDue(now, done, budgetLeft);
+        if (id < 0)
+            break;
+
+        done |= 1UL << id;
+        _run(id, now);
+    }
+}
+
+// Most urgent due task that did not run in this pass; -1 if there is none
+int8_t TaskSchedulerClass::_nextDue(uint32_t now, uint32_t done, bool budgetLeft)
+{
+    int8_t best = -1;
+    for (int8_t i = 0; i < TASK_SCHEDULER_MAX_TASKS; i++)
+    {
+        const TaskSlot &slot = _slots[i];
+        if (!slot.used || slot.paused || (done & (1UL << i)))
+            continue;
+        if ((int32_t)(now - slot.nextRun) < 0)
+            continue;
+        if (!budgetLeft && slot.priority != TASK_PRIORITY_HIGH)
+            continue;
+
+        if (best < 0 || slot.priority < _slots[best].priority ||
+            (slot.priority == _slots[best].priority && (int32_t)(slot.nextRun - _slots[best].nextRun) < 0))
+            best = i;
+    }
+    return best;
+}
+
+// Run a task, measure it and schedule its next run
+void TaskSchedulerClass::_run(int8_t id, uint32_t now)
+{
+    TaskSlot &slot = _slots[id];
+
+    uint32_t lateness = now - slot.nextRun;
+    if (lateness > slot.statistics.maxLateness)
+        slot.statistics.maxLateness = lateness;
+    if (slot.deadline && lateness > slot.deadline)
+    {
+        slot.statistics.missedDeadlines++;
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_WARN))
+            _report(slot, slot.deadlineLogged, F("Task %s started %lu us late (deadline %lu us)"), lateness, slot.deadline);
+    }
+
+    // Periods that were missed completely are skipped instead of run back to back
+    slot.nextRun += slot.interval;
+    if ((int32_t)(now - slot.nextRun) >= 0)
+        slot.nextRun = now + slot.interval;
+
+    _current = id;
+    _runStart = micros();
+
+    bool keep = true;
+    if (slot.task)
+        keep = slot.task->run();
+    else
+        slot.callback();
+
+    uint32_t duration = micros() - _runStart;
+    _current = -1;
+
+    // Removed while running
+    if (!slot.used)
+        return;
+
+    slot.statistics.runs++;
+    slot.statistics.totalDuration += duration;
+    if (duration > slot.statistics.maxDuration)
+        slot.statistics.maxDuration = duration;
+    if (slot.budget && duration > slot.budget)
+    {
+        slot.statistics.overruns++;
+        if (M1_LOG_ENABLED(M1_LOG_LEVEL_WARN))
+            _report(slot, slot.overrunLogged, F("Task %s ran %lu us (budget %lu us)"), duration, slot.budget);
+    }
+
+    if (!keep)
+        slot.used = false;
+}
+
+// Log the first overrun or missed deadline of a task; later ones are only counted
+void TaskSchedulerClass::_report(TaskSlot &slot, bool &logged, const __FlashStringHelper *format,
+                                 uint32_t value, uint32_t limit)
+{
+    if (logged || !_logger)
+        return;
+    logged = true;
+
+    char name[16];
+    strncpy_P(name, slot.statistics.name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+
+    _logger->warnF(format, name, (unsigned long)value, (unsigned long)limit);
+}
+
+// Running task used up its budget; always false outside of tasks and without a budget
+bool TaskSchedulerClass::shouldYield()
+{
+    if (_current < 0 || _slots[_current].budget == 0)
+        return false;
+    return micros() - _runStart >= _slots[_current].budget;
+}
+
+// Microseconds left of the running task's budget; 0xFFFFFFFF without a budget
+uint32_t TaskSchedulerClass::getRemainingBudget()
+{
+    if (_current < 0)
+        return 0;
+
+    uint32_t budget = _slots[_current].budget;
+    if (budget == 0)
+        return 0xFFFFFFFFUL;
+
+    uint32_t used = micros() - _runStart;
+    return used < budget ? budget - used : 0;
+}
+
+// ----------------------------------------
+// ---------- Statistics
+// ----------------------------------------
+
+// Statistics of a task
+bool TaskSchedulerClass::getTaskStatistics(int8_t id, TaskStatistics &statistics)
+{
+    if (!_isValid(id))
+        return false;
+
+    statistics = _slots[id].statistics;
+    return true;
+}
+
+// Clear the statistics of all tasks; overruns and missed deadlines are logged again
+void TaskSchedulerClass::resetStatistics()
+{
+    for (uint8_t i = 0; i < TASK_SCHEDULER_MAX_TASKS; i++)
+    {
+        TaskSlot &slot = _slots[i];
+        const char *name = slot.statistics.name;
+
+        memset(&slot.statistics, 0, sizeof(slot.statistics));
+        slot.statistics.name = name;
+        slot.overrunLogged = false;
+        slot.deadlineLogged = false;
+    }
+}
+
+// Log all tasks to the logger set with setLogger()
+void TaskSchedulerClass::dump()
+{
+    if (_logger)
+        dump(*_logger);
+}
+
+// Log runs, durations, lateness, overruns and missed deadlines of all tasks
+void TaskSchedulerClass::dump(ILogger &logger)
+{
+    if (getTaskCount() == 0)
+    {
+        logger.infoF(F("TaskScheduler: No tasks"));
+        return;
+    }
+
+    for (uint8_t i = 0; i < TASK_SCHEDULER_MAX_TASKS; i++)
+    {
+        const TaskSlot &slot = _slots[i];
+        if (!slot.used)
+            continue;
+
+        const TaskStatistics &statistics = slot.statistics;
+        uint32_t mean = statistics.runs ? statistics.totalDuration / statistics.runs : 0;
+
+        char name[16];
+        strncpy_P(name, statistics.name, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+
+        logger.infoF(F("%s%s: %lu run(s), %lu/%lu us mean/max, %lu us late max, %u overrun(s), %u missed deadline(s)"),
+                     name, slot.paused ? " (paused)" : "", (unsigned long)statistics.runs, (unsigned long)mean,
+                     (unsigned long)statistics.maxDuration, (unsigned long)statistics.maxLateness,
+                     statistics.overruns, statistics.missedDeadlines);
+    }
+}
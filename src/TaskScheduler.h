@@ -0,0 +1,137 @@
+/*
+ * TaskScheduler.h - Cooperative scheduler for periodic tasks run from M1Shield::loop()
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+/**
+ * TaskScheduler runs small pieces of work between the input handling of
+ * M1Shield::loop(), so keyboard scanning, SD card flushes, screen redraws and
+ * bulk transfers can share the CPU without blocking the user interface:
+ *
+ *     void scanKeyboard() { ... }
+ *
+ *     TaskScheduler.addTask(F("Keyboard"), scanKeyboard, 20, 500, TASK_PRIORITY_HIGH);
+ *
+ * Every task has an interval, a time budget and a priority. Each call to
+ * loop() runs every due task once, highest priority first. Once the tasks of
+ * a pass used up the loop budget, lower priority tasks wait for the next pass.
+ *
+ * Tasks are never interrupted; a task that takes longer than its budget is
+ * counted as an overrun, and one that starts later than its deadline as a
+ * missed deadline. The first of each is logged. Long running work checks
+ * shouldYield() and returns early to continue on its next run.
+ */
+
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <Arduino.h>
+#include "ILogger.h"
+
+// Maximum number of tasks (about 50 bytes of RAM each, at most 32)
+#ifndef TASK_SCHEDULER_MAX_TASKS
+#define TASK_SCHEDULER_MAX_TASKS 8
+#endif
+
+// Order in which due tasks run
+enum TaskPriority : uint8_t
+{
+    TASK_PRIORITY_HIGH,   // Input and anything the user waits for; runs even when the loop budget is used up
+    TASK_PRIORITY_NORMAL, // Screen updates and flushes
+    TASK_PRIORITY_LOW,    // Bulk transfers
+    TASK_PRIORITY_COUNT
+};
+
+// Work run by the scheduler
+class Task
+{
+public:
+    virtual ~Task() = default;
+
+    virtual bool run() = 0; // Do one slice of work; return false when finished to be removed
+};
+
+// Plain function run by the scheduler
+typedef void (*TaskCallback)();
+
+// Statistics of one task; durations and lateness in microseconds
+struct TaskStatistics
+{
+    const char *name;         // Task name (PROGMEM)
+    uint32_t runs;            // Number of runs
+    uint16_t overruns;        // Runs longer than the budget
+    uint16_t missedDeadlines; // Runs started later than the deadline
+    uint32_t maxDuration;     // Longest run
+    uint32_t totalDuration;   // Sum of all runs
+    uint32_t maxLateness;     // Longest delay between due time and start
+};
+
+class TaskSchedulerClass
+{
+private:
+    // Entry of the task table
+    struct TaskSlot
+    {
+        TaskStatistics statistics; // Statistics, including the name
+        Task *task;                // Task object, or nullptr for a callback
+        TaskCallback callback;     // Callback, or nullptr for a task object
+        uint32_t interval;         // Time between runs
+        uint32_t deadline;         // Allowed lateness, 0 for none
+        uint32_t budget;           // Allowed duration, 0 for none
+        uint32_t nextRun;          // Time the task is due next
+        TaskPriority priority;     // Order among due tasks
+        bool used;                 // Slot holds a task
+        bool paused;               // Not run until resumed
+        bool overrunLogged;        // First overrun was logged
+        bool deadlineLogged;       // First missed deadline was logged
+    };
+
+    ILogger *_logger; // Logger instance for debugging output
+
+    TaskSlot _slots[TASK_SCHEDULER_MAX_TASKS]; // Task table
+    uint32_t _loopBudget;                      // Time of one pass before lower priorities wait, 0 for none
+    int8_t _current;                           // Index of the running task, -1 outside of tasks
+    uint32_t _runStart;                        // Start of the running task
+
+    int8_t _add(const __FlashStringHelper *name, Task *task, TaskCallback callback,
+                uint32_t intervalMs, uint32_t budgetUs, TaskPriority priority); // Fill a free slot
+    bool _isValid(int8_t id);                                                   // Id refers to a used slot
+    int8_t _nextDue(uint32_t now, uint32_t done, bool budgetLeft);              // Most urgent due task not run yet
+    void _run(int8_t id, uint32_t now);                                         // Run a task and update its statistics
+    void _report(TaskSlot &slot, bool &logged, const __FlashStringHelper *format,
+                 uint32_t value, uint32_t limit);                               // Log the first problem of a kind
+
+public:
+    TaskSchedulerClass(); // Constructor
+
+    void setLogger(ILogger &logger); // Set logger for debugging output
+
+    int8_t addTask(const __FlashStringHelper *name, Task &task, uint32_t intervalMs, uint32_t budgetUs,
+                   TaskPriority priority = TASK_PRIORITY_NORMAL); // Add a task object; returns its id or -1
+    int8_t addTask(const __FlashStringHelper *name, TaskCallback callback, uint32_t intervalMs, uint32_t budgetUs,
+                   TaskPriority priority = TASK_PRIORITY_NORMAL); // Add a callback; returns its id or -1
+    bool removeTask(int8_t id);                                   // Remove a task; it may be running
+    bool setInterval(int8_t id, uint32_t intervalMs);             // Change the time between runs
+    bool setDeadline(int8_t id, uint32_t deadlineMs);             // Change the allowed lateness (default: interval)
+    bool pauseTask(int8_t id);                                    // Stop running a task
+    bool resumeTask(int8_t id);                                   // Run a paused task again, due now
+    bool isTaskActive(int8_t id);                                 // Task exists and is not paused
+    uint8_t getTaskCount();                                       // Number of tasks
+
+    void setLoopBudget(uint32_t budgetUs); // Time of one pass after which only high priority tasks run
+    void loop();                           // Run all due tasks once; called by M1Shield::loop()
+
+    bool shouldYield();            // Running task used up its budget
+    uint32_t getRemainingBudget(); // Microseconds left of the running task's budget
+
+    bool getTaskStatistics(int8_t id, TaskStatistics &statistics); // Statistics of a task
+    void resetStatistics();                                        // Clear the statistics of all tasks
+
+    void dump(ILogger &logger); // Log all tasks
+    void dump();                // Log to the logger set with setLogger()
+};
+
+extern TaskSchedulerClass TaskScheduler;
+
+#endif // TASKSCHEDULER_H
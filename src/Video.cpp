@@ -8,13 +8,33 @@
 #include <SD.h>
 #include "Model1.h"
 #include "M1Shield.h"
+#include "Profiler.h"
+#include "MemoryDiagnostics.h"
 
-const uint8_t VIDEO_COLS = 64;
-const uint8_t VIDEO_ROWS = 16;
-const uint16_t VIDEO_MEM_START = 0x3C00;
+const uint16_t VIDEO_MEM_SIZE = (uint16_t)VIDEO_COLS * VIDEO_ROWS;
 
 const uint8_t SPACE_CHARACTER = 0x20;
 
+// Model 1 character to local character: high bit cleared (no graphics), 0-31 shifted to upper-case
+static const uint8_t MODEL1_TO_LOCAL[256] PROGMEM = {
+  0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+  0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+  0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+  0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+  0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+  0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+  0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+  0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+  0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+  0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+  0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+  0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+};
+
 // Constructor
 Video::Video()
 {
@@ -30,6 +50,18 @@ Video::Video()
   _viewPort.y = 0;
   _viewPort.width = VIDEO_COLS;
   _viewPort.height = VIDEO_ROWS;
+
+  _shadow = nullptr;
+  _clearDirty();
+}
+
+// Destructor
+Video::~Video()
+{
+  if (_shadow)
+  {
+    MemoryDiagnostics.release(_shadow, MEMORY_TAG_VIDEO);
+  }
 }
 
 // Set the logger for debugging output
@@ -45,26 +77,22 @@ void Video::setViewPort(ViewPort viewPort)
   if (viewPort.x >= VIDEO_COLS)
   {
     viewPort.x = VIDEO_COLS - 1;
-    if (_logger)
-      _logger->warnF(F("X coordinate of viewport is larger than there is space. Reset to %d."), viewPort.x);
+    M1_LOG_WARN(_logger, "X coordinate of viewport is larger than there is space. Reset to %d.", viewPort.x);
   }
   if (viewPort.y >= VIDEO_ROWS)
   {
     viewPort.y = VIDEO_ROWS - 1;
-    if (_logger)
-      _logger->warnF(F("Y coordinate of viewport is larger than there is space. Reset to %d."), viewPort.y);
+    M1_LOG_WARN(_logger, "Y coordinate of viewport is larger than there is space. Reset to %d.", viewPort.y);
   }
   if (viewPort.x + viewPort.width > VIDEO_COLS)
   {
     viewPort.width = VIDEO_COLS - viewPort.x;
-    if (_logger)
-      _logger->warnF(F("Width of viewport is larger than there is space. Reset to %d."), viewPort.width);
+    M1_LOG_WARN(_logger, "Width of viewport is larger than there is space. Reset to %d.", viewPort.width);
   }
   if (viewPort.y + viewPort.height > VIDEO_ROWS)
   {
     viewPort.height = VIDEO_ROWS - viewPort.y;
-    if (_logger)
-      _logger->warnF(F("Height of viewport is larger than there is space. Reset to %d."), viewPort.height);
+    M1_LOG_WARN(_logger, "Height of viewport is larger than there is space. Reset to %d.", viewPort.height);
   }
 
   _viewPort = viewPort;
@@ -100,8 +128,7 @@ void Video::setX(uint8_t x)
 {
   if (x > _viewPort.width)
   {
-    if (_logger)
-      _logger->warnF(F("Video: X cursor position %d out of bounds (max %d). Reset to %d."), x, _viewPort.width, _viewPort.width - 1);
+    M1_LOG_WARN(_logger, "Video: X cursor position %d out of bounds (max %d). Reset to %d.", x, _viewPort.width, _viewPort.width - 1);
     _cursorPositionX = _viewPort.width - 1;
   }
   else
@@ -121,8 +148,7 @@ void Video::setY(uint8_t y)
 {
   if (y > _viewPort.height)
   {
-    if (_logger)
-      _logger->warnF(F("Video: Y cursor position %d out of bounds (max %d). Reset to %d."), y, _viewPort.height, _viewPort.height - 1);
+    M1_LOG_WARN(_logger, "Video: Y cursor position %d out of bounds (max %d). Reset to %d.", y, _viewPort.height, _viewPort.height - 1);
     _cursorPositionY = _viewPort.height - 1;
   }
   else
@@ -211,15 +237,13 @@ void Video::cls(char *characters)
 {
   if (!characters)
   {
-    if (_logger)
-      _logger->errF(F("Video: cls() called with null character array"));
+    M1_LOG_ERR(_logger, "Video: cls() called with null character array");
     return;
   }
   uint16_t length = strlen(characters);
   if (length == 0)
   {
-    if (_logger)
-      _logger->warnF(F("Video: cls() called with empty character array"));
+    M1_LOG_WARN(_logger, "Video: cls() called with empty character array");
     return;
   }
   cls(characters, length);
@@ -228,16 +252,16 @@ void Video::cls(char *characters)
 // Clear screen with character array of specified length
 void Video::cls(char *characters, uint16_t length)
 {
+  M1_PROFILE("Video::cls");
+
   if (!characters)
   {
-    if (_logger)
-      _logger->errF(F("Video: cls() called with null character array"));
+    M1_LOG_ERR(_logger, "Video: cls() called with null character array");
     return;
   }
   if (length == 0)
   {
-    if (_logger)
-      _logger->warnF(F("Video: cls() called with length 0"));
+    M1_LOG_WARN(_logger, "Video: cls() called with length 0");
     return;
   }
   int i = 0;
@@ -246,7 +270,7 @@ void Video::cls(char *characters, uint16_t length)
     int rowAddress = getRowAddress(y);
     for (uint16_t x = 0; x < _viewPort.width; x++)
     {
-      Model1.writeMemory(getColumnAddress(rowAddress, x), convertLocalCharacterToModel1(characters[i % length]));
+      _writeCharacter(getColumnAddress(rowAddress, x), convertLocalCharacterToModel1(characters[i % length]));
       i++;
     }
   }
@@ -263,44 +287,74 @@ void Video::scroll()
 // Scroll screen up by specified number of rows
 void Video::scroll(uint8_t rows)
 {
+  M1_PROFILE("Video::scroll");
+
   if (rows == 0)
   {
-    if (_logger)
-      _logger->warnF(F("Video: Scroll called with 0 rows - no action taken"));
+    M1_LOG_WARN(_logger, "Video: Scroll called with 0 rows - no action taken");
     return;
   }
 
   // Validate viewport height is reasonable
   if (_viewPort.height == 0)
   {
-    if (_logger)
-      _logger->warnF(F("Video: Scroll called with viewport height 0 - no action taken"));
+    M1_LOG_WARN(_logger, "Video: Scroll called with viewport height 0 - no action taken");
     return;
   }
 
   // If there are more rows than available, just cap it at the maximum number of rows
   if (rows > _viewPort.height)
   {
-    if (_logger)
-      _logger->infoF(F("Video: Scroll rows %d exceeds viewport height %d. Capped to %d."), rows, _viewPort.height, _viewPort.height);
+    M1_LOG_INFO(_logger, "Video: Scroll rows %d exceeds viewport height %d. Capped to %d.", rows, _viewPort.height, _viewPort.height);
     rows = _viewPort.height;
   }
 
-  // Only copy if not the whole memory gets replaced with spaces anyways
-  if (rows < _viewPort.height)
+  if (_shadow)
   {
+    // Move the rows within the shadow buffer; only characters that change become dirty
     for (uint16_t y = rows; y < _viewPort.height; y++)
     {
       uint16_t src = getColumnAddress(getRowAddress(y), 0);
       uint16_t dst = getColumnAddress(getRowAddress(y - rows), 0);
-      Model1.copyMemory(src, dst, _viewPort.width);
+      for (uint8_t x = 0; x < _viewPort.width; x++)
+      {
+        _writeCharacter(dst + x, _shadow[src - VIDEO_MEM_START + x]);
+      }
+    }
+    for (uint8_t y = _viewPort.height - rows; y < _viewPort.height; y++)
+    {
+      uint16_t dst = getColumnAddress(getRowAddress(y), 0);
+      for (uint8_t x = 0; x < _viewPort.width; x++)
+      {
+        _writeCharacter(dst + x, SPACE_CHARACTER);
+      }
     }
   }
-
-  // Fill the bottom rows with spaces
-  for (uint8_t y = _viewPort.height - rows; y < _viewPort.height; y++)
+  else if (_viewPort.width == VIDEO_COLS)
   {
-    Model1.fillMemory(SPACE_CHARACTER, getColumnAddress(getRowAddress(y), 0), _viewPort.width);
+    // Full-width rows are contiguous, so the kept rows move as one block
+    uint16_t keep = (uint16_t)(_viewPort.height - rows) * VIDEO_COLS;
+    if (keep > 0)
+    {
+      _moveCharacters(getRowAddress(rows), getRowAddress(0), keep);
+    }
+    Model1.fillMemory(SPACE_CHARACTER, getRowAddress(_viewPort.height - rows), (uint16_t)rows * VIDEO_COLS);
+  }
+  else
+  {
+    // Only copy if not the whole memory gets replaced with spaces anyways
+    for (uint16_t y = rows; y < _viewPort.height; y++)
+    {
+      uint16_t src = getColumnAddress(getRowAddress(y), 0);
+      uint16_t dst = getColumnAddress(getRowAddress(y - rows), 0);
+      _moveCharacters(src, dst, _viewPort.width);
+    }
+
+    // Fill the bottom rows with spaces
+    for (uint8_t y = _viewPort.height - rows; y < _viewPort.height; y++)
+    {
+      Model1.fillMemory(SPACE_CHARACTER, getColumnAddress(getRowAddress(y), 0), _viewPort.width);
+    }
   }
 
   // Move the current cursor position up by the number of scrolled rows
@@ -314,53 +368,74 @@ void Video::scroll(uint8_t rows)
   }
 }
 
-// Read a block of characters from the screen
+// Move characters with a burst read and a burst write per buffer; copying forward is safe as dst is below src
+void Video::_moveCharacters(uint16_t src, uint16_t dst, uint16_t length)
+{
+  uint8_t buffer[VIDEO_SCROLL_BUFFER_SIZE];
+  while (length > 0)
+  {
+    uint16_t count = length < VIDEO_SCROLL_BUFFER_SIZE ? length : VIDEO_SCROLL_BUFFER_SIZE;
+    Model1.readMemoryInto(src, buffer, count);
+    Model1.writeMemoryFrom(dst, buffer, count);
+    src += count;
+    dst += count;
+    length -= count;
+  }
+}
+
+// Read a block of characters from the screen into a new buffer the caller frees
 char *Video::read(uint8_t x, uint8_t y, uint16_t length, bool raw)
 {
-  uint8_t *buffer = (uint8_t *)malloc((length + 1) * sizeof(uint8_t));
+  char *buffer = (char *)malloc((length + 1) * sizeof(char));
   if (!buffer)
   {
-    if (_logger)
-    {
-      _logger->errF(F("Video: Failed to allocate memory for read buffer"));
-    }
+    M1_LOG_ERR(_logger, "Video: Failed to allocate memory for read buffer");
     return nullptr;
   }
 
   // Make sure this is filled with zeros in case the area is shorter than length
-  for (uint16_t i = 0; i < length + 1; i++)
+  memset(buffer, 0, length + 1);
+  readInto(x, y, buffer, length, raw);
+
+  return buffer;
+}
+
+// Read a block of characters into a caller buffer of length + 1 bytes, one burst per row segment
+uint16_t Video::readInto(uint8_t x, uint8_t y, char *buffer, uint16_t length, bool raw)
+{
+  if (!buffer)
   {
-    buffer[i] = 0;
+    M1_LOG_ERR(_logger, "Video: readInto() called with null buffer");
+    return 0;
   }
 
-  // Read in string
-  for (uint16_t i = 0; i < length; i++)
+  uint8_t *data = (uint8_t *)buffer;
+  uint16_t address = getAddress(x, y);
+  uint16_t i = 0;
+  while (i < length && x < _viewPort.width && y < _viewPort.height)
   {
-    uint16_t addr = getColumnAddress(getRowAddress(y), x);
-    uint8_t character = Model1.readMemory(addr);
+    uint16_t count = _viewPort.width - x;
+    if (count > length - i)
+      count = length - i;
 
-    if (raw)
-    {
-      buffer[i] = character;
-    }
-    else
-    {
-      buffer[i] = convertModel1CharacterToLocal(character);
-    }
+    _readCharacters(address, data + i, count);
 
-    x++;
-    if (x >= _viewPort.width)
+    if (!raw)
     {
-      x = 0;
-      y++;
-      if (y >= _viewPort.height)
+      for (uint16_t j = i; j < i + count; j++)
       {
-        break; // Prevent reading out of bounds
+        data[j] = pgm_read_byte(&MODEL1_TO_LOCAL[data[j]]);
       }
     }
+
+    i += count;
+    address += VIDEO_COLS - x; // Start of the viewport in the next row
+    x = 0;
+    y++;
   }
 
-  return (char *)buffer;
+  data[i] = '\0';
+  return i;
 }
 
 // Write a single character to the screen
@@ -375,14 +450,12 @@ size_t Video::write(const uint8_t *buffer, size_t size)
 {
   if (!buffer)
   {
-    if (_logger)
-      _logger->errF(F("Video: write() called with null buffer"));
+    M1_LOG_ERR(_logger, "Video: write() called with null buffer");
     return 0;
   }
   if (size == 0)
   {
-    if (_logger)
-      _logger->warnF(F("Video: write() called with length 0"));
+    M1_LOG_WARN(_logger, "Video: write() called with length 0");
     return 0; // Not an error, just nothing to write
   }
   size_t result = 0;
@@ -434,7 +507,7 @@ void Video::_print(const char character, bool raw)
     {
       data = convertLocalCharacterToModel1(character);
     }
-    Model1.writeMemory(address, data);
+    _writeCharacter(address, data);
     _cursorPositionX++;
   }
 
@@ -464,8 +537,7 @@ void Video::print(uint8_t x, uint8_t y, const char *str)
 {
   if (!str)
   {
-    if (_logger)
-      _logger->errF(F("Video: print() called with null string"));
+    M1_LOG_ERR(_logger, "Video: print() called with null string");
     return;
   }
   uint16_t length = strlen(str);
@@ -478,20 +550,409 @@ void Video::print(uint8_t x, uint8_t y, const char *str, uint16_t length)
 {
   if (!str)
   {
-    if (_logger)
-      _logger->errF(F("Video: print() called with null string"));
+    M1_LOG_ERR(_logger, "Video: print() called with null string");
     return;
   }
   if (length == 0)
   {
-    if (_logger)
-      _logger->warnF(F("Video: print() called with length 0"));
+    M1_LOG_WARN(_logger, "Video: print() called with length 0");
     return;
   }
   setXY(x, y);
   write((const uint8_t *)str, length);
 }
 
+// ----------------------------------------
+// ---------- Shadow buffer
+// ----------------------------------------
+
+// Allocate the shadow buffer and fill it from video RAM; needs the bus (TEST* active)
+bool Video::enableShadow()
+{
+  if (_shadow)
+  {
+    return true;
+  }
+
+  _shadow = (uint8_t *)MemoryDiagnostics.allocate(VIDEO_MEM_SIZE, MEMORY_TAG_VIDEO);
+  if (!_shadow)
+  {
+    M1_LOG_ERR(_logger, "Video: Not enough memory for the shadow buffer");
+    return false;
+  }
+
+  reloadShadow();
+  return true;
+}
+
+// Write pending changes and go back to writing video RAM directly
+void Video::disableShadow()
+{
+  if (!_shadow)
+  {
+    return;
+  }
+
+  flush();
+  MemoryDiagnostics.release(_shadow, MEMORY_TAG_VIDEO);
+  _shadow = nullptr;
+}
+
+// True if a shadow buffer is used
+bool Video::hasShadow()
+{
+  return _shadow != nullptr;
+}
+
+// Read video RAM in one burst; needed when the Z80 changed the screen
+void Video::reloadShadow()
+{
+  if (!_shadow)
+  {
+    return;
+  }
+
+  Model1.readMemoryInto(VIDEO_MEM_START, _shadow, VIDEO_MEM_SIZE);
+  _clearDirty();
+}
+
+// True if the shadow buffer has unflushed changes
+bool Video::isDirty()
+{
+  for (uint8_t row = 0; row < VIDEO_ROWS; row++)
+  {
+    if (_dirtyEnd[row] != 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Write the dirty spans in bursts; spans closer than VIDEO_SHADOW_MERGE_GAP share one burst
+void Video::flush()
+{
+  if (!_shadow)
+  {
+    return;
+  }
+
+  M1_PROFILE("Video::flush");
+
+  uint16_t runStart = 0;
+  uint16_t runEnd = 0; // Offset after the run, 0 while there is no run
+  for (uint8_t row = 0; row < VIDEO_ROWS; row++)
+  {
+    if (_dirtyEnd[row] == 0)
+    {
+      continue;
+    }
+
+    uint16_t start = row * VIDEO_COLS + _dirtyStart[row];
+    uint16_t end = row * VIDEO_COLS + _dirtyEnd[row];
+    if (runEnd != 0 && start - runEnd <= VIDEO_SHADOW_MERGE_GAP)
+    {
+      runEnd = end;
+      continue;
+    }
+
+    if (runEnd != 0)
+    {
+      Model1.writeMemory(VIDEO_MEM_START + runStart, _shadow + runStart, runEnd - runStart);
+    }
+    runStart = start;
+    runEnd = end;
+  }
+
+  if (runEnd != 0)
+  {
+    Model1.writeMemory(VIDEO_MEM_START + runStart, _shadow + runStart, runEnd - runStart);
+  }
+
+  _clearDirty();
+}
+
+// Mark all rows as flushed
+void Video::_clearDirty()
+{
+  memset(_dirtyStart, 0, sizeof(_dirtyStart));
+  memset(_dirtyEnd, 0, sizeof(_dirtyEnd));
+}
+
+// Write a character to the shadow buffer and extend the dirty span of its row, or to video RAM without shadow
+void Video::_writeCharacter(uint16_t address, uint8_t data)
+{
+  if (!_shadow)
+  {
+    Model1.writeMemory(address, data);
+    return;
+  }
+
+  uint16_t offset = address - VIDEO_MEM_START;
+  if (_shadow[offset] == data)
+  {
+    return; // Unchanged characters are not written again
+  }
+  _shadow[offset] = data;
+
+  uint8_t row = offset / VIDEO_COLS;
+  uint8_t column = offset % VIDEO_COLS;
+  if (_dirtyEnd[row] == 0)
+  {
+    _dirtyStart[row] = column;
+    _dirtyEnd[row] = column + 1;
+  }
+  else if (column < _dirtyStart[row])
+  {
+    _dirtyStart[row] = column;
+  }
+  else if (column >= _dirtyEnd[row])
+  {
+    _dirtyEnd[row] = column + 1;
+  }
+}
+
+// Read one character from the shadow buffer, or from video RAM without shadow
+uint8_t Video::_readCharacter(uint16_t address)
+{
+  if (_shadow)
+  {
+    return _shadow[address - VIDEO_MEM_START];
+  }
+  return Model1.readMemory(address);
+}
+
+// Read characters from the shadow buffer, or from video RAM without shadow
+void Video::_readCharacters(uint16_t address, uint8_t *buffer, uint16_t length)
+{
+  if (_shadow)
+  {
+    memcpy(buffer, _shadow + (address - VIDEO_MEM_START), length);
+  }
+  else
+  {
+    Model1.readMemoryInto(address, buffer, length);
+  }
+}
+
+// ----------------------------------------
+// ---------- Semigraphics
+// ----------------------------------------
+
+// Viewport width in semigraphics pixels
+uint8_t Video::getGraphicsWidth()
+{
+  return _viewPort.width * 2;
+}
+
+// Viewport height in semigraphics pixels
+uint8_t Video::getGraphicsHeight()
+{
+  return _viewPort.height * 3;
+}
+
+// Turn a pixel on; a text character in its cell is replaced by an empty block first
+void Video::setPixel(uint8_t x, uint8_t y)
+{
+  _plot(x, y, true);
+}
+
+// Turn a pixel off
+void Video::resetPixel(uint8_t x, uint8_t y)
+{
+  _plot(x, y, false);
+}
+
+// True if the cell holds a semigraphics character with the pixel on
+bool Video::getPixel(uint8_t x, uint8_t y)
+{
+  if (x >= getGraphicsWidth() || y >= getGraphicsHeight())
+  {
+    return false;
+  }
+
+  uint8_t data = _readCharacter(getAddress(x / 2, y / 3));
+  return (data & 0x80) && (data & (1 << ((y % 3) * 2 + (x % 2))));
+}
+
+// Draw a line with Bresenham's algorithm; parts outside the viewport are skipped
+void Video::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, bool on)
+{
+  M1_PROFILE("Video::drawLine");
+
+  int16_t dx = abs(x1 - x0);
+  int16_t dy = -abs(y1 - y0);
+  int8_t sx = x0 < x1 ? 1 : -1;
+  int8_t sy = y0 < y1 ? 1 : -1;
+  int16_t error = dx + dy;
+
+  while (true)
+  {
+    _plot(x0, y0, on);
+    if (x0 == x1 && y0 == y1)
+    {
+      break;
+    }
+
+    int16_t error2 = 2 * error;
+    if (error2 >= dy)
+    {
+      error += dy;
+      x0 += sx;
+    }
+    if (error2 <= dx)
+    {
+      error += dx;
+      y0 += sy;
+    }
+  }
+}
+
+// Draw the outline of a rectangle
+void Video::drawRect(int16_t x, int16_t y, uint8_t width, uint8_t height, bool on)
+{
+  if (width == 0 || height == 0)
+  {
+    return;
+  }
+
+  int16_t right = x + width - 1;
+  int16_t bottom = y + height - 1;
+  drawLine(x, y, right, y, on);
+  drawLine(x, bottom, right, bottom, on);
+  drawLine(x, y, x, bottom, on);
+  drawLine(right, y, right, bottom, on);
+}
+
+// Fill a rectangle, composing the pixels of each cell so every cell is read and written once
+void Video::fillRect(int16_t x, int16_t y, uint8_t width, uint8_t height, bool on)
+{
+  M1_PROFILE("Video::fillRect");
+
+  // Clip to the viewport; right and bottom are exclusive
+  int16_t left = max(x, (int16_t)0);
+  int16_t top = max(y, (int16_t)0);
+  int16_t right = min((int16_t)(x + width), (int16_t)getGraphicsWidth());
+  int16_t bottom = min((int16_t)(y + height), (int16_t)getGraphicsHeight());
+  if (left >= right || top >= bottom)
+  {
+    return;
+  }
+
+  for (uint8_t row = top / 3; row <= (bottom - 1) / 3; row++)
+  {
+    for (uint8_t column = left / 2; column <= (right - 1) / 2; column++)
+    {
+      uint8_t mask = 0;
+      for (uint8_t i = 0; i < 6; i++)
+      {
+        int16_t pixelX = column * 2 + i % 2;
+        int16_t pixelY = row * 3 + i / 2;
+        if (pixelX >= left && pixelX < right && pixelY >= top && pixelY < bottom)
+        {
+          mask |= 1 << i;
+        }
+      }
+      _plotCell(column, row, mask, on ? mask : 0);
+    }
+  }
+}
+
+// Copy a bitmap from SRAM; rows of (width + 7) / 8 bytes, most significant bit first
+void Video::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, bool transparent)
+{
+  _drawBitmap(x, y, bitmap, width, height, transparent, false);
+}
+
+// Copy a bitmap from program memory (PROGMEM)
+void Video::drawBitmapPGM(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, bool transparent)
+{
+  _drawBitmap(x, y, bitmap, width, height, transparent, true);
+}
+
+// Set the pixels of set bits; clear bits reset their pixels unless transparent
+// The pixels of each cell are composed first, so every cell is read and written once
+void Video::_drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, bool transparent, bool progmem)
+{
+  M1_PROFILE("Video::drawBitmap");
+
+  if (!bitmap)
+  {
+    M1_LOG_ERR(_logger, "Video: drawBitmap() called with null bitmap");
+    return;
+  }
+
+  // Clip to the viewport; right and bottom are exclusive
+  int16_t left = max(x, (int16_t)0);
+  int16_t top = max(y, (int16_t)0);
+  int16_t right = min((int16_t)(x + width), (int16_t)getGraphicsWidth());
+  int16_t bottom = min((int16_t)(y + height), (int16_t)getGraphicsHeight());
+  if (left >= right || top >= bottom)
+  {
+    return;
+  }
+
+  uint8_t bytesPerRow = (width + 7) / 8;
+  for (uint8_t row = top / 3; row <= (bottom - 1) / 3; row++)
+  {
+    for (uint8_t column = left / 2; column <= (right - 1) / 2; column++)
+    {
+      uint8_t mask = 0;
+      uint8_t bits = 0;
+      for (uint8_t i = 0; i < 6; i++)
+      {
+        int16_t pixelX = column * 2 + i % 2;
+        int16_t pixelY = row * 3 + i / 2;
+        if (pixelX < left || pixelX >= right || pixelY < top || pixelY >= bottom)
+        {
+          continue;
+        }
+
+        uint8_t bitmapX = pixelX - x;
+        const uint8_t *data = bitmap + (pixelY - y) * bytesPerRow + bitmapX / 8;
+        bool on = (progmem ? pgm_read_byte(data) : *data) & (0x80 >> (bitmapX % 8));
+        if (on || !transparent)
+        {
+          mask |= 1 << i;
+          bits |= on ? (1 << i) : 0;
+        }
+      }
+      if (mask)
+      {
+        _plotCell(column, row, mask, bits);
+      }
+    }
+  }
+}
+
+// Set or reset a single pixel
+void Video::_plot(int16_t x, int16_t y, bool on)
+{
+  if (x < 0 || y < 0 || x >= getGraphicsWidth() || y >= getGraphicsHeight())
+  {
+    return;
+  }
+
+  uint8_t bit = 1 << ((y % 3) * 2 + (x % 2));
+  _plotCell(x / 2, y / 3, bit, on ? bit : 0);
+}
+
+// Read-modify-write of a semigraphics character: the pixels in mask take their values from bits
+void Video::_plotCell(uint8_t column, uint8_t row, uint8_t mask, uint8_t bits)
+{
+  uint16_t address = getAddress(column, row);
+  uint8_t original = _readCharacter(address);
+
+  // Text becomes an empty block; bit 6 is not part of a semigraphics character
+  uint8_t data = (original & 0x80) ? (original & 0xBF) : 0x80;
+
+  data = (data & ~mask) | bits;
+  if (data != original)
+  {
+    _writeCharacter(address, data);
+  }
+}
+
 // Set auto scroll mode
 void Video::setAutoScroll(bool autoScroll)
 {
@@ -507,18 +968,18 @@ void Video::setLowerCaseMod(bool hasLowerCaseMod)
 // Capture current viewport to SD card file
 bool Video::captureToSD(const char *filename, bool useLocalCharacterSet)
 {
+  M1_PROFILE("Video::captureToSD");
+
   if (!filename)
   {
-    if (_logger)
-      _logger->errF(F("Video: captureToSD() called with null filename"));
+    M1_LOG_ERR(_logger, "Video: captureToSD() called with null filename");
     return false;
   }
 
   // Initialize SD card if not already done
   if (!SD.begin(M1Shield.getSDCardSelectPin()))
   {
-    if (_logger)
-      _logger->errF(F("Video: Failed to initialize SD card"));
+    M1_LOG_ERR(_logger, "Video: Failed to initialize SD card");
     return false;
   }
 
@@ -529,13 +990,11 @@ bool Video::captureToSD(const char *filename, bool useLocalCharacterSet)
   File videoFile = SD.open(filename, FILE_WRITE);
   if (!videoFile)
   {
-    if (_logger)
-      _logger->errF(F("Video: Failed to open file %s for writing"), filename);
+    M1_LOG_ERR(_logger, "Video: Failed to open file %s for writing", filename);
     return false;
   }
 
-  if (_logger)
-    _logger->infoF(F("Video: Capturing viewport to %s"), filename);
+  M1_LOG_INFO(_logger, "Video: Capturing viewport to %s", filename);
 
   // If file existed before, add an empty line separator
   if (fileExists)
@@ -544,33 +1003,29 @@ bool Video::captureToSD(const char *filename, bool useLocalCharacterSet)
   }
 
   // Capture the viewport area
+  char rowBuffer[VIDEO_COLS + 1];
   for (uint8_t row = 0; row < _viewPort.height; row++)
   {
-    for (uint8_t col = 0; col < _viewPort.width; col++)
-    {
-      uint16_t address = getAddress(col, row);
-      uint8_t character = Model1.readMemory(address);
+    uint16_t count = readInto(0, row, rowBuffer, _viewPort.width, !useLocalCharacterSet);
 
-      if (useLocalCharacterSet)
-      {
-        character = convertModel1CharacterToLocal(character);
-      }
+    for (uint16_t col = 0; col < count; col++)
+    {
+      uint8_t character = rowBuffer[col];
 
       // Replace null characters and non-printable characters with spaces for readability
       if (character == 0 || (character < 32 && character != '\t' && character != '\n'))
       {
-        character = ' ';
+        rowBuffer[col] = ' ';
       }
-
-      videoFile.write(character);
     }
+
+    videoFile.write((const uint8_t *)rowBuffer, count);
     videoFile.println(); // Add newline at end of each row
   }
 
   videoFile.close();
 
-  if (_logger)
-    _logger->infoF(F("Video: Successfully captured viewport to %s"), filename);
+  M1_LOG_INFO(_logger, "Video: Successfully captured viewport to %s", filename);
 
   return true;
 }
@@ -578,22 +1033,21 @@ bool Video::captureToSD(const char *filename, bool useLocalCharacterSet)
 // Convert a character from Model 1 to local representation
 char Video::convertModel1CharacterToLocal(char character)
 {
-  character &= 0x7F; // Clear the high bit - No graphics support
-
-  if (character >= 0 && character < 32)
-  {
-    character += 64; // Shift to real upper-case
-  }
-
-  return character;
+  return (char)pgm_read_byte(&MODEL1_TO_LOCAL[(uint8_t)character]);
 }
 
 // Convert a character from local representation to Model 1
 char Video::convertLocalCharacterToModel1(char character)
+{
+  return convertLocalCharacterToModel1(character, _hasLowerCaseMod);
+}
+
+// Convert a character from local representation to Model 1 for a given lowercase setup
+char Video::convertLocalCharacterToModel1(char character, bool hasLowerCaseMod)
 {
   character &= 0x7F; // Clear the high bit - No graphics support
 
-  if (!_hasLowerCaseMod && (character >= 96 && character < 128))
+  if (!hasLowerCaseMod && character >= 96)
   {
     character -= 32; // Shift to upper-case
   }
@@ -12,6 +12,20 @@
 #include "Model1.h"
 #include <Print.h>
 
+const uint8_t VIDEO_COLS = 64;
+const uint8_t VIDEO_ROWS = 16;
+const uint16_t VIDEO_MEM_START = 0x3C00;
+
+// Unchanged characters between two dirty spans that flush() writes along instead of starting another burst
+#ifndef VIDEO_SHADOW_MERGE_GAP
+#define VIDEO_SHADOW_MERGE_GAP 8
+#endif
+
+// Bytes scroll() moves per burst read and write (buffer on the stack)
+#ifndef VIDEO_SCROLL_BUFFER_SIZE
+#define VIDEO_SCROLL_BUFFER_SIZE 64
+#endif
+
 /**
  * Structure for the viewport information
  */
@@ -34,10 +48,27 @@ private:
   bool _autoScroll;         // Enable automatic scrolling when cursor reaches bottom
   bool _hasLowerCaseMod;    // True if lowercase modification is available
 
-  void _print(const char character, bool raw); // Internal character printing with raw mode option
+  uint8_t *_shadow;                // Copy of the whole video RAM, nullptr without shadow buffer
+  uint8_t _dirtyStart[VIDEO_ROWS]; // First changed column per row
+  uint8_t _dirtyEnd[VIDEO_ROWS];   // Column after the last change per row, 0 if the row is clean
+
+  void _print(const char character, bool raw);                              // Internal character printing with raw mode option
+  void _writeCharacter(uint16_t address, uint8_t data);                     // Write to the shadow buffer or straight to video RAM
+  void _readCharacters(uint16_t address, uint8_t *buffer, uint16_t length); // Read from the shadow buffer or video RAM
+  void _clearDirty();                                                       // Mark all rows as flushed
+  void _moveCharacters(uint16_t src, uint16_t dst, uint16_t length);        // Move video RAM towards lower addresses in bursts
+  uint8_t _readCharacter(uint16_t address);                                 // Read one character from the shadow buffer or video RAM
+  void _plot(int16_t x, int16_t y, bool on);                                // Set or reset a pixel, ignoring pixels outside the viewport
+  void _plotCell(uint8_t column, uint8_t row, uint8_t mask, uint8_t bits);  // Replace the masked pixels of a cell with one read and one write
+
+  void _drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, bool transparent, bool progmem); // Copy a bitmap from SRAM or flash
 
 public:
-  Video(); // Constructor
+  Video();  // Constructor
+  ~Video(); // Destructor
+
+  Video(const Video &) = delete;            // Disable copy constructor - the shadow buffer is owned by one instance
+  Video &operator=(const Video &) = delete; // Disable copy assignment - the shadow buffer is owned by one instance
 
   void setLogger(ILogger &logger);     // Set logger for debugging output
   void setViewPort(ViewPort viewPort); // Set viewport boundaries for video operations
@@ -75,7 +106,8 @@ public:
   void scroll();             // Scroll screen up by one row
   void scroll(uint8_t rows); // Scroll screen up by specified number of rows
 
-  char *read(uint8_t x, uint8_t y, uint16_t length, bool raw); // Read characters from screen at specified position and length
+  char *read(uint8_t x, uint8_t y, uint16_t length, bool raw);                     // Read characters from screen into a new buffer the caller frees
+  uint16_t readInto(uint8_t x, uint8_t y, char *buffer, uint16_t length, bool raw); // Read characters into a caller buffer of length + 1 bytes
 
   size_t write(uint8_t ch) override;                         // Write single character (Print interface)
   size_t write(const uint8_t *buffer, size_t size) override; // Write buffer of characters (Print interface)
@@ -84,6 +116,26 @@ public:
   void print(uint8_t x, uint8_t y, const char *str);                  // Print string at specified position
   void print(uint8_t x, uint8_t y, const char *str, uint16_t length); // Print string at specified position with length limit
 
+  bool enableShadow();  // Keep a copy of video RAM in SRAM; changes reach the screen with flush()
+  void disableShadow(); // Flush and free the shadow buffer
+  bool hasShadow();     // True if a shadow buffer is used
+  void reloadShadow();  // Read video RAM into the shadow buffer again, dropping unflushed changes
+  bool isDirty();       // True if the shadow buffer has unflushed changes
+  void flush();         // Write the changed spans of the shadow buffer in bursts
+
+  uint8_t getGraphicsWidth();  // Viewport width in semigraphics pixels (2 per character)
+  uint8_t getGraphicsHeight(); // Viewport height in semigraphics pixels (3 per character)
+
+  void setPixel(uint8_t x, uint8_t y);   // Turn a semigraphics pixel on (BASIC SET)
+  void resetPixel(uint8_t x, uint8_t y); // Turn a semigraphics pixel off (BASIC RESET)
+  bool getPixel(uint8_t x, uint8_t y);   // True if a semigraphics pixel is on (BASIC POINT)
+
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, bool on = true);                                          // Draw a line of pixels
+  void drawRect(int16_t x, int16_t y, uint8_t width, uint8_t height, bool on = true);                                     // Draw the outline of a rectangle
+  void fillRect(int16_t x, int16_t y, uint8_t width, uint8_t height, bool on = true);                                     // Fill a rectangle, one write per cell
+  void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, bool transparent = false);    // Copy a bitmap from SRAM, rows MSB first, one write per cell
+  void drawBitmapPGM(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, bool transparent = false); // Copy a bitmap from program memory (PROGMEM), one write per cell
+
   void setAutoScroll(bool autoScroll);        // Enable or disable automatic scrolling
   void setLowerCaseMod(bool hasLowerCaseMod); // Set whether lowercase modification is available
 
@@ -91,6 +143,7 @@ public:
 
   char convertModel1CharacterToLocal(char character); // Convert TRS-80 character to local character
   char convertLocalCharacterToModel1(char character); // Convert local character to TRS-80 character
+  static char convertLocalCharacterToModel1(char character, bool hasLowerCaseMod); // Convert local character to TRS-80 character for a given lowercase setup
 
   using Print::print;
   using Print::println;
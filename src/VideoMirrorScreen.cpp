@@ -0,0 +1,460 @@
+/*
+ * VideoMirrorScreen.cpp - ContentScreen mirroring the Model 1 text screen onto the shield display
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "VideoMirrorScreen.h"
+#include "M1Shield.h"
+#include "Model1.h"
+#include "MemoryDiagnostics.h"
+#include "Profiler.h"
+
+#define VIDEO_MIRROR_GLYPHS 96          // Text glyphs 0x20-0x7F
+#define VIDEO_MIRROR_MAX_CELL_WIDTH 8   // Per column in 64 character mode, doubled in 32 character mode
+#define VIDEO_MIRROR_MAX_CELL_HEIGHT 24 // Per row
+#define VIDEO_MIRROR_MIN_CELL_WIDTH 2   // Smallest cell that shows the semigraphics blocks
+#define VIDEO_MIRROR_MIN_CELL_HEIGHT 3  // Smallest cell that shows the semigraphics blocks
+
+#define VIDEO_MIRROR_SOURCE_WIDTH 6   // Dots per character on the Model 1
+#define VIDEO_MIRROR_SOURCE_HEIGHT 12 // Lines per character on the Model 1
+
+#define VIDEO_MIRROR_COLOR_FG 0xFFFF
+#define VIDEO_MIRROR_COLOR_BG 0x0000
+
+// 5x7 glyphs of the Model 1 character set, one byte per column with the top line in bit 0
+static const uint8_t VIDEO_MIRROR_FONT[VIDEO_MIRROR_GLYPHS * 5] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, // 0x20 space
+    0x00, 0x00, 0x5F, 0x00, 0x00, // 0x21 !
+    0x00, 0x07, 0x00, 0x07, 0x00, // 0x22 "
+    0x14, 0x7F, 0x14, 0x7F, 0x14, // 0x23 #
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, // 0x24 $
+    0x23, 0x13, 0x08, 0x64, 0x62, // 0x25 %
+    0x36, 0x49, 0x55, 0x22, 0x50, // 0x26 &
+    0x00, 0x05, 0x03, 0x00, 0x00, // 0x27 '
+    0x00, 0x1C, 0x22, 0x41, 0x00, // 0x28 (
+    0x00, 0x41, 0x22, 0x1C, 0x00, // 0x29 )
+    0x14, 0x08, 0x3E, 0x08, 0x14, // 0x2A *
+    0x08, 0x08, 0x3E, 0x08, 0x08, // 0x2B +
+    0x00, 0x50, 0x30, 0x00, 0x00, // 0x2C ,
+    0x08, 0x08, 0x08, 0x08, 0x08, // 0x2D -
+    0x00, 0x60, 0x60, 0x00, 0x00, // 0x2E .
+    0x20, 0x10, 0x08, 0x04, 0x02, // 0x2F /
+    0x3E, 0x51, 0x49, 0x45, 0x3E, // 0x30 0
+    0x00, 0x42, 0x7F, 0x40, 0x00, // 0x31 1
+    0x42, 0x61, 0x51, 0x49, 0x46, // 0x32 2
+    0x21, 0x41, 0x45, 0x4B, 0x31, // 0x33 3
+    0x18, 0x14, 0x12, 0x7F, 0x10, // 0x34 4
+    0x27, 0x45, 0x45, 0x45, 0x39, // 0x35 5
+    0x3C, 0x4A, 0x49, 0x49, 0x30, // 0x36 6
+    0x01, 0x71, 0x09, 0x05, 0x03, // 0x37 7
+    0x36, 0x49, 0x49, 0x49, 0x36, // 0x38 8
+    0x06, 0x49, 0x49, 0x29, 0x1E, // 0x39 9
+    0x00, 0x36, 0x36, 0x00, 0x00, // 0x3A :
+    0x00, 0x56, 0x36, 0x00, 0x00, // 0x3B ;
+    0x08, 0x14, 0x22, 0x41, 0x00, // 0x3C <
+    0x14, 0x14, 0x14, 0x14, 0x14, // 0x3D =
+    0x00, 0x41, 0x22, 0x14, 0x08, // 0x3E >
+    0x02, 0x01, 0x51, 0x09, 0x06, // 0x3F ?
+    0x32, 0x49, 0x79, 0x41, 0x3E, // 0x40 @
+    0x7E, 0x11, 0x11, 0x11, 0x7E, // 0x41 A
+    0x7F, 0x49, 0x49, 0x49, 0x36, // 0x42 B
+    0x3E, 0x41, 0x41, 0x41, 0x22, // 0x43 C
+    0x7F, 0x41, 0x41, 0x22, 0x1C, // 0x44 D
+    0x7F, 0x49, 0x49, 0x49, 0x41, // 0x45 E
+    0x7F, 0x09, 0x09, 0x09, 0x01, // 0x46 F
+    0x3E, 0x41, 0x49, 0x49, 0x7A, // 0x47 G
+    0x7F, 0x08, 0x08, 0x08, 0x7F, // 0x48 H
+    0x00, 0x41, 0x7F, 0x41, 0x00, // 0x49 I
+    0x20, 0x40, 0x41, 0x3F, 0x01, // 0x4A J
+    0x7F, 0x08, 0x14, 0x22, 0x41, // 0x4B K
+    0x7F, 0x40, 0x40, 0x40, 0x40, // 0x4C L
+    0x7F, 0x02, 0x0C, 0x02, 0x7F, // 0x4D M
+    0x7F, 0x04, 0x08, 0x10, 0x7F, // 0x4E N
+    0x3E, 0x41, 0x41, 0x41, 0x3E, // 0x4F O
+    0x7F, 0x09, 0x09, 0x09, 0x06, // 0x50 P
+    0x3E, 0x41, 0x51, 0x21, 0x5E, // 0x51 Q
+    0x7F, 0x09, 0x19, 0x29, 0x46, // 0x52 R
+    0x46, 0x49, 0x49, 0x49, 0x31, // 0x53 S
+    0x01, 0x01, 0x7F, 0x01, 0x01, // 0x54 T
+    0x3F, 0x40, 0x40, 0x40, 0x3F, // 0x55 U
+    0x1F, 0x20, 0x40, 0x20, 0x1F, // 0x56 V
+    0x3F, 0x40, 0x38, 0x40, 0x3F, // 0x57 W
+    0x63, 0x14, 0x08, 0x14, 0x63, // 0x58 X
+    0x07, 0x08, 0x70, 0x08, 0x07, // 0x59 Y
+    0x61, 0x51, 0x49, 0x45, 0x43, // 0x5A Z
+    0x04, 0x02, 0x7F, 0x02, 0x04, // 0x5B up arrow
+    0x10, 0x20, 0x7F, 0x20, 0x10, // 0x5C down arrow
+    0x08, 0x1C, 0x2A, 0x08, 0x08, // 0x5D left arrow
+    0x08, 0x08, 0x2A, 0x1C, 0x08, // 0x5E right arrow
+    0x40, 0x40, 0x40, 0x40, 0x40, // 0x5F _
+    0x00, 0x01, 0x02, 0x04, 0x00, // 0x60 `
+    0x20, 0x54, 0x54, 0x54, 0x78, // 0x61 a
+    0x7F, 0x48, 0x44, 0x44, 0x38, // 0x62 b
+    0x38, 0x44, 0x44, 0x44, 0x20, // 0x63 c
+    0x38, 0x44, 0x44, 0x48, 0x7F, // 0x64 d
+    0x38, 0x54, 0x54, 0x54, 0x18, // 0x65 e
+    0x08, 0x7E, 0x09, 0x01, 0x02, // 0x66 f
+    0x0C, 0x52, 0x52, 0x52, 0x3E, // 0x67 g
+    0x7F, 0x08, 0x04, 0x04, 0x78, // 0x68 h
+    0x00, 0x44, 0x7D, 0x40, 0x00, // 0x69 i
+    0x20, 0x40, 0x44, 0x3D, 0x00, // 0x6A j
+    0x7F, 0x10, 0x28, 0x44, 0x00, // 0x6B k
+    0x00, 0x41, 0x7F, 0x40, 0x00, // 0x6C l
+    0x7C, 0x04, 0x18, 0x04, 0x78, // 0x6D m
+    0x7C, 0x08, 0x04, 0x04, 0x78, // 0x6E n
+    0x38, 0x44, 0x44, 0x44, 0x38, // 0x6F o
+    0x7C, 0x14, 0x14, 0x14, 0x08, // 0x70 p
+    0x08, 0x14, 0x14, 0x18, 0x7C, // 0x71 q
+    0x7C, 0x08, 0x04, 0x04, 0x08, // 0x72 r
+    0x48, 0x54, 0x54, 0x54, 0x20, // 0x73 s
+    0x04, 0x3F, 0x44, 0x40, 0x20, // 0x74 t
+    0x3C, 0x40, 0x40, 0x20, 0x7C, // 0x75 u
+    0x1C, 0x20, 0x40, 0x20, 0x1C, // 0x76 v
+    0x3C, 0x40, 0x30, 0x40, 0x3C, // 0x77 w
+    0x44, 0x28, 0x10, 0x28, 0x44, // 0x78 x
+    0x0C, 0x50, 0x50, 0x50, 0x3C, // 0x79 y
+    0x44, 0x64, 0x54, 0x4C, 0x44, // 0x7A z
+    0x00, 0x08, 0x36, 0x41, 0x00, // 0x7B {
+    0x00, 0x00, 0x7F, 0x00, 0x00, // 0x7C |
+    0x00, 0x41, 0x36, 0x08, 0x00, // 0x7D }
+    0x08, 0x04, 0x08, 0x10, 0x08, // 0x7E ~
+    0x7F, 0x7F, 0x7F, 0x7F, 0x7F, // 0x7F block
+};
+
+// Constructor
+VideoMirrorScreen::VideoMirrorScreen()
+{
+    _drawn = nullptr;
+    _glyphs = nullptr;
+
+    _hasLowerCaseMod = false;
+    _wide = false;
+    _redraw = true;
+    _cellWidth = 0;
+    _cellHeight = 0;
+    _left = 0;
+    _top = 0;
+    _row = VIDEO_ROWS;
+    _lastPoll = 0;
+
+    setTitleF(F("Model 1 Screen"));
+
+    const char *buttons[] = {"Sel:Redraw"};
+    setButtonItems(buttons, 1);
+}
+
+// Destructor
+VideoMirrorScreen::~VideoMirrorScreen()
+{
+    _freeBuffers();
+}
+
+// Set whether lowercase modification is available; without it 0x60-0x7F show as upper-case
+void VideoMirrorScreen::setLowerCaseMod(bool hasLowerCaseMod)
+{
+    _hasLowerCaseMod = hasLowerCaseMod;
+
+    // Start a new pass that draws all cells
+    _redraw = true;
+    _row = VIDEO_ROWS;
+    _lastPoll = millis() - VIDEO_MIRROR_SCREEN_UPDATE_MS;
+}
+
+// Allocate the drawn copy and start polling right away
+bool VideoMirrorScreen::open()
+{
+    if (!_drawn)
+        _drawn = (uint8_t *)MemoryDiagnostics.allocate(VIDEO_COLS * VIDEO_ROWS, MEMORY_TAG_VIDEO);
+
+    _row = VIDEO_ROWS;
+    _lastPoll = millis() - VIDEO_MIRROR_SCREEN_UPDATE_MS;
+    return ContentScreen::open();
+}
+
+// Free the buffers while the screen is not shown
+void VideoMirrorScreen::close()
+{
+    ContentScreen::close();
+    _freeBuffers();
+}
+
+// Release the glyph cache and the drawn copy
+void VideoMirrorScreen::_freeBuffers()
+{
+    if (_glyphs)
+    {
+        MemoryDiagnostics.release(_glyphs, MEMORY_TAG_VIDEO);
+        _glyphs = nullptr;
+    }
+    if (_drawn)
+    {
+        MemoryDiagnostics.release(_drawn, MEMORY_TAG_VIDEO);
+        _drawn = nullptr;
+    }
+}
+
+// ----------------------------------------
+// ---------- Glyph cache
+// ----------------------------------------
+
+// Dots of a glyph shown by one pixel: a whole multiple of the Model 1 cell where it fits, the glyph without spacing
+// where only that fits, and all dots merged into fewer pixels otherwise so thin strokes do not disappear
+static void _getDots(uint8_t pixel, uint8_t pixels, uint8_t cellDots, uint8_t glyphDots, uint8_t &first, uint8_t &last)
+{
+    if (pixels >= cellDots)
+    {
+        first = last = pixel / (pixels / cellDots);
+    }
+    else if (pixels >= glyphDots)
+    {
+        first = last = pixel;
+    }
+    else
+    {
+        first = pixel * glyphDots / pixels;
+        last = ((pixel + 1) * glyphDots - 1) / pixels;
+    }
+}
+
+// Fit the cells into the content area and scale the character set to the cell size
+bool VideoMirrorScreen::_layout()
+{
+    M1_PROFILE("VideoMirrorScreen::layout");
+
+    if (_glyphs)
+    {
+        MemoryDiagnostics.release(_glyphs, MEMORY_TAG_VIDEO);
+        _glyphs = nullptr;
+    }
+
+    uint8_t columns = _wide ? VIDEO_COLS / 2 : VIDEO_COLS;
+    uint8_t maxWidth = _wide ? 2 * VIDEO_MIRROR_MAX_CELL_WIDTH : VIDEO_MIRROR_MAX_CELL_WIDTH;
+    uint16_t width = _getContentWidth() / columns;
+    uint16_t height = _getContentHeight() / VIDEO_ROWS;
+
+    _cellWidth = width > maxWidth ? maxWidth : width;
+    _cellHeight = height > VIDEO_MIRROR_MAX_CELL_HEIGHT ? VIDEO_MIRROR_MAX_CELL_HEIGHT : height;
+    if (_cellWidth < VIDEO_MIRROR_MIN_CELL_WIDTH || _cellHeight < VIDEO_MIRROR_MIN_CELL_HEIGHT)
+        return false;
+
+    _left = _getContentLeft() + (_getContentWidth() - columns * _cellWidth) / 2;
+    _top = _getContentTop() + (_getContentHeight() - VIDEO_ROWS * _cellHeight) / 2;
+
+    uint8_t bytesPerLine = (_cellWidth + 7) / 8;
+    uint16_t glyphSize = bytesPerLine * _cellHeight;
+    _glyphs = (uint8_t *)MemoryDiagnostics.allocate(VIDEO_MIRROR_GLYPHS * glyphSize + 4 * bytesPerLine, MEMORY_TAG_VIDEO);
+    if (!_glyphs)
+        return false;
+    memset(_glyphs, 0, VIDEO_MIRROR_GLYPHS * glyphSize + 4 * bytesPerLine);
+
+    // Scale the character set to the display cell
+    for (uint8_t glyph = 0; glyph < VIDEO_MIRROR_GLYPHS; glyph++)
+    {
+        uint8_t *bitmap = _glyphs + glyph * glyphSize;
+        for (uint8_t y = 0; y < _cellHeight; y++)
+        {
+            uint8_t firstLine, lastLine;
+            _getDots(y, _cellHeight, VIDEO_MIRROR_SOURCE_HEIGHT, 7, firstLine, lastLine);
+            if (firstLine >= 7)
+                break;
+            uint8_t lines = (0xFF << firstLine) & ~(0xFE << lastLine);
+
+            for (uint8_t x = 0; x < _cellWidth; x++)
+            {
+                uint8_t firstDot, lastDot;
+                _getDots(x, _cellWidth, VIDEO_MIRROR_SOURCE_WIDTH, 5, firstDot, lastDot);
+                for (uint8_t dot = firstDot; dot <= lastDot && dot < 5; dot++)
+                {
+                    if (pgm_read_byte(&VIDEO_MIRROR_FONT[glyph * 5 + dot]) & lines)
+                    {
+                        bitmap[y * bytesPerLine + x / 8] |= 0x80 >> (x % 8);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Lines of the semigraphics blocks: bit 0 sets the left, bit 1 the right half
+    uint8_t *blocks = _glyphs + VIDEO_MIRROR_GLYPHS * glyphSize;
+    for (uint8_t pattern = 0; pattern < 4; pattern++)
+    {
+        for (uint8_t x = 0; x < _cellWidth; x++)
+        {
+            uint8_t half = x * VIDEO_MIRROR_SOURCE_WIDTH / _cellWidth < VIDEO_MIRROR_SOURCE_WIDTH / 2 ? 1 : 2;
+            if (pattern & half)
+                blocks[pattern * bytesPerLine + x / 8] |= 0x80 >> (x % 8);
+        }
+    }
+
+    _redraw = true;
+    return true;
+}
+
+// ----------------------------------------
+// ---------- Polling
+// ----------------------------------------
+
+// Read the 32/64 character mode from port 0xFF; true if it changed
+bool VideoMirrorScreen::_readMode()
+{
+    bool claimed = !Model1.hasActiveTestSignal();
+    if (claimed)
+        Model1.activateTestSignal();
+
+    bool wide = !_cassette.is64CharacterMode();
+
+    if (claimed)
+        Model1.deactivateTestSignal();
+
+    if (wide == _wide)
+        return false;
+
+    _wide = wide;
+    return true;
+}
+
+// Read one row holding TEST* only for the row, then draw the cells that differ from the display
+void VideoMirrorScreen::_pollRow(uint8_t row)
+{
+    uint8_t data[VIDEO_COLS];
+
+    bool claimed = !Model1.hasActiveTestSignal();
+    if (claimed)
+        Model1.activateTestSignal();
+
+    Model1.readMemoryInto(VIDEO_MEM_START + row * VIDEO_COLS, data, VIDEO_COLS);
+
+    if (claimed)
+        Model1.deactivateTestSignal();
+
+    // In 32 character mode only the even columns are shown
+    uint8_t step = _wide ? 2 : 1;
+    uint8_t *drawn = _drawn + row * VIDEO_COLS;
+    for (uint8_t column = 0; column < VIDEO_COLS; column += step)
+    {
+        if (_redraw || drawn[column] != data[column])
+        {
+            drawn[column] = data[column];
+            _drawCell(column / step, row, data[column]);
+        }
+    }
+}
+
+// Draw a character from the glyph cache, or compose a 2x3 semigraphics block from its cached lines
+void VideoMirrorScreen::_drawCell(uint8_t column, uint8_t row, uint8_t data)
+{
+    uint8_t bytesPerLine = (_cellWidth + 7) / 8;
+    uint16_t glyphSize = bytesPerLine * _cellHeight;
+    uint8_t bitmap[2 * VIDEO_MIRROR_MAX_CELL_HEIGHT];
+
+    if (data & 0x80)
+    {
+        // Bits 0-5 set the blocks from top left to bottom right
+        uint8_t *blocks = _glyphs + VIDEO_MIRROR_GLYPHS * glyphSize;
+        for (uint8_t y = 0; y < _cellHeight; y++)
+        {
+            uint8_t block = y * VIDEO_MIRROR_SOURCE_HEIGHT / _cellHeight / 4;
+            uint8_t pattern = (data >> (2 * block)) & 0x03;
+            memcpy(bitmap + y * bytesPerLine, blocks + pattern * bytesPerLine, bytesPerLine);
+        }
+    }
+    else
+    {
+        // 0x00-0x1F show as 0x40-0x5F; without the lowercase mod, 0x60-0x7F show as 0x40-0x5F too
+        uint8_t character = data < 0x20 ? data + 0x40 : data;
+        if (!_hasLowerCaseMod && character >= 0x60)
+            character -= 0x20;
+        memcpy(bitmap, _glyphs + (character - 0x20) * glyphSize, glyphSize);
+    }
+
+    M1Shield.getGFX().drawBitmap(_left + column * _cellWidth, _top + row * _cellHeight, bitmap, _cellWidth, _cellHeight,
+                                 M1Shield.convertColor(VIDEO_MIRROR_COLOR_FG), M1Shield.convertColor(VIDEO_MIRROR_COLOR_BG));
+}
+
+// Start a pass every VIDEO_MIRROR_SCREEN_UPDATE_MS and poll a few rows per call
+void VideoMirrorScreen::loop()
+{
+    ContentScreen::loop();
+
+    if (!isActive() || !_drawn)
+        return;
+
+    if (_row >= VIDEO_ROWS)
+    {
+        if (millis() - _lastPoll < VIDEO_MIRROR_SCREEN_UPDATE_MS)
+            return;
+        _lastPoll = millis();
+        _row = 0;
+
+        // The mode changes the cell size, so the glyphs are scaled again
+        if (_readMode())
+        {
+            clearContentArea();
+            _layout();
+        }
+    }
+
+    if (!_glyphs)
+    {
+        _row = VIDEO_ROWS;
+        return;
+    }
+
+    M1_PROFILE("VideoMirrorScreen::poll");
+
+    Adafruit_GFX &gfx = M1Shield.getGFX();
+    gfx.startWrite();
+    for (uint8_t i = 0; i < VIDEO_MIRROR_SCREEN_ROWS_PER_LOOP && _row < VIDEO_ROWS; i++)
+    {
+        _pollRow(_row++);
+    }
+    gfx.endWrite();
+
+    if (_row >= VIDEO_ROWS)
+    {
+        _redraw = false;
+        M1Shield.display();
+    }
+}
+
+// Prepare the layout; the cells are drawn by the next passes of loop()
+void VideoMirrorScreen::_drawContent()
+{
+    if (!_drawn)
+    {
+        drawTextF(0, 0, F("Not enough memory"), 0xF800, 1);
+        return;
+    }
+
+    if (!_layout())
+    {
+        if (_cellWidth < VIDEO_MIRROR_MIN_CELL_WIDTH || _cellHeight < VIDEO_MIRROR_MIN_CELL_HEIGHT)
+            drawTextF(0, 0, F("Display too small"), 0xF800, 1);
+        else
+            drawTextF(0, 0, F("Not enough memory"), 0xF800, 1);
+        return;
+    }
+
+    _row = VIDEO_ROWS;
+    _lastPoll = millis() - VIDEO_MIRROR_SCREEN_UPDATE_MS;
+}
+
+// Select draws all cells again
+Screen *VideoMirrorScreen::actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY)
+{
+    (void)offsetX; // Parameter not used
+    (void)offsetY; // Parameter not used
+
+    if (!isActive())
+        return nullptr;
+
+    if (action & (BUTTON_SELECT | BUTTON_JOYSTICK))
+    {
+        refresh();
+        return nullptr;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,65 @@
+/*
+ * VideoMirrorScreen.h - ContentScreen mirroring the Model 1 text screen onto the shield display
+ * Authors: Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef VIDEOMIRRORSCREEN_H
+#define VIDEOMIRRORSCREEN_H
+
+#include <Arduino.h>
+#include "ContentScreen.h"
+#include "Cassette.h"
+#include "Video.h"
+
+// Interval between two polls of video RAM
+#ifndef VIDEO_MIRROR_SCREEN_UPDATE_MS
+#define VIDEO_MIRROR_SCREEN_UPDATE_MS 100
+#endif
+
+// Rows of video RAM read and drawn per pass of loop(); TEST* is held for one row at a time
+#ifndef VIDEO_MIRROR_SCREEN_ROWS_PER_LOOP
+#define VIDEO_MIRROR_SCREEN_ROWS_PER_LOOP 4
+#endif
+
+// Shows video RAM (0x3C00-0x3FFF) in 64 or 32 character mode, redrawing only cells that changed
+class VideoMirrorScreen : public ContentScreen
+{
+private:
+    Cassette _cassette; // Reads the 32/64 character mode from port 0xFF
+
+    uint8_t *_drawn;  // Video RAM as drawn on the display
+    uint8_t *_glyphs; // Text glyphs scaled to the cell size, followed by the semigraphics lines
+
+    bool _hasLowerCaseMod;   // True if lowercase modification is available
+    bool _wide;              // True in 32 character mode
+    bool _redraw;            // Draw all cells in the current pass
+    uint8_t _cellWidth;      // Width of a character cell in pixels
+    uint8_t _cellHeight;     // Height of a character cell in pixels
+    uint16_t _left;          // X coordinate of the first cell
+    uint16_t _top;           // Y coordinate of the first cell
+    uint8_t _row;            // Next row to poll, VIDEO_ROWS while waiting for the next pass
+    unsigned long _lastPoll; // Time the last pass started
+
+    bool _layout();                                            // Compute the cell size and build the glyph cache for the current mode
+    void _freeBuffers();                                       // Release the glyph cache and the drawn copy
+    bool _readMode();                                          // Read the character mode; true if it changed
+    void _pollRow(uint8_t row);                                // Read one row and draw the cells that changed
+    void _drawCell(uint8_t column, uint8_t row, uint8_t data); // Draw one character cell
+
+public:
+    VideoMirrorScreen();  // Constructor, sets title and button items
+    ~VideoMirrorScreen(); // Destructor, frees the buffers
+
+    void setLowerCaseMod(bool hasLowerCaseMod); // Set whether lowercase modification is available
+
+    bool open() override;  // Allocate buffers and start polling
+    void close() override; // Free buffers
+    void loop() override;  // Poll a few rows per pass
+    Screen *actionTaken(ActionTaken action, int8_t offsetX, int8_t offsetY) override;
+
+protected:
+    void _drawContent() override; // Prepare the layout; cells are drawn by loop()
+};
+
+#endif /* VIDEOMIRRORSCREEN_H */
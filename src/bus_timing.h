@@ -0,0 +1,104 @@
+/*
+ * bus_timing.h - Compile-time bus cycle timing derived from F_CPU
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef BUS_TIMING_H
+#define BUS_TIMING_H
+
+#include <Arduino.h>
+
+/**
+ * All bus cycle delays are given in nanoseconds and converted to CPU cycles at
+ * compile time. Each delay compiles to the shortest instruction sequence that
+ * waits at least that long on the target clock, so boards with a different
+ * F_CPU need no hand-tuned delays.
+ *
+ * Every value can be overridden with a build flag, e.g. in platformio.ini:
+ *   build_flags = -DM1_READ_ACCESS_NS=700
+ */
+
+// ---------- DRAM (4116, 250ns grade - the slowest grade found in Model I boards)
+
+#ifndef M1_DRAM_T_RAS_NS
+#define M1_DRAM_T_RAS_NS 250 // Minimum RAS pulse width
+#endif
+
+#ifndef M1_DRAM_T_CAS_NS
+#define M1_DRAM_T_CAS_NS 165 // Minimum CAS pulse width
+#endif
+
+#ifndef M1_DRAM_T_RP_NS
+#define M1_DRAM_T_RP_NS 150 // Minimum RAS precharge time
+#endif
+
+#ifndef M1_DRAM_RETENTION_US
+#define M1_DRAM_RETENTION_US 2000 // Longest time a row may go without refresh (128 rows in 2 ms)
+#endif
+
+// ---------- Z80 (1.774 MHz)
+
+#ifndef M1_Z80_T_STATE_NS
+#define M1_Z80_T_STATE_NS 564 // Length of one Z80 clock cycle
+#endif
+
+// ---------- Model I bus cycles
+
+#ifndef M1_READ_ACCESS_NS
+#define M1_READ_ACCESS_NS 772 // CAS to valid data, covering ROM access and the board's data buffers
+#endif
+
+#ifndef M1_WRITE_ROW_SETUP_NS
+#define M1_WRITE_ROW_SETUP_NS 375 // RAS to column strobe on writes, letting the address multiplexer settle
+#endif
+
+#ifndef M1_WRITE_PULSE_NS
+#define M1_WRITE_PULSE_NS 250 // WR and CAS low time on writes
+#endif
+
+#ifndef M1_IO_WRITE_PULSE_NS
+#define M1_IO_WRITE_PULSE_NS 250 // OUT and CAS low time on I/O writes
+#endif
+
+#ifndef M1_INTERRUPT_VECTOR_HOLD_NS
+#define M1_INTERRUPT_VECTOR_HOLD_NS 772 // Interrupt vector hold time around releasing INT
+#endif
+
+#ifndef M1_TEST_SETTLE_NS
+#define M1_TEST_SETTLE_NS (7 * M1_Z80_T_STATE_NS) // Bus release after TEST; the Z80 needs 5 T-states, 2 are margin
+#endif
+
+// ---------- Conversion
+
+// Number of CPU cycles needed to wait at least the given number of nanoseconds
+constexpr uint32_t busCycles(uint32_t nanoseconds)
+{
+    return (nanoseconds * (F_CPU / 1000000UL) + 999UL) / 1000UL;
+}
+
+// Wait for an exact number of CPU cycles
+template <uint32_t Cycles>
+static inline __attribute__((always_inline)) void busDelayCycles()
+{
+#if defined(__AVR__)
+    if (Cycles > 0)
+        __builtin_avr_delay_cycles(Cycles);
+#elif defined(M1_HOST)
+    if (Cycles > 0)
+        hostDelayCycles(Cycles); // Simulated clock of the host backend (extras/host)
+#endif
+}
+
+// Wait at least the given number of nanoseconds
+template <uint32_t Nanoseconds>
+static inline __attribute__((always_inline)) void busDelay()
+{
+    busDelayCycles<busCycles(Nanoseconds)>();
+}
+
+// The instructions between RAS going high and the next RAS going low (at least
+// four port writes) have to cover the RAS precharge time
+static_assert(busCycles(M1_DRAM_T_RP_NS) <= 8, "RAS precharge needs an explicit delay at this F_CPU");
+
+#endif /* BUS_TIMING_H */
@@ -0,0 +1,90 @@
+/*
+ * cycle_counter.cpp - Free-running 32-bit CPU cycle counter on timer 5
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#include "cycle_counter.h"
+
+#if defined(M1_CYCLE_COUNTER)
+
+static volatile uint16_t overflows = 0; // Upper 16 bits of the counter
+static uint8_t users = 0;               // Number of cycleCounterBegin() without cycleCounterEnd()
+
+// Extends timer 5 to 32 bits
+ISR(TIMER5_OVF_vect)
+{
+    overflows++;
+}
+
+// Start timer 5 in normal mode with prescaler 1
+bool cycleCounterBegin()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+
+    if (users++ == 0)
+    {
+        TCCR5A = 0;
+        TCCR5B = 0;
+        TCNT5 = 0;
+        overflows = 0;
+        TIFR5 = (1 << TOV5);
+        TIMSK5 |= (1 << TOIE5);
+        TCCR5B |= (1 << CS50);
+    }
+
+    SREG = oldSREG;
+    return true;
+}
+
+// Stop timer 5 once no one uses it anymore
+void cycleCounterEnd()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+
+    if (users > 0 && --users == 0)
+    {
+        TCCR5B = 0;
+        TIMSK5 &= ~(1 << TOIE5);
+    }
+
+    SREG = oldSREG;
+}
+
+// Read timer 5 extended by the overflow count; also valid with interrupts disabled
+uint32_t cycleCounterRead()
+{
+    uint8_t oldSREG = SREG;
+    noInterrupts();
+
+    uint16_t count = TCNT5;
+    uint16_t high = overflows;
+
+    // An overflow is pending but not yet counted by the ISR
+    if ((TIFR5 & (1 << TOV5)) && count < 0x8000)
+        high++;
+
+    SREG = oldSREG;
+    return ((uint32_t)high << 16) | count;
+}
+
+#else
+
+// Timer 5 is left to the sketch
+bool cycleCounterBegin()
+{
+    return false;
+}
+
+void cycleCounterEnd()
+{
+}
+
+uint32_t cycleCounterRead()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * cycle_counter.h - Free-running 32-bit CPU cycle counter on timer 5
+ * Authors: Ven Reddy, Marcel Erz (RetroStack)
+ * Released under the MIT License.
+ */
+
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <Arduino.h>
+
+/**
+ * Timer 5 runs at the CPU clock in normal mode, its overflow interrupt counts
+ * the upper 16 bits. The counter is shared by BusTrace and Profiler and runs
+ * while at least one of them uses it.
+ *
+ * The timer and its interrupt are only claimed when the library is built with
+ * M1_BUS_TRACE or M1_PROFILING; otherwise cycleCounterBegin() fails and timer 5
+ * stays free for the sketch.
+ */
+
+#if defined(M1_BUS_TRACE) || defined(M1_PROFILING)
+#define M1_CYCLE_COUNTER
+#endif
+
+bool cycleCounterBegin();    // Start the counter (reference counted)
+void cycleCounterEnd();      // Release the counter; stops when the last user released it
+uint32_t cycleCounterRead(); // CPU cycles, wraps after 2^32 (268 s at 16 MHz)
+
+#endif // CYCLE_COUNTER_H
@@ -62,6 +62,28 @@ char busStatus(uint8_t value)
   }
 }
 
+// Update a CRC-16/CCITT-FALSE with one byte
+uint16_t crc16Update(uint16_t crc, uint8_t data)
+{
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+  }
+  return crc;
+}
+
+// Update a CRC-32 (IEEE 802.3, as used by zip and SD tools) with one byte
+uint32_t crc32Update(uint32_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320UL) : (crc >> 1);
+  }
+  return crc;
+}
+
 // Precise nanosecond delay using inline assembly for 16MHz ATMega
 // 1 cycle = 62.5 ns, each loop iteration = 4 cycles except final (3 cycles)
 // Total cycles = (wait - 1)*4 + 3 = 4*wait -1 cycles
@@ -79,6 +101,9 @@ void asmWait(uint16_t wait)
 {
   if (wait == 0)
     return;
+#if defined(M1_HOST)
+  hostDelayCycles(4 * wait + 3); // Simulated clock of the host backend (extras/host)
+#else
   __asm__ volatile(
       " mov r16,%0\n" // set wait countdown
       "1: nop\n"      // noop
@@ -88,6 +113,7 @@ void asmWait(uint16_t wait)
       : "r"(wait) // input operands if any, here
       : "r16"     // clobbered regs here
   );
+#endif
 }
 
 /**
@@ -155,6 +181,9 @@ void asmWait(uint16_t wait)
  */
 void asmWait(uint16_t outerLoopCount, uint16_t innerLoopCount)
 {
+#if defined(M1_HOST)
+  hostDelayCycles((uint32_t)outerLoopCount * (4UL * innerLoopCount + 3) + 6); // Simulated clock of the host backend
+#else
   asm volatile(
       "outer_loop_start: \n\t"                   // Outer loop start label
       "movw r24, %A0 \n\t"                       // Copy outer loop count to r24:r25
@@ -169,4 +198,5 @@ void asmWait(uint16_t outerLoopCount, uint16_t innerLoopCount)
       : "r"(outerLoopCount), "r"(innerLoopCount) // Inputs
       : "r24", "r25", "r26", "r27"               // Clobbers
   );
+#endif
 }
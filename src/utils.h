@@ -14,14 +14,22 @@
  *   - 16 MHz CPU: 62.5 ns
  *   - Each nop = 62.5 ns
  */
+#if defined(M1_HOST)
+#define asmShortNoop() hostDelayCycles(1)
+#else
 #define asmShortNoop() __asm__ __volatile__("nop")
+#endif
 
 /**
  * Wait for exactly 2 CPU cycles (2x nop), total delay:
  *   - 16 MHz CPU: 125 ns
  *   - Each nop = 62.5 ns
  */
+#if defined(M1_HOST)
+#define asmNoop() hostDelayCycles(2)
+#else
 #define asmNoop() __asm__ __volatile__("nop\nnop")
+#endif
 
 char *uint8ToBinary(uint8_t value, char *buffer);   // Convert 8-bit value to binary string representation
 char *uint16ToBinary(uint16_t value, char *buffer); // Convert 16-bit value to binary string representation
@@ -29,6 +37,9 @@ char *uint16ToBinary(uint16_t value, char *buffer); // Convert 16-bit value to b
 char pinStatus(bool value);    // Get pin status character ('o' for output, 'i' for input)
 char busStatus(uint8_t value); // Get bus status character ('o' for output, 'i' for input, '?' for unknown)
 
+uint16_t crc16Update(uint16_t crc, uint8_t data); // Update CRC-16/CCITT-FALSE (poly 0x1021, start with 0xFFFF) with one byte
+uint32_t crc32Update(uint32_t crc, uint8_t data); // Update CRC-32 (reflected poly 0xEDB88320, start with 0xFFFFFFFF, invert result) with one byte
+
 void asmWait(uint16_t wait);                                    // Precise nanosecond delay using inline assembly (16MHz ATMega)
 void asmWait(uint16_t outerLoopCount, uint16_t innerLoopCount); // Nested loop delay for longer durations using inline assembly
 